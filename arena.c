@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include "arena.h"
+
+// ### CONSTANT DEFINITIONS ### //
+#define ARENA_ALIGNMENT 16
+
+// ### FUNCTION DEFINITIONS ### //
+
+// # CREATE AND DESTROY FUNCTIONS # //
+Arena *create_arena(size_t capacity) {
+	// Header and memory block in a single allocation
+	size_t header_size = (sizeof(Arena) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+	Arena *arena = malloc(header_size + capacity);
+	if (!arena) {
+		return NULL;
+	}
+	
+	arena->memory = (unsigned char*)arena + header_size;
+	arena->capacity = capacity;
+	arena->offset = 0;
+	arena->high_water_mark = 0;
+	return arena;
+}
+
+void destroy_arena(Arena **arena) {
+	if (!arena) {
+		return;
+	}
+	
+	free(*arena);
+	*arena = NULL;
+}
+
+// # ALLOCATION # //
+void *arena_alloc(Arena *arena, size_t size) {
+	if (!arena) {
+		return NULL;
+	}
+	
+	size_t start = (arena->offset + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+	if (start > arena->capacity || size > arena->capacity - start) {
+		return NULL;
+	}
+	
+	arena->offset = start + size;
+	if (arena->offset > arena->high_water_mark) {
+		arena->high_water_mark = arena->offset;
+	}
+	return arena->memory + start;
+}
+
+size_t arena_remaining(const Arena *arena) {
+	if (!arena) {
+		return 0;
+	}
+	
+	size_t start = (arena->offset + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+	return start < arena->capacity ? arena->capacity - start : 0;
+}
+
+void arena_reset(Arena *arena) {
+	if (arena) {
+		arena->offset = 0;
+	}
+}
+
+size_t arena_mark(const Arena *arena) {
+	return arena ? arena->offset : 0;
+}
+
+void arena_rewind(Arena *arena, size_t mark) {
+	if (arena && mark < arena->offset) {
+		arena->offset = mark;
+	}
+}
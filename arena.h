@@ -0,0 +1,34 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// ### STRUCTS ### //
+// Linear allocator for memory that only lives for one frame
+// Allocations are never freed individually, the whole arena is reset at once
+typedef struct {
+	unsigned char *memory;
+	size_t capacity;
+	size_t offset;
+	// Largest offset reached since creation, for sizing the arena
+	size_t high_water_mark;
+} Arena;
+
+// ### FUNCTION DECLARATIONS ### //
+// # CREATE AND DESTROY FUNCTIONS # //
+// The only heap allocation, done once, the arena never grows afterwards
+Arena *create_arena(size_t capacity);
+void destroy_arena(Arena **arena);
+
+// # ALLOCATION # //
+// Returns 16-byte aligned memory or NULL when the arena is exhausted
+void *arena_alloc(Arena *arena, size_t size);
+// Largest allocation that would still succeed
+size_t arena_remaining(const Arena *arena);
+void arena_reset(Arena *arena);
+// Frees everything allocated since arena_mark returned mark
+size_t arena_mark(const Arena *arena);
+void arena_rewind(Arena *arena, size_t mark);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,1206 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include "graphics.h"
+#include "tiler.h"
+#include "framebuffer.h"
+#include "scene.h"
+#include "loader.h"
+
+// ### CONSTANTS ### //
+// Every configuration runs for at least this long
+const double MIN_BENCH_SECONDS = 0.25;
+const int TRIANGLES_PER_SET = 256;
+const size_t BENCH_ARENA_SIZE = 128 * 1024 * 1024;
+// Independent operations per timed pass of the micro benchmarks
+const int MICRO_BATCH = 4096;
+const int LINES_PER_SET = 1024;
+const int SCENE_INSTANCES = 100000;
+// Cubes in the instancing benchmark, all in view
+const int DRAW_INSTANCES = 10000;
+// Filled icosahedra in the solid benchmark, overlapping in view
+const int SOLID_COUNT = 500;
+// Spheres in the level of detail benchmark, spread from near the camera to far away
+const int LOD_OBJECTS = 1000;
+const int LOD_LEVELS = 6;
+// Sphere written to and loaded from each file format, about 260k triangles
+const int LOAD_RINGS = 256;
+const int LOAD_SEGMENTS = 512;
+// Instances are scattered through a cube this wide around the camera
+const float SCENE_EXTENT = 1000.0f;
+
+// ### STRUCTS ### //
+typedef struct {
+	const char *name;
+	int width;
+	int height;
+} BenchTarget;
+
+typedef struct {
+	const char *name;
+	// Approximate edge length in pixels
+	float size;
+} BenchTriangleSize;
+
+// Keeps the results of the micro benchmarks alive
+static volatile float bench_sink;
+
+// ### FUNCTION DEFINITIONS ### //
+static double seconds_since(Uint64 start) {
+	return (double)(SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+// Small deterministic generator so every run measures the same triangles
+static float random_unit(Uint32 *state) {
+	*state = *state * 1664525u + 1013904223u;
+	return (float)(*state >> 8) / 16777216.0f;
+}
+
+static float random_range(Uint32 *state, float min, float max) {
+	return min + (max - min) * random_unit(state);
+}
+
+static void random_triangles(Triangle *triangles, int count, BenchTarget target, float size, Uint32 seed) {
+	for (int i = 0; i < count; i++) {
+		float center_x = random_unit(&seed) * target.width;
+		float center_y = random_unit(&seed) * target.height;
+		for (int j = 0; j < 3; j++) {
+			triangles[i].vertices[j] = (Vec3){
+				center_x + (random_unit(&seed) - 0.5f) * size,
+				center_y + (random_unit(&seed) - 0.5f) * size,
+				0.0f
+			};
+		}
+	}
+}
+
+// Covered pixels inside the target, so every path is credited with the same work
+static long count_covered_pixels(const TriangleSetup *setup, BenchTarget target) {
+	long count = 0;
+	for (int y = setup->min_y > 0 ? setup->min_y : 0; y <= setup->max_y && y < target.height; y++) {
+		for (int x = setup->min_x > 0 ? setup->min_x : 0; x <= setup->max_x && x < target.width; x++) {
+			Sint64 w0 = setup->edge_a[0] * x + setup->edge_b[0] * y + setup->edge_c[0];
+			Sint64 w1 = setup->edge_a[1] * x + setup->edge_b[1] * y + setup->edge_c[1];
+			Sint64 w2 = setup->edge_a[2] * x + setup->edge_b[2] * y + setup->edge_c[2];
+			count += (w0 | w1 | w2) >= 0;
+		}
+	}
+	return count;
+}
+
+// One CSV row; ops is what ns_per_op divides by (a call, a point or a frame)
+static void print_result(const char *benchmark, const char *target, const char *variant, const char *path, long iterations, long ops, long pixels, long primitives, double seconds) {
+	printf("%s,%s,%s,%s,%ld,%ld,%ld,%ld,%.6f,%.2f,%.0f,%.0f\n", benchmark, target, variant, path, iterations, ops, pixels, primitives, seconds, seconds * 1e9 / ops, pixels / seconds, primitives / seconds);
+}
+
+// ## MICRO BENCHMARKS ## //
+static Matrix4 random_matrix(Uint32 *state) {
+	Matrix4 m;
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++) {
+			m.m[row][col] = random_range(state, -1.0f, 1.0f);
+		}
+	}
+	return m;
+}
+
+static void bench_mat4_mul(Matrix4 *a, Matrix4 *b) {
+	long iterations = 0;
+	float sum = 0.0f;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < MICRO_BATCH; i++) {
+			sum += mat4_mul(a[i], b[i]).m[3][3];
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	
+	bench_sink = sum;
+	print_result("linalg", "-", "-", "mat4_mul", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+}
+
+static void bench_mat4_vec4_mul(Matrix4 m, Vec4 *points) {
+	long iterations = 0;
+	float sum = 0.0f;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < MICRO_BATCH; i++) {
+			sum += mat4_vec4_mul(m, points[i]).w;
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	
+	bench_sink = sum;
+	print_result("linalg", "-", "-", "mat4_vec4_mul", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+}
+
+// Per-object rotation matrices from Euler angles and from quaternions,
+// and interpolation between two orientations
+static void bench_rotations(const Vec3 *angles, const Quat *quats, Matrix4 *out) {
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < MICRO_BATCH; i++) {
+			out[i] = mat4_mul(rotation_zaxis(angles[i].z), mat4_mul(rotation_yaxis(angles[i].y), rotation_xaxis(angles[i].x)));
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = out[MICRO_BATCH - 1].m[0][0];
+	print_result("linalg", "-", "-", "euler_to_mat4", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		quat_to_mat4_batch(quats, out, MICRO_BATCH);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = out[MICRO_BATCH - 1].m[0][0];
+	print_result("linalg", "-", "-", "quat_to_mat4_batch", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	// The second half of quats holds the targets
+	iterations = 0;
+	float sum = 0.0f;
+	start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < MICRO_BATCH; i++) {
+			sum += quat_nlerp(quats[i], quats[MICRO_BATCH + i], 0.3f).w;
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = sum;
+	print_result("linalg", "-", "-", "quat_nlerp", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	iterations = 0;
+	sum = 0.0f;
+	start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < MICRO_BATCH; i++) {
+			sum += quat_slerp(quats[i], quats[MICRO_BATCH + i], 0.3f).w;
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = sum;
+	print_result("linalg", "-", "-", "quat_slerp", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+}
+
+// Structure of arrays batch operations, once per kernel
+static void bench_soa_kernel(LinalgKernel kernel, const char *kernel_name, const Matrix4 *m, float *soa[7]) {
+	if (!linalg_kernel_supported(kernel)) {
+		printf("# %s linalg kernel not supported on this CPU\n", kernel_name);
+		return;
+	}
+	set_linalg_kernel(kernel);
+	
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		mat4_transform_points_soa(m, soa[0], soa[1], soa[2], soa[3], soa[4], soa[5], soa[6], MICRO_BATCH);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = soa[6][MICRO_BATCH - 1];
+	print_result("linalg", "-", kernel_name, "mat4_transform_points_soa", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		vec3_normalize_soa(soa[0], soa[1], soa[2], soa[3], soa[4], soa[5], MICRO_BATCH);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = soa[5][MICRO_BATCH - 1];
+	print_result("linalg", "-", kernel_name, "vec3_normalize_soa", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		vec3_dot_soa(soa[0], soa[1], soa[2], soa[3], soa[4], soa[5], soa[6], MICRO_BATCH);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = soa[6][MICRO_BATCH - 1];
+	print_result("linalg", "-", kernel_name, "vec3_dot_soa", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+}
+
+// Per point, batched, and into clip space with the outcodes
+static void bench_world_to_viewport(RenderContext *ctx, Vec3 *points, Vec3 *viewport_points, ClipVertex *clip_points) {
+	long iterations = 0;
+	float sum = 0.0f;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < MICRO_BATCH; i++) {
+			sum += world_to_viewport(ctx, vec3_homogenous(points[i], 1.0f)).x;
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = sum;
+	print_result("transform", "-", "-", "world_to_viewport", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		world_to_viewport_batch(ctx, points, viewport_points, MICRO_BATCH);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = viewport_points[MICRO_BATCH - 1].x;
+	print_result("transform", "-", "-", "world_to_viewport_batch", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		transform_vertices(ctx, points, clip_points, MICRO_BATCH);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	bench_sink = clip_points[MICRO_BATCH - 1].clip.w;
+	print_result("transform", "-", "-", "transform_vertices", iterations, iterations * MICRO_BATCH, 0, 0, seconds_since(start));
+}
+
+// Whole-target clears, the per-pixel loop against clear_framebuffer; opaque
+// black is not byte-uniform, so only zero can take the memset path
+static void bench_clear(Uint32 *buffer, BenchTarget target) {
+	const struct { const char *name; Uint32 color; } colors[] = {
+		{ "black", 0xFF000000 },
+		{ "zero", 0x00000000 },
+	};
+	int pitch = target.width * 4;
+	long pixels = (long)target.width * target.height;
+	for (size_t c = 0; c < sizeof(colors) / sizeof(colors[0]); c++) {
+		long iterations = 0;
+		Uint64 start = SDL_GetPerformanceCounter();
+		do {
+			for (int y = 0; y < target.height; y++) {
+				Uint32 *row = buffer + y * (pitch / 4);
+				for (int x = 0; x < target.width; x++) {
+					row[x] = colors[c].color;
+				}
+			}
+			iterations++;
+		} while (seconds_since(start) < MIN_BENCH_SECONDS);
+		print_result("clear", target.name, colors[c].name, "per_pixel", iterations, iterations, iterations * pixels, 0, seconds_since(start));
+		
+		iterations = 0;
+		start = SDL_GetPerformanceCounter();
+		do {
+			clear_framebuffer(buffer, pitch, target.width, target.height, colors[c].color);
+			iterations++;
+		} while (seconds_since(start) < MIN_BENCH_SECONDS);
+		print_result("clear", target.name, colors[c].name, "clear_framebuffer", iterations, iterations, iterations * pixels, 0, seconds_since(start));
+	}
+}
+
+// The allocating point list against writing straight into the buffer
+static void bench_lines(RenderTarget *target, IVec2 (*lines)[2], int count) {
+	long pixels_per_set = 0;
+	for (int i = 0; i < count; i++) {
+		int dx = abs(lines[i][1].x - lines[i][0].x);
+		int dy = abs(lines[i][1].y - lines[i][0].y);
+		pixels_per_set += (dx > dy ? dx : dy) + 1;
+	}
+	
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < count; i++) {
+			Line line = bresenham_line(lines[i][0], lines[i][1]);
+			for (int j = 0; j < line.count; j++) {
+				target->pixels[line.points[j].y * (target->pitch / 4) + line.points[j].x] = 0xFF0000C8;
+			}
+			free(line.points);
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("line", "640x480", "-", "bresenham_line", iterations, iterations * count, iterations * pixels_per_set, iterations * count, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < count; i++) {
+			rasterize_line(target->pixels, target->pitch, lines[i][0], lines[i][1], 0xFF0000C8, 0, 0, target->width, target->height);
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("line", "640x480", "-", "rasterize_line", iterations, iterations * count, iterations * pixels_per_set, iterations * count, seconds_since(start));
+}
+
+// ## TRIANGLE FILL ## //
+// The previous draw path: barycentric point list, then one scattered write per point
+static void bench_triangle_points(RenderContext *ctx, Uint32 *buffer, BenchTarget target, const char *variant, Triangle *triangles, int count) {
+	int row_length = target.width;
+	long iterations = 0;
+	long pixels = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < count; i++) {
+			arena_reset(ctx->frame_arena);
+			int npoints;
+			IVec2 *points = get_triangle_points(triangles[i], ctx, &npoints);
+			for (int j = 0; j < npoints; j++) {
+				if (points[j].x >= 0 && points[j].x < target.width && points[j].y >= 0 && points[j].y < target.height) {
+					buffer[points[j].y * row_length + points[j].x] = 0xFF00C800;
+					pixels++;
+				}
+			}
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	
+	print_result("triangle_fill", target.name, variant, "get_triangle_points", iterations, iterations * count, pixels, iterations * count, seconds_since(start));
+}
+
+// Calls the kernel itself, not the rasterize_triangle dispatch, which may route
+// the triangle to another kernel; without a kernel it times the dispatch
+static void bench_triangle_kernel(Uint32 *buffer, BenchTarget target, const char *variant, TriangleSetup *setups, int count, long pixels_per_set, RasterKernel kernel, const char *kernel_name, bool dispatch) {
+	if (!raster_kernel_supported(kernel)) {
+		printf("# %s kernel not supported on this CPU\n", kernel_name);
+		return;
+	}
+	TriangleKernel kernels[] = { rasterize_triangle_scalar, rasterize_triangle_sse2, rasterize_triangle_avx2 };
+	TriangleKernel triangle_kernel = dispatch ? rasterize_triangle : kernels[kernel];
+	
+	// Kernels take a rectangle already clipped to the triangle
+	ScreenRect *rects = malloc(count * sizeof(ScreenRect));
+	if (!rects) {
+		printf("Triangle kernel benchmark allocation error\n");
+		return;
+	}
+	for (int i = 0; i < count; i++) {
+		const TriangleSetup *setup = &setups[i];
+		rects[i] = screen_rect_intersection((ScreenRect){ 0, 0, target.width, target.height }, (ScreenRect){ setup->min_x, setup->min_y, setup->max_x + 1, setup->max_y + 1 });
+		// The vector kernels cannot hold every edge step, those triangles stay with scalar
+		if ((!dispatch) && kernel != RASTER_KERNEL_SCALAR && !simd_kernel_fits(setup)) {
+			printf("# %s kernel cannot fit triangle %d\n", kernel_name, i);
+			free(rects);
+			return;
+		}
+	}
+	
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < count; i++) {
+			if (!screen_rect_empty(rects[i])) {
+				triangle_kernel(buffer, target.width * 4, &setups[i], 0xFF00C800, rects[i].min_x, rects[i].min_y, rects[i].max_x, rects[i].max_y);
+			}
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	free(rects);
+	
+	print_result("triangle_fill", target.name, variant, kernel_name, iterations, iterations * count, iterations * pixels_per_set, iterations * count, seconds_since(start));
+}
+
+// ## FULL FRAMES ## //
+// Random primitives inside the view volume of the default camera, smaller as
+// there are more of them, like a scene with more detail
+static void random_scene(Triangle *triangles, int count, Uint32 seed) {
+	float size = 4.0f / sqrtf(count / 1000.0f);
+	for (int i = 0; i < count; i++) {
+		Vec3 center = { random_range(&seed, -6.0f, 6.0f), random_range(&seed, -4.5f, 4.5f), random_range(&seed, -3.0f, 3.0f) };
+		for (int j = 0; j < 3; j++) {
+			triangles[i].vertices[j] = vec3_add(center, (Vec3){
+				random_range(&seed, -0.5f, 0.5f) * size,
+				random_range(&seed, -0.5f, 0.5f) * size,
+				random_range(&seed, -0.5f, 0.5f) * size
+			});
+		}
+	}
+}
+
+// Clear, draw every primitive and flush, as main.c does each frame, in arenas
+// of the same size
+static void bench_frame(RenderContext *ctx, const char *target_name, Triangle *triangles, int count, bool lines, TileRenderer *tile_renderer) {
+	ColorRgb color = { 0, 200, 0, 255 };
+	RenderTarget *target = ctx->target;
+	ctx->tile_renderer = tile_renderer;
+	
+	long iterations = 0;
+	bool drawn = true;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(ctx->frame_arena);
+		arena_reset(ctx->bin_arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		clear_depth_buffer(ctx->depth_buffer);
+		
+		for (int i = 0; i < count; i++) {
+			if (lines) {
+				drawn &= draw_line(ctx, triangles[i].vertices[0], triangles[i].vertices[1], color);
+			} else {
+				drawn &= draw_triangle(ctx, triangles[i], color);
+			}
+		}
+		if (tile_renderer) {
+			tile_renderer_flush(tile_renderer);
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_%s", count, lines ? "lines" : "triangles");
+	if (!drawn) {
+		printf("# frame %s %s %s: some draw calls failed\n", target_name, variant, tile_renderer ? "tiled" : "serial");
+	}
+	print_result("frame", target_name, variant, tile_renderer ? "tiled" : "serial", iterations, iterations, iterations * target->width * target->height, iterations * count, seconds_since(start));
+}
+
+// Flat grid of n x n quads filling the view, with every triangle side as an
+// edge, or the deduplicated edge list
+static Mesh *create_grid_mesh(int n, bool unique_edges) {
+	int vertex_count = (n + 1) * (n + 1);
+	int triangle_count = 2 * n * n;
+	Mesh *mesh = create_mesh(vertex_count, triangle_count, 3 * triangle_count);
+	if (!mesh) {
+		return NULL;
+	}
+	
+	for (int y = 0; y <= n; y++) {
+		for (int x = 0; x <= n; x++) {
+			int i = y * (n + 1) + x;
+			mesh->x[i] = -6.0f + 12.0f * x / n;
+			mesh->y[i] = -4.5f + 9.0f * y / n;
+			mesh->z[i] = 0.0f;
+		}
+	}
+	int t = 0;
+	for (int y = 0; y < n; y++) {
+		for (int x = 0; x < n; x++) {
+			int a = y * (n + 1) + x;
+			int c = a + n + 1;
+			int quad[2][3] = { { a, a + 1, c + 1 }, { a, c + 1, c } };
+			for (int j = 0; j < 2; j++, t++) {
+				for (int k = 0; k < 3; k++) {
+					mesh->triangles[t][k] = quad[j][k];
+					mesh->edges[3 * t + k][0] = quad[j][k];
+					mesh->edges[3 * t + k][1] = quad[j][(k + 1) % 3];
+				}
+			}
+		}
+	}
+	if (unique_edges && !mesh_build_edges(mesh)) {
+		destroy_mesh(&mesh);
+		return NULL;
+	}
+	mesh_update_bounds(mesh);
+	return mesh;
+}
+
+static void bench_wireframe(RenderContext *ctx, const char *target_name, const Mesh *mesh, const char *path) {
+	ColorRgb color = { 0, 200, 0, 255 };
+	RenderTarget *target = ctx->target;
+	ctx->tile_renderer = NULL;
+	
+	long iterations = 0;
+	bool drawn = true;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(ctx->frame_arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		clear_depth_buffer(ctx->depth_buffer);
+		drawn &= draw_mesh(ctx, mesh, color);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_triangles", mesh->triangle_count);
+	if (!drawn) {
+		printf("# wireframe %s %s %s: draw_mesh failed\n", target_name, variant, path);
+	}
+	print_result("wireframe", target_name, variant, path, iterations, iterations, iterations * target->width * target->height, iterations * mesh->edge_count, seconds_since(start));
+}
+
+static bool run_frame_benchmarks(BenchTarget bench_target) {
+	const int primitive_counts[] = { 1000, 10000, 100000, 1000000 };
+	const int max_count = primitive_counts[sizeof(primitive_counts) / sizeof(primitive_counts[0]) - 1];
+	
+	// The arenas main.c renders with
+	Arena *frame_arena = create_arena(FRAME_ARENA_SIZE);
+	Arena *bin_arena = create_arena(BIN_ARENA_SIZE);
+	TileRenderer *tile_renderer = create_tile_renderer(0);
+	RenderTarget *target = create_render_target(bench_target.width, bench_target.height);
+	DepthBuffer *depth_buffer = create_depth_buffer(bench_target.width, bench_target.height);
+	Triangle *triangles = malloc(max_count * sizeof(Triangle));
+	bool result = frame_arena && bin_arena && tile_renderer && target && depth_buffer && triangles;
+	if (result) {
+		Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+		RenderContext ctx;
+		init_render_context(&ctx, &cam, target, frame_arena);
+		ctx.bin_arena = bin_arena;
+		ctx.depth_buffer = depth_buffer;
+		
+		for (size_t i = 0; i < sizeof(primitive_counts) / sizeof(primitive_counts[0]); i++) {
+			random_scene(triangles, primitive_counts[i], 777u + (Uint32)i);
+			for (int lines = 0; lines <= 1; lines++) {
+				bench_frame(&ctx, bench_target.name, triangles, primitive_counts[i], lines, NULL);
+				bench_frame(&ctx, bench_target.name, triangles, primitive_counts[i], lines, tile_renderer);
+			}
+		}
+		
+		// Wireframe meshes, every triangle side against each shared edge once,
+		// in a frame arena sized for the mesh as for a --model
+		const int grid_sizes[] = { 64, 256, 512 };
+		for (size_t i = 0; i < sizeof(grid_sizes) / sizeof(grid_sizes[0]) && result; i++) {
+			Mesh *per_triangle = create_grid_mesh(grid_sizes[i], false);
+			Mesh *unique = create_grid_mesh(grid_sizes[i], true);
+			Arena *mesh_arena = per_triangle ? create_arena(frame_arena_size(per_triangle)) : NULL;
+			result = per_triangle && unique && mesh_arena;
+			if (result) {
+				ctx.frame_arena = mesh_arena;
+				bench_wireframe(&ctx, bench_target.name, per_triangle, "per_triangle_edges");
+				bench_wireframe(&ctx, bench_target.name, unique, "unique_edges");
+				ctx.frame_arena = frame_arena;
+			}
+			destroy_arena(&mesh_arena);
+			destroy_mesh(&per_triangle);
+			destroy_mesh(&unique);
+		}
+	}
+	
+	free(triangles);
+	destroy_depth_buffer(&depth_buffer);
+	destroy_render_target(&target);
+	destroy_tile_renderer(&tile_renderer);
+	destroy_arena(&bin_arena);
+	destroy_arena(&frame_arena);
+	return result;
+}
+
+// ## SCENE GRAPH ## //
+static Transform random_placement(Uint32 *seed) {
+	Vec3 position = {
+		random_range(seed, -0.5f, 0.5f) * SCENE_EXTENT,
+		random_range(seed, -0.5f, 0.5f) * SCENE_EXTENT,
+		random_range(seed, -0.5f, 0.5f) * SCENE_EXTENT,
+	};
+	Vec3 rotation = { random_range(seed, 0.0f, 6.28f), random_range(seed, 0.0f, 6.28f), random_range(seed, 0.0f, 6.28f) };
+	return (Transform){ position, rotation, 1.0f };
+}
+
+// Scattered cubes of which a few percent are in view, drawn by testing each one
+// in draw_cube and by culling the hierarchy, and the refit after moving some
+static void bench_scene_graph(RenderTarget *target, Arena *arena, int count) {
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, target, arena);
+	Cube cube = create_cube((Vec3){ 0.0f, 0.0f, 0.0f }, 2.0f);
+	ColorRgb color = { 0, 200, 0, 255 };
+	SceneGraph *graph = create_scene_graph(count);
+	if (!graph) {
+		printf("Scene graph allocation error\n");
+		return;
+	}
+	Uint32 seed = 31337u;
+	for (int i = 0; i < count; i++) {
+		scene_graph_add_cube(graph, &cube, random_placement(&seed), color);
+	}
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_instances", count);
+	
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		scene_graph_build(graph);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("scene", "-", variant, "build", iterations, iterations, 0, iterations * count, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		for (int i = 0; i < graph->count; i++) {
+			set_model_matrix(&ctx, graph->instances[i].model_matrix);
+			draw_cube(&ctx, cube, color);
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("scene", "640x480", variant, "per_instance_cull", iterations, iterations, iterations * target->width * target->height, iterations * count, seconds_since(start));
+	
+	iterations = 0;
+	long drawn = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		scene_graph_draw(graph, &ctx);
+		drawn += graph->drawn_instances;
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("scene", "640x480", variant, "bvh_cull", iterations, iterations, iterations * target->width * target->height, drawn, seconds_since(start));
+	
+	// 1% of the instances move each frame
+	int moved = count / 100;
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		for (int i = 0; i < moved; i++) {
+			scene_graph_set_transform(graph, (int)(random_unit(&seed) * count) % count, random_placement(&seed));
+		}
+		scene_graph_refit(graph);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("scene", "-", variant, "refit_1_percent", iterations, iterations, 0, iterations * moved, seconds_since(start));
+	
+	destroy_scene_graph(&graph);
+}
+
+// ## INSTANCING ## //
+// Small spinning cubes spread over the view, drawn one draw_cube call each
+// and as instances of one mesh
+static void bench_instancing(RenderTarget *target, Arena *arena, int count) {
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, target, arena);
+	Cube cube = create_cube((Vec3){ 0.0f, 0.0f, 0.0f }, 0.1f);
+	Mesh *mesh = mesh_from_cube(cube);
+	Matrix4 *model_matrices = malloc(count * sizeof(Matrix4));
+	ColorRgb *colors = malloc(count * sizeof(ColorRgb));
+	if (!(mesh && model_matrices && colors)) {
+		printf("Instancing benchmark allocation error\n");
+		destroy_mesh(&mesh);
+		free(model_matrices);
+		free(colors);
+		return;
+	}
+	Uint32 seed = 2024u;
+	for (int i = 0; i < count; i++) {
+		Vec3 position = { random_range(&seed, -6.0f, 6.0f), random_range(&seed, -4.5f, 4.5f), random_range(&seed, -3.0f, 3.0f) };
+		Vec3 rotation = { random_range(&seed, 0.0f, 6.28f), random_range(&seed, 0.0f, 6.28f), random_range(&seed, 0.0f, 6.28f) };
+		model_matrices[i] = transform_matrix((Transform){ position, rotation, 1.0f });
+		colors[i] = (ColorRgb){ (Uint8)(i * 37), 200, (Uint8)(i * 91), 255 };
+	}
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_cubes", count);
+	
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		for (int i = 0; i < count; i++) {
+			set_model_matrix(&ctx, model_matrices[i]);
+			draw_cube(&ctx, cube, colors[i]);
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("instancing", "640x480", variant, "draw_cube", iterations, iterations, iterations * target->width * target->height, iterations * count, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		draw_mesh_instanced(&ctx, mesh, model_matrices, colors, count);
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("instancing", "640x480", variant, "draw_mesh_instanced", iterations, iterations, iterations * target->width * target->height, iterations * count, seconds_since(start));
+	
+	destroy_mesh(&mesh);
+	free(model_matrices);
+	free(colors);
+}
+
+// ## LEVEL OF DETAIL ## //
+// Unit sphere of rings bands of segments quads, with one vertex at each pole
+static Mesh *create_sphere_mesh(int rings, int segments) {
+	int vertex_count = 2 + (rings - 1) * segments;
+	int triangle_count = 2 * segments * (rings - 1);
+	Mesh *mesh = create_mesh(vertex_count, triangle_count, 3 * triangle_count);
+	if (!mesh) {
+		return NULL;
+	}
+	
+	int south = vertex_count - 1;
+	mesh->x[0] = 0.0f;
+	mesh->y[0] = 1.0f;
+	mesh->z[0] = 0.0f;
+	for (int r = 1; r < rings; r++) {
+		for (int s = 0; s < segments; s++) {
+			int i = 1 + (r - 1) * segments + s;
+			float theta = 3.14159265f * r / rings;
+			float phi = 6.28318531f * s / segments;
+			mesh->x[i] = sinf(theta) * cosf(phi);
+			mesh->y[i] = cosf(theta);
+			mesh->z[i] = sinf(theta) * sinf(phi);
+		}
+	}
+	mesh->x[south] = 0.0f;
+	mesh->y[south] = -1.0f;
+	mesh->z[south] = 0.0f;
+	
+	// Counter-clockwise from outside: the caps as fans, the bands as quads
+	int t = 0;
+	for (int r = 0; r < rings; r++) {
+		for (int s = 0; s < segments; s++) {
+			int a = 1 + (r - 1) * segments + s;
+			int b = 1 + (r - 1) * segments + (s + 1) % segments;
+			int triangles[2][3] = { { a, b, b + segments }, { a, b + segments, a + segments } };
+			if (r == 0) {
+				triangles[0][0] = 0;
+				triangles[0][1] = 1 + (s + 1) % segments;
+				triangles[0][2] = 1 + s;
+			} else if (r == rings - 1) {
+				triangles[0][0] = south;
+				triangles[0][1] = a;
+				triangles[0][2] = b;
+			}
+			int count = (r == 0 || r == rings - 1) ? 1 : 2;
+			for (int j = 0; j < count; j++, t++) {
+				for (int k = 0; k < 3; k++) {
+					mesh->triangles[t][k] = triangles[j][k];
+				}
+			}
+		}
+	}
+	if (!mesh_build_edges(mesh)) {
+		destroy_mesh(&mesh);
+		return NULL;
+	}
+	mesh_update_bounds(mesh);
+	return mesh;
+}
+
+// Wireframe spheres at full detail, then at the level their projected size picks
+static void bench_lod(RenderTarget *target, Arena *arena, int count) {
+	Camera cam = { { 0.0f, 0.0f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, target, arena);
+	Mesh *mesh = create_sphere_mesh(32, 64);
+	Matrix4 *model_matrices = malloc(count * sizeof(Matrix4));
+	if (!(mesh && model_matrices)) {
+		printf("Level of detail benchmark allocation error\n");
+		destroy_mesh(&mesh);
+		free(model_matrices);
+		return;
+	}
+	// Spread evenly in depth, inside the view
+	Uint32 seed = 99u;
+	for (int i = 0; i < count; i++) {
+		float depth = random_range(&seed, 5.0f, 500.0f);
+		Vec3 position = { random_range(&seed, -0.5f, 0.5f) * depth, random_range(&seed, -0.37f, 0.37f) * depth, 10.0f - depth };
+		model_matrices[i] = transform_matrix((Transform){ position, { 0.0f, 0.0f, 0.0f }, 1.0f });
+	}
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_spheres", count);
+	
+	long iterations = 0;
+	MeshLod *lod = NULL;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		destroy_mesh_lod(&lod);
+		lod = create_mesh_lod(mesh, LOD_LEVELS);
+		iterations++;
+	} while (lod && seconds_since(start) < MIN_BENCH_SECONDS);
+	if (!lod) {
+		printf("Level of detail benchmark allocation error\n");
+		destroy_mesh(&mesh);
+		free(model_matrices);
+		return;
+	}
+	print_result("lod", "-", variant, "create_mesh_lod", iterations, iterations, 0, iterations * mesh->triangle_count, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		for (int i = 0; i < count; i++) {
+			set_model_matrix(&ctx, model_matrices[i]);
+			draw_mesh(&ctx, mesh, (ColorRgb){ 0, 200, 0, 255 });
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("lod", "640x480", variant, "full_detail", iterations, iterations, iterations * target->width * target->height, iterations * count, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		for (int i = 0; i < count; i++) {
+			set_model_matrix(&ctx, model_matrices[i]);
+			draw_mesh_lod(&ctx, lod, (ColorRgb){ 0, 200, 0, 255 });
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("lod", "640x480", variant, "draw_mesh_lod", iterations, iterations, iterations * target->width * target->height, iterations * count, seconds_since(start));
+	
+	destroy_mesh_lod(&lod);
+	destroy_mesh(&mesh);
+	free(model_matrices);
+}
+
+// ## LOADING ## //
+static void write_le32(FILE *file, const void *value) {
+	unsigned char bytes[4];
+	Uint32 bits;
+	memcpy(&bits, value, sizeof(bits));
+	for (int i = 0; i < 4; i++) {
+		bytes[i] = bits >> (8 * i);
+	}
+	fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+static bool write_obj(const Mesh *mesh, const char *path) {
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		return false;
+	}
+	for (int i = 0; i < mesh->vertex_count; i++) {
+		fprintf(file, "v %.9g %.9g %.9g\n", mesh->x[i], mesh->y[i], mesh->z[i]);
+	}
+	for (int t = 0; t < mesh->triangle_count; t++) {
+		fprintf(file, "f %d %d %d\n", mesh->triangles[t][0] + 1, mesh->triangles[t][1] + 1, mesh->triangles[t][2] + 1);
+	}
+	return fclose(file) == 0;
+}
+
+static bool write_binary_ply(const Mesh *mesh, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	fprintf(file, "ply\nformat binary_little_endian 1.0\nelement vertex %d\nproperty float x\nproperty float y\nproperty float z\n", mesh->vertex_count);
+	fprintf(file, "element face %d\nproperty list uchar int vertex_indices\nend_header\n", mesh->triangle_count);
+	for (int i = 0; i < mesh->vertex_count; i++) {
+		write_le32(file, &mesh->x[i]);
+		write_le32(file, &mesh->y[i]);
+		write_le32(file, &mesh->z[i]);
+	}
+	for (int t = 0; t < mesh->triangle_count; t++) {
+		fputc(3, file);
+		for (int k = 0; k < 3; k++) {
+			write_le32(file, &mesh->triangles[t][k]);
+		}
+	}
+	return fclose(file) == 0;
+}
+
+static bool write_binary_stl(const Mesh *mesh, const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	char header[80] = "bench sphere";
+	fwrite(header, 1, sizeof(header), file);
+	write_le32(file, &mesh->triangle_count);
+	float normal[3] = { 0.0f, 0.0f, 0.0f };
+	for (int t = 0; t < mesh->triangle_count; t++) {
+		for (int k = 0; k < 3; k++) {
+			write_le32(file, &normal[k]);
+		}
+		for (int k = 0; k < 3; k++) {
+			int v = mesh->triangles[t][k];
+			write_le32(file, &mesh->x[v]);
+			write_le32(file, &mesh->y[v]);
+			write_le32(file, &mesh->z[v]);
+		}
+		fputc(0, file);
+		fputc(0, file);
+	}
+	return fclose(file) == 0;
+}
+
+static void bench_load(const char *path, const char *format, long triangle_count) {
+	long iterations = 0;
+	Mesh *mesh = NULL;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		destroy_mesh(&mesh);
+		mesh = load_mesh(path);
+		iterations++;
+	} while (mesh && seconds_since(start) < MIN_BENCH_SECONDS);
+	double seconds = seconds_since(start);
+	if (!mesh) {
+		printf("Error loading %s\n", path);
+		return;
+	}
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%ld_triangles", triangle_count);
+	print_result("load", "-", variant, format, iterations, iterations, 0, iterations * mesh->triangle_count, seconds);
+	destroy_mesh(&mesh);
+}
+
+// The same sphere parsed from each format, then written to and mapped from the
+// binary cache. The files are written next to the benchmark and removed after
+static void bench_loading(void) {
+	const char *paths[] = { "bench_mesh.obj", "bench_mesh.ply", "bench_mesh.stl" };
+	const char *cache_path = "bench_mesh.cache";
+	Mesh *mesh = create_sphere_mesh(LOAD_RINGS, LOAD_SEGMENTS);
+	if (!mesh) {
+		printf("Loading benchmark allocation error\n");
+		return;
+	}
+	if (!(write_obj(mesh, paths[0]) && write_binary_ply(mesh, paths[1]) && write_binary_stl(mesh, paths[2]))) {
+		printf("Error writing the loading benchmark files\n");
+	} else {
+		bench_load(paths[0], "load_obj", mesh->triangle_count);
+		bench_load(paths[1], "load_ply_binary", mesh->triangle_count);
+		bench_load(paths[2], "load_stl_binary", mesh->triangle_count);
+	}
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_triangles", mesh->triangle_count);
+	
+	long iterations = 0;
+	bool saved = true;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		saved = save_mesh_cache(mesh, paths[0], cache_path);
+		iterations++;
+	} while (saved && seconds_since(start) < MIN_BENCH_SECONDS);
+	if (saved) {
+		print_result("load", "-", variant, "save_mesh_cache", iterations, iterations, 0, iterations * mesh->triangle_count, seconds_since(start));
+	} else {
+		printf("Error writing %s\n", cache_path);
+	}
+	
+	// Mapping alone, then mapping and reading every position as a first draw would
+	for (int touch = 0; saved && touch < 2; touch++) {
+		iterations = 0;
+		MappedMesh *mapped = NULL;
+		start = SDL_GetPerformanceCounter();
+		do {
+			unmap_mesh_cache(&mapped);
+			mapped = map_mesh_cache(cache_path);
+			float sum = 0.0f;
+			for (int i = 0; touch && mapped && i < mapped->mesh.vertex_count; i++) {
+				sum += mapped->mesh.x[i] + mapped->mesh.y[i] + mapped->mesh.z[i];
+			}
+			bench_sink = sum;
+			iterations++;
+		} while (mapped && seconds_since(start) < MIN_BENCH_SECONDS);
+		if (mapped) {
+			print_result("load", "-", variant, touch ? "map_mesh_cache_read" : "map_mesh_cache", iterations, iterations, 0, iterations * mesh->triangle_count, seconds_since(start));
+		} else {
+			printf("Error mapping %s\n", cache_path);
+		}
+		unmap_mesh_cache(&mapped);
+	}
+	
+	for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++) {
+		remove(paths[i]);
+	}
+	remove(cache_path);
+	destroy_mesh(&mesh);
+}
+
+// ## SOLIDS ## //
+// Depth tested filled icosahedra, every face drawn as a triangle against only
+// the faces towards the camera
+static void bench_solids(RenderTarget *target, Arena *arena, int count) {
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, target, arena);
+	Mesh *mesh = create_platonic_mesh(ICOSAHEDRON, (Vec3){ 0.0f, 0.0f, 0.0f }, 0.6f);
+	Matrix4 *model_matrices = malloc(count * sizeof(Matrix4));
+	DepthBuffer *depth_buffer = create_depth_buffer(target->width, target->height);
+	if (!(mesh && model_matrices && depth_buffer)) {
+		printf("Solid benchmark allocation error\n");
+		destroy_mesh(&mesh);
+		free(model_matrices);
+		destroy_depth_buffer(&depth_buffer);
+		return;
+	}
+	ctx.depth_buffer = depth_buffer;
+	Uint32 seed = 77u;
+	for (int i = 0; i < count; i++) {
+		Vec3 position = { random_range(&seed, -5.0f, 5.0f), random_range(&seed, -3.5f, 3.5f), random_range(&seed, -3.0f, 3.0f) };
+		Vec3 rotation = { random_range(&seed, 0.0f, 6.28f), random_range(&seed, 0.0f, 6.28f), random_range(&seed, 0.0f, 6.28f) };
+		model_matrices[i] = transform_matrix((Transform){ position, rotation, 1.0f });
+	}
+	ColorRgb color = { 0, 200, 0, 255 };
+	char variant[32];
+	snprintf(variant, sizeof(variant), "%d_icosahedra", count);
+	
+	long iterations = 0;
+	Uint64 start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		clear_depth_buffer(depth_buffer);
+		for (int i = 0; i < count; i++) {
+			set_model_matrix(&ctx, model_matrices[i]);
+			for (int j = 0; j < mesh->triangle_count; j++) {
+				Triangle t = { { mesh_vertex(mesh, mesh->triangles[j][0]), mesh_vertex(mesh, mesh->triangles[j][1]), mesh_vertex(mesh, mesh->triangles[j][2]) } };
+				draw_triangle(&ctx, t, color);
+			}
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("solid", "640x480", variant, "draw_triangle", iterations, iterations, iterations * target->width * target->height, iterations * count * mesh->triangle_count, seconds_since(start));
+	
+	iterations = 0;
+	start = SDL_GetPerformanceCounter();
+	do {
+		arena_reset(arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		clear_depth_buffer(depth_buffer);
+		for (int i = 0; i < count; i++) {
+			set_model_matrix(&ctx, model_matrices[i]);
+			draw_filled_mesh(&ctx, mesh, color);
+		}
+		iterations++;
+	} while (seconds_since(start) < MIN_BENCH_SECONDS);
+	print_result("solid", "640x480", variant, "draw_filled_mesh", iterations, iterations, iterations * target->width * target->height, iterations * count * mesh->triangle_count, seconds_since(start));
+	
+	destroy_mesh(&mesh);
+	free(model_matrices);
+	destroy_depth_buffer(&depth_buffer);
+}
+
+int main() {
+	BenchTarget targets[] = {
+		{ "640x480", 640, 480 },
+		{ "3840x2160", 3840, 2160 },
+	};
+	BenchTriangleSize sizes[] = {
+		{ "small", 8.0f },
+		{ "medium", 128.0f },
+		{ "large", 1024.0f },
+	};
+	
+	Arena *arena = create_arena(BENCH_ARENA_SIZE);
+	Triangle *triangles = malloc(TRIANGLES_PER_SET * sizeof(Triangle));
+	TriangleSetup *setups = malloc(TRIANGLES_PER_SET * sizeof(TriangleSetup));
+	Uint32 *buffer = malloc(3840 * 2160 * sizeof(Uint32));
+	Matrix4 *matrices = malloc(2 * MICRO_BATCH * sizeof(Matrix4));
+	Vec4 *points = malloc(MICRO_BATCH * sizeof(Vec4));
+	Vec3 *world_points = malloc(MICRO_BATCH * sizeof(Vec3));
+	Vec3 *viewport_points = malloc(MICRO_BATCH * sizeof(Vec3));
+	ClipVertex *clip_points = malloc(MICRO_BATCH * sizeof(ClipVertex));
+	IVec2 (*lines)[2] = malloc(LINES_PER_SET * sizeof(IVec2[2]));
+	Vec3 *angles = malloc(2 * MICRO_BATCH * sizeof(Vec3));
+	Quat *quats = malloc(2 * MICRO_BATCH * sizeof(Quat));
+	if (!(arena && triangles && setups && buffer && matrices && points && world_points && viewport_points && clip_points && lines && angles && quats)) {
+		printf("Benchmark allocation error\n");
+		return 1;
+	}
+	
+	printf("benchmark,target,variant,path,iterations,ops,pixels,primitives,seconds,ns_per_op,pixels_per_sec,primitives_per_sec\n");
+	
+	// Linear algebra and transforms
+	Uint32 seed = 4242u;
+	for (int i = 0; i < 2 * MICRO_BATCH; i++) {
+		matrices[i] = random_matrix(&seed);
+	}
+	for (int i = 0; i < MICRO_BATCH; i++) {
+		world_points[i] = (Vec3){ random_range(&seed, -6.0f, 6.0f), random_range(&seed, -4.5f, 4.5f), random_range(&seed, -3.0f, 3.0f) };
+		points[i] = vec3_homogenous(world_points[i], 1.0f);
+	}
+	bench_mat4_mul(matrices, matrices + MICRO_BATCH);
+	bench_mat4_vec4_mul(matrices[0], points);
+	for (int i = 0; i < 2 * MICRO_BATCH; i++) {
+		angles[i] = (Vec3){ random_range(&seed, 0.0f, 6.28f), random_range(&seed, 0.0f, 6.28f), random_range(&seed, 0.0f, 6.28f) };
+		quats[i] = quat_from_euler(angles[i]);
+	}
+	bench_rotations(angles, quats, matrices);
+	
+	// Inputs in the first three streams, outputs in the rest
+	float *soa[7];
+	for (int i = 0; i < 7; i++) {
+		soa[i] = malloc(MICRO_BATCH * sizeof(float));
+		if (!soa[i]) {
+			printf("Benchmark allocation error\n");
+			return 1;
+		}
+	}
+	for (int i = 0; i < MICRO_BATCH; i++) {
+		soa[0][i] = world_points[i].x;
+		soa[1][i] = world_points[i].y;
+		soa[2][i] = world_points[i].z;
+	}
+	LinalgKernel best_linalg_kernel = get_linalg_kernel();
+	bench_soa_kernel(LINALG_KERNEL_SCALAR, "scalar", &matrices[0], soa);
+	bench_soa_kernel(LINALG_KERNEL_SSE2, "sse2", &matrices[0], soa);
+	bench_soa_kernel(LINALG_KERNEL_AVX2, "avx2", &matrices[0], soa);
+	set_linalg_kernel(best_linalg_kernel);
+	for (int i = 0; i < 7; i++) {
+		free(soa[i]);
+	}
+	
+	// Lines and the point list path draw into a target the size of the first
+	RenderTarget *screen = create_render_target(targets[0].width, targets[0].height);
+	if (!screen) {
+		printf("Benchmark allocation error\n");
+		return 1;
+	}
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, screen, arena);
+	bench_world_to_viewport(&ctx, world_points, viewport_points, clip_points);
+	
+	// Lines of every slope, up to a screen diagonal
+	for (int i = 0; i < LINES_PER_SET; i++) {
+		for (int j = 0; j < 2; j++) {
+			lines[i][j] = (IVec2){ (int)random_range(&seed, 0.0f, screen->width - 1), (int)random_range(&seed, 0.0f, screen->height - 1) };
+		}
+	}
+	bench_lines(screen, lines, LINES_PER_SET);
+	
+	// Maps world (x, y) straight to viewport pixels, so get_triangle_points sees
+	// the same triangles as the kernels
+	ctx.view_projection_matrix = (Matrix4){ .m = {
+			{2.0f / screen->width, 0.0f, 0.0f, -1.0f},
+			{0.0f, -2.0f / screen->height, 0.0f, 1.0f},
+			{0.0f, 0.0f, 1.0f, 0.0f},
+			{0.0f, 0.0f, 0.0f, 1.0f}
+		},
+	};
+	set_model_matrix(&ctx, scale_transformation(1.0f));
+	
+	for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+		bench_clear(buffer, targets[t]);
+	}
+	
+	RasterKernel best_kernel = get_raster_kernel();
+	for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+		for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			random_triangles(triangles, TRIANGLES_PER_SET, targets[t], sizes[s].size, 12345u + (Uint32)s);
+			int count = 0;
+			long pixels_per_set = 0;
+			for (int i = 0; i < TRIANGLES_PER_SET; i++) {
+				Vec3 *v = triangles[i].vertices;
+				if (setup_triangle(&setups[count], v[0], v[1], v[2])) {
+					pixels_per_set += count_covered_pixels(&setups[count], targets[t]);
+					count++;
+				}
+			}
+			
+			// get_triangle_points clips to the view volume, which maps to the screen target
+			if (targets[t].width == screen->width && targets[t].height == screen->height) {
+				bench_triangle_points(&ctx, buffer, targets[t], sizes[s].name, triangles, TRIANGLES_PER_SET);
+			}
+			bench_triangle_kernel(buffer, targets[t], sizes[s].name, setups, count, pixels_per_set, RASTER_KERNEL_SCALAR, "scalar", false);
+			bench_triangle_kernel(buffer, targets[t], sizes[s].name, setups, count, pixels_per_set, RASTER_KERNEL_SSE2, "sse2", false);
+			bench_triangle_kernel(buffer, targets[t], sizes[s].name, setups, count, pixels_per_set, RASTER_KERNEL_AVX2, "avx2", false);
+			bench_triangle_kernel(buffer, targets[t], sizes[s].name, setups, count, pixels_per_set, get_raster_kernel(), "rasterize_triangle", true);
+		}
+	}
+	set_raster_kernel(best_kernel);
+	
+	// Whole frames through the draw calls, serial and tiled
+	for (size_t t = 0; t < sizeof(targets) / sizeof(targets[0]); t++) {
+		if (!run_frame_benchmarks(targets[t])) {
+			printf("Frame benchmark allocation error\n");
+		}
+	}
+	
+	bench_scene_graph(screen, arena, SCENE_INSTANCES);
+	bench_instancing(screen, arena, DRAW_INSTANCES);
+	bench_solids(screen, arena, SOLID_COUNT);
+	bench_lod(screen, arena, LOD_OBJECTS);
+	bench_loading();
+	
+	destroy_render_target(&screen);	
+	free(quats);
+	free(angles);
+	free(lines);
+	free(clip_points);
+	free(viewport_points);
+	free(world_points);
+	free(points);
+	free(matrices);
+	free(buffer);
+	free(setups);
+	free(triangles);
+	destroy_arena(&arena);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <math.h>
+#include <string.h>
+#include "clip.h"
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## INLINE FUNCTIONS ## //
+// Signed distance to frustum plane i, in clip space, negative outside
+static inline float plane_distance(Vec4 v, int plane) {
+	switch (plane) {
+		case 0: return v.w + v.x;
+		case 1: return v.w - v.x;
+		case 2: return v.w + v.y;
+		case 3: return v.w - v.y;
+		case 4: return v.w + v.z;
+		default: return v.w - v.z;
+	}
+}
+
+// # FRUSTUM FUNCTIONS # //
+Frustum frustum_from_matrix(Matrix4 m) {
+	Frustum frustum;
+	for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+		// w +- x, w +- y and w +- z, as in plane_distance
+		int row = i / 2;
+		float sign = (i & 1) ? -1.0f : 1.0f;
+		Vec3 normal = {
+			m.m[3][0] + sign * m.m[row][0],
+			m.m[3][1] + sign * m.m[row][1],
+			m.m[3][2] + sign * m.m[row][2],
+		};
+		float distance = m.m[3][3] + sign * m.m[row][3];
+		
+		// Unit normals, so the distances compare against a radius
+		float length = vec3_length(normal);
+		frustum.planes[i] = (Plane){ vec3_scale(normal, 1.0f / length), distance / length };
+	}
+	
+	return frustum;
+}
+
+bool sphere_in_frustum(const Frustum *frustum, Vec3 center, float radius) {
+	for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+		const Plane *plane = &frustum->planes[i];
+		if (vec3_dot_product(plane->normal, center) + plane->distance < -radius) {
+			return false;
+		}
+	}
+	
+	return true;
+}
+
+bool box_in_frustum(const Frustum *frustum, Vec3 min, Vec3 max, int *plane_mask) {
+	for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+		if (!(*plane_mask & (1 << i))) {
+			continue;
+		}
+		
+		// Corners furthest along and against the normal
+		const Plane *plane = &frustum->planes[i];
+		Vec3 positive = {
+			plane->normal.x >= 0.0f ? max.x : min.x,
+			plane->normal.y >= 0.0f ? max.y : min.y,
+			plane->normal.z >= 0.0f ? max.z : min.z,
+		};
+		if (vec3_dot_product(plane->normal, positive) + plane->distance < 0.0f) {
+			return false;
+		}
+		Vec3 negative = {
+			plane->normal.x >= 0.0f ? min.x : max.x,
+			plane->normal.y >= 0.0f ? min.y : max.y,
+			plane->normal.z >= 0.0f ? min.z : max.z,
+		};
+		if (vec3_dot_product(plane->normal, negative) + plane->distance >= 0.0f) {
+			*plane_mask &= ~(1 << i);
+		}
+	}
+	
+	return true;
+}
+
+// # CLIP SPACE FUNCTIONS # //
+int clip_outcode(Vec4 v) {
+	int outcode = 0;
+	for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+		if (plane_distance(v, i) < 0.0f) {
+			outcode |= 1 << i;
+		}
+	}
+	
+	return outcode;
+}
+
+bool clip_line(Vec4 *v0, Vec4 *v1) {
+	// Liang-Barsky: the parameter range [t0, t1] still inside every plane
+	float t0 = 0.0f;
+	float t1 = 1.0f;
+	for (int i = 0; i < CLIP_PLANE_COUNT; i++) {
+		float d0 = plane_distance(*v0, i);
+		float d1 = plane_distance(*v1, i);
+		if (d0 < 0.0f && d1 < 0.0f) {
+			return false;
+		}
+		if (d0 < 0.0f) {
+			float t = d0 / (d0 - d1);
+			t0 = t > t0 ? t : t0;
+		} else if (d1 < 0.0f) {
+			float t = d0 / (d0 - d1);
+			t1 = t < t1 ? t : t1;
+		}
+	}
+	if (t0 > t1) {
+		return false;
+	}
+	
+	Vec4 from = *v0;
+	Vec4 to = *v1;
+	if (t0 > 0.0f) {
+		*v0 = vec4_lerp(from, to, t0);
+	}
+	if (t1 < 1.0f) {
+		*v1 = vec4_lerp(from, to, t1);
+	}
+	return true;
+}
+
+int clip_polygon(Vec4 *vertices, int count, int outcode_mask) {
+	Vec4 clipped[CLIP_MAX_POLYGON_VERTICES];
+	for (int plane = 0; plane < CLIP_PLANE_COUNT && count > 0; plane++) {
+		if (!(outcode_mask & (1 << plane))) {
+			continue;
+		}
+		
+		int clipped_count = 0;
+		Vec4 previous = vertices[count - 1];
+		float previous_distance = plane_distance(previous, plane);
+		for (int i = 0; i < count; i++) {
+			Vec4 current = vertices[i];
+			float distance = plane_distance(current, plane);
+			// Emit the crossing point whenever the edge changes side
+			if ((previous_distance < 0.0f) != (distance < 0.0f)) {
+				clipped[clipped_count++] = vec4_lerp(previous, current, previous_distance / (previous_distance - distance));
+			}
+			if (distance >= 0.0f) {
+				clipped[clipped_count++] = current;
+			}
+			previous = current;
+			previous_distance = distance;
+		}
+		
+		count = clipped_count;
+		memcpy(vertices, clipped, count * sizeof(Vec4));
+	}
+	
+	return count;
+}
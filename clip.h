@@ -0,0 +1,51 @@
+#ifndef CLIP_H
+#define CLIP_H
+
+#include <stdbool.h>
+#include "linalg.h"
+
+// ### CONSTANTS ### //
+// Outcode bits, one per frustum plane a clip space point lies outside of
+#define CLIP_LEFT (1 << 0)    // x < -w
+#define CLIP_RIGHT (1 << 1)   // x > w
+#define CLIP_BOTTOM (1 << 2)  // y < -w
+#define CLIP_TOP (1 << 3)     // y > w
+#define CLIP_NEAR (1 << 4)    // z < -w
+#define CLIP_FAR (1 << 5)     // z > w
+#define CLIP_PLANE_COUNT 6
+// Every plane adds at most one vertex to a convex polygon
+#define CLIP_MAX_POLYGON_VERTICES (3 + CLIP_PLANE_COUNT)
+
+// ### STRUCTS ### //
+// Points p with dot(normal, p) + distance >= 0 are on the inside
+typedef struct {
+	Vec3 normal;
+	float distance;
+} Plane;
+
+// World space planes of the view volume, in the outcode bit order
+typedef struct {
+	Plane planes[CLIP_PLANE_COUNT];
+} Frustum;
+
+// ### FUNCTION DECLARATIONS ### //
+// # FRUSTUM FUNCTIONS # //
+// Extracts the planes from the rows of a view-projection matrix
+Frustum frustum_from_matrix(Matrix4 m);
+// Conservative, spheres near a frustum corner may be kept
+bool sphere_in_frustum(const Frustum *frustum, Vec3 center, float radius);
+// Axis-aligned box against the planes whose bits are set in *plane_mask, returns
+// false when it is outside one of them; the bits of the planes it is entirely
+// inside are cleared, so nothing within the box has to test them again
+bool box_in_frustum(const Frustum *frustum, Vec3 min, Vec3 max, int *plane_mask);
+
+// # CLIP SPACE FUNCTIONS # //
+int clip_outcode(Vec4 v);
+// Trims the segment to the view volume, returns false when nothing is left
+// The clipped points have w >= the near plane distance, so they can be divided
+bool clip_line(Vec4 *v0, Vec4 *v1);
+// Sutherland-Hodgman against the planes in outcode_mask, the OR of the vertex
+// outcodes; vertices must hold CLIP_MAX_POLYGON_VERTICES, returns the new count
+int clip_polygon(Vec4 *vertices, int count, int outcode_mask);
+
+#endif
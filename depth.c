@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include "depth.h"
+
+// ### FUNCTION DEFINITIONS ### //
+
+// # CREATE AND DESTROY FUNCTIONS # //
+DepthBuffer *create_depth_buffer(int width, int height) {
+	if (width <= 0 || height <= 0) {
+		return NULL;
+	}
+	
+	DepthBuffer *depth_buffer = malloc(sizeof(DepthBuffer));
+	if (!depth_buffer) {
+		return NULL;
+	}
+	
+	depth_buffer->width = width;
+	depth_buffer->height = height;
+	depth_buffer->blocks_x = (width + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE;
+	depth_buffer->blocks_y = (height + DEPTH_BLOCK_SIZE - 1) / DEPTH_BLOCK_SIZE;
+	depth_buffer->depth = malloc(width * height * sizeof(float));
+	depth_buffer->block_max_depth = malloc(depth_buffer->blocks_x * depth_buffer->blocks_y * sizeof(float));
+	if ((!depth_buffer->depth) || (!depth_buffer->block_max_depth)) {
+		destroy_depth_buffer(&depth_buffer);
+		return NULL;
+	}
+	
+	clear_depth_buffer(depth_buffer);
+	return depth_buffer;
+}
+
+void destroy_depth_buffer(DepthBuffer **depth_buffer) {
+	if ((!depth_buffer) || (!(*depth_buffer))) {
+		return;
+	}
+	
+	free((*depth_buffer)->depth);
+	free((*depth_buffer)->block_max_depth);
+	free(*depth_buffer);
+	*depth_buffer = NULL;
+}
+
+// # DEPTH FUNCTIONS # //
+void clear_depth_buffer(DepthBuffer *depth_buffer) {
+	if (!depth_buffer) {
+		return;
+	}
+	
+	int pixel_count = depth_buffer->width * depth_buffer->height;
+	for (int i = 0; i < pixel_count; i++) {
+		depth_buffer->depth[i] = DEPTH_CLEAR_VALUE;
+	}
+	int block_count = depth_buffer->blocks_x * depth_buffer->blocks_y;
+	for (int i = 0; i < block_count; i++) {
+		depth_buffer->block_max_depth[i] = DEPTH_CLEAR_VALUE;
+	}
+}
+
+void clear_depth_rect(DepthBuffer *depth_buffer, int min_x, int min_y, int max_x, int max_y) {
+	if (!depth_buffer) {
+		return;
+	}
+	if (min_x < 0) min_x = 0;
+	if (min_y < 0) min_y = 0;
+	if (max_x > depth_buffer->width) max_x = depth_buffer->width;
+	if (max_y > depth_buffer->height) max_y = depth_buffer->height;
+	if (min_x >= max_x || min_y >= max_y) {
+		return;
+	}
+	
+	for (int y = min_y; y < max_y; y++) {
+		float *row = depth_buffer->depth + y * depth_buffer->width;
+		for (int x = min_x; x < max_x; x++) {
+			row[x] = DEPTH_CLEAR_VALUE;
+		}
+	}
+	// Nothing is farther than a cleared pixel, so every touched block's maximum is the clear value
+	for (int by = min_y / DEPTH_BLOCK_SIZE; by <= (max_y - 1) / DEPTH_BLOCK_SIZE; by++) {
+		for (int bx = min_x / DEPTH_BLOCK_SIZE; bx <= (max_x - 1) / DEPTH_BLOCK_SIZE; bx++) {
+			depth_buffer->block_max_depth[by * depth_buffer->blocks_x + bx] = DEPTH_CLEAR_VALUE;
+		}
+	}
+}
+
+void refresh_depth_block(DepthBuffer *depth_buffer, int block_x, int block_y) {
+	int min_x = block_x * DEPTH_BLOCK_SIZE;
+	int min_y = block_y * DEPTH_BLOCK_SIZE;
+	int max_x = min_x + DEPTH_BLOCK_SIZE < depth_buffer->width ? min_x + DEPTH_BLOCK_SIZE : depth_buffer->width;
+	int max_y = min_y + DEPTH_BLOCK_SIZE < depth_buffer->height ? min_y + DEPTH_BLOCK_SIZE : depth_buffer->height;
+	
+	float max_depth = depth_buffer->depth[min_y * depth_buffer->width + min_x];
+	for (int y = min_y; y < max_y; y++) {
+		const float *row = depth_buffer->depth + y * depth_buffer->width;
+		for (int x = min_x; x < max_x; x++) {
+			max_depth = row[x] > max_depth ? row[x] : max_depth;
+		}
+	}
+	depth_buffer->block_max_depth[block_y * depth_buffer->blocks_x + block_x] = max_depth;
+}
@@ -0,0 +1,37 @@
+#ifndef DEPTH_H
+#define DEPTH_H
+
+#include <stdbool.h>
+
+// ### CONSTANTS ### //
+// Side of the square pixel blocks the hierarchical depth is kept for
+#define DEPTH_BLOCK_SIZE 8
+// Cleared depth, the far plane in normalized device coordinates
+#define DEPTH_CLEAR_VALUE 1.0f
+
+// ### STRUCTS ### //
+// Per-pixel normalized device depth, smaller is closer
+// block_max_depth keeps an upper bound of the depth inside each block, so a
+// triangle whose nearest point in a block lies behind it skips the whole block
+typedef struct {
+	float *depth;
+	int width;
+	int height;
+	float *block_max_depth;
+	int blocks_x;
+	int blocks_y;
+} DepthBuffer;
+
+// ### FUNCTION DECLARATIONS ### //
+// # CREATE AND DESTROY FUNCTIONS # //
+DepthBuffer *create_depth_buffer(int width, int height);
+void destroy_depth_buffer(DepthBuffer **depth_buffer);
+
+// # DEPTH FUNCTIONS # //
+void clear_depth_buffer(DepthBuffer *depth_buffer);
+// Clears [min_x, max_x) x [min_y, max_y) only
+void clear_depth_rect(DepthBuffer *depth_buffer, int min_x, int min_y, int max_x, int max_y);
+// Recomputes the exact maximum of one block after pixels in it were written
+void refresh_depth_block(DepthBuffer *depth_buffer, int block_x, int block_y);
+
+#endif
@@ -0,0 +1,106 @@
+#include "dirty.h"
+
+// ### FUNCTION DEFINITIONS ### //
+
+// # RECTANGLE FUNCTIONS # //
+bool screen_rect_empty(ScreenRect rect) {
+	return rect.min_x >= rect.max_x || rect.min_y >= rect.max_y;
+}
+
+bool screen_rects_overlap(ScreenRect a, ScreenRect b) {
+	return !screen_rect_empty(screen_rect_intersection(a, b));
+}
+
+ScreenRect screen_rect_union(ScreenRect a, ScreenRect b) {
+	if (screen_rect_empty(a)) {
+		return b;
+	}
+	if (screen_rect_empty(b)) {
+		return a;
+	}
+	
+	ScreenRect rect = {
+		a.min_x < b.min_x ? a.min_x : b.min_x,
+		a.min_y < b.min_y ? a.min_y : b.min_y,
+		a.max_x > b.max_x ? a.max_x : b.max_x,
+		a.max_y > b.max_y ? a.max_y : b.max_y,
+	};
+	return rect;
+}
+
+ScreenRect screen_rect_intersection(ScreenRect a, ScreenRect b) {
+	ScreenRect rect = {
+		a.min_x > b.min_x ? a.min_x : b.min_x,
+		a.min_y > b.min_y ? a.min_y : b.min_y,
+		a.max_x < b.max_x ? a.max_x : b.max_x,
+		a.max_y < b.max_y ? a.max_y : b.max_y,
+	};
+	return rect;
+}
+
+long screen_rect_area(ScreenRect rect) {
+	if (screen_rect_empty(rect)) {
+		return 0;
+	}
+	return (long)(rect.max_x - rect.min_x) * (rect.max_y - rect.min_y);
+}
+
+// # DIRTY REGION FUNCTIONS # //
+void dirty_region_clear(DirtyRegion *region) {
+	if (!region) {
+		return;
+	}
+	region->count = 0;
+}
+
+static void remove_rect(DirtyRegion *region, int index) {
+	region->rects[index] = region->rects[--region->count];
+}
+
+void dirty_region_add(DirtyRegion *region, ScreenRect rect) {
+	if ((!region) || screen_rect_empty(rect)) {
+		return;
+	}
+	
+	// A union can reach rectangles neither part overlapped, so rescan after each merge
+	int i = 0;
+	while (i < region->count) {
+		if (screen_rects_overlap(region->rects[i], rect)) {
+			rect = screen_rect_union(region->rects[i], rect);
+			remove_rect(region, i);
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+	if (region->count < DIRTY_MAX_RECTS) {
+		region->rects[region->count++] = rect;
+		return;
+	}
+	
+	// Full, merge with the rectangle that grows the least and add the result instead
+	int best = 0;
+	long best_growth = -1;
+	for (int j = 0; j < region->count; j++) {
+		long growth = screen_rect_area(screen_rect_union(region->rects[j], rect)) - screen_rect_area(region->rects[j]);
+		if (best_growth < 0 || growth < best_growth) {
+			best = j;
+			best_growth = growth;
+		}
+	}
+	rect = screen_rect_union(region->rects[best], rect);
+	remove_rect(region, best);
+	dirty_region_add(region, rect);
+}
+
+long dirty_region_area(const DirtyRegion *region) {
+	if (!region) {
+		return 0;
+	}
+	
+	long area = 0;
+	for (int i = 0; i < region->count; i++) {
+		area += screen_rect_area(region->rects[i]);
+	}
+	return area;
+}
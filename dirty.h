@@ -0,0 +1,40 @@
+#ifndef DIRTY_H
+#define DIRTY_H
+
+#include <stdbool.h>
+
+// ### CONSTANTS ### //
+// Past this many rectangles, new ones are merged into their closest neighbour
+#define DIRTY_MAX_RECTS 16
+
+// ### STRUCTS ### //
+// Pixels [min_x, max_x) x [min_y, max_y), empty when either range is
+typedef struct {
+	int min_x;
+	int min_y;
+	int max_x;
+	int max_y;
+} ScreenRect;
+
+// Disjoint rectangles covering every pixel that has to be redrawn
+typedef struct {
+	ScreenRect rects[DIRTY_MAX_RECTS];
+	int count;
+} DirtyRegion;
+
+// ### FUNCTION DECLARATIONS ### //
+// # RECTANGLE FUNCTIONS # //
+bool screen_rect_empty(ScreenRect rect);
+bool screen_rects_overlap(ScreenRect a, ScreenRect b);
+// Smallest rectangle containing both
+ScreenRect screen_rect_union(ScreenRect a, ScreenRect b);
+ScreenRect screen_rect_intersection(ScreenRect a, ScreenRect b);
+long screen_rect_area(ScreenRect rect);
+
+// # DIRTY REGION FUNCTIONS # //
+void dirty_region_clear(DirtyRegion *region);
+// Overlapping rectangles are merged, so no pixel is redrawn twice
+void dirty_region_add(DirtyRegion *region, ScreenRect rect);
+long dirty_region_area(const DirtyRegion *region);
+
+#endif
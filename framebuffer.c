@@ -0,0 +1,161 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "framebuffer.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FRAMEBUFFER_SIMD_X86 1
+#endif
+
+// ### CONSTANT DEFINITIONS ### //
+// Below this many pixels a plain loop beats setting up vector stores
+#define SHORT_SPAN 8
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## INLINE FUNCTIONS ## //
+// memset can write the color when its four bytes are equal, as black and white are
+static inline bool uniform_bytes(Uint32 color) {
+	return color == (color & 0xFF) * 0x01010101u;
+}
+
+// ## FILL KERNELS ## //
+#ifdef FRAMEBUFFER_SIMD_X86
+__attribute__((target("sse2")))
+static void fill_pixels(Uint32 *pixels, size_t count, Uint32 color) {
+	const __m128i fill = _mm_set1_epi32((int)color);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		_mm_storeu_si128((__m128i*)(pixels + i), fill);
+	}
+	for (; i < count; i++) {
+		pixels[i] = color;
+	}
+}
+
+// Non-temporal stores need 16-byte alignment, the ends are written normally
+__attribute__((target("sse2")))
+static void stream_pixels(Uint32 *pixels, size_t count, Uint32 color) {
+	const __m128i fill = _mm_set1_epi32((int)color);
+	size_t i = 0;
+	for (; i < count && ((uintptr_t)(pixels + i) & 15); i++) {
+		pixels[i] = color;
+	}
+	for (; i + 4 <= count; i += 4) {
+		_mm_stream_si128((__m128i*)(pixels + i), fill);
+	}
+	for (; i < count; i++) {
+		pixels[i] = color;
+	}
+	// Streamed stores are weakly ordered, make them visible before anything draws
+	_mm_sfence();
+}
+#else
+static void fill_pixels(Uint32 *pixels, size_t count, Uint32 color) {
+	for (size_t i = 0; i < count; i++) {
+		pixels[i] = color;
+	}
+}
+
+static void stream_pixels(Uint32 *pixels, size_t count, Uint32 color) {
+	fill_pixels(pixels, count, color);
+}
+#endif
+
+// # CREATE AND DESTROY FUNCTIONS # //
+RenderTarget *create_render_target(int width, int height) {
+	RenderTarget *target = calloc(1, sizeof(RenderTarget));
+	if (!target) {
+		return NULL;
+	}
+	
+	target->format = SDL_PIXELFORMAT_ARGB8888;
+	if (!resize_render_target(target, width, height)) {
+		free(target);
+		return NULL;
+	}
+	return target;
+}
+
+void destroy_render_target(RenderTarget **target) {
+	if ((!target) || (!(*target))) {
+		return;
+	}
+	
+	free((*target)->pixels);
+	free(*target);
+	*target = NULL;
+}
+
+bool resize_render_target(RenderTarget *target, int width, int height) {
+	if ((!target) || width <= 0 || height <= 0) {
+		return false;
+	}
+	
+	// Rows are not padded, so clear_framebuffer treats the frame as one span
+	Uint32 *pixels = malloc((size_t)width * height * sizeof(Uint32));
+	if (!pixels) {
+		return false;
+	}
+	free(target->pixels);
+	target->pixels = pixels;
+	target->width = width;
+	target->height = height;
+	target->pitch = width * 4;
+	return true;
+}
+
+// # CLEAR AND FILL FUNCTIONS # //
+void fill_span(Uint32 *row, int min_x, int max_x, Uint32 color) {
+	if ((!row) || min_x >= max_x) {
+		return;
+	}
+	
+	int count = max_x - min_x;
+	if (count < SHORT_SPAN) {
+		for (int x = min_x; x < max_x; x++) {
+			row[x] = color;
+		}
+	} else if (uniform_bytes(color)) {
+		memset(row + min_x, color & 0xFF, count * sizeof(Uint32));
+	} else {
+		fill_pixels(row + min_x, count, color);
+	}
+}
+
+void fill_rect(Uint32 *buffer, int pitch, int min_x, int min_y, int max_x, int max_y, Uint32 color) {
+	if ((!buffer) || min_x >= max_x) {
+		return;
+	}
+	
+	int row_length = pitch / 4;
+	for (int y = min_y; y < max_y; y++) {
+		fill_span(buffer + y * row_length, min_x, max_x, color);
+	}
+}
+
+void clear_framebuffer(Uint32 *buffer, int pitch, int width, int height, Uint32 color) {
+	if ((!buffer) || width <= 0 || height <= 0) {
+		return;
+	}
+	
+	// Without row padding the whole frame is one span
+	int row_length = pitch / 4;
+	bool contiguous = row_length == width;
+	size_t count = contiguous ? (size_t)width * height : (size_t)width;
+	int rows = contiguous ? 1 : height;
+	bool stream = (size_t)width * height * sizeof(Uint32) >= FRAMEBUFFER_STREAM_BYTES;
+	
+	for (int y = 0; y < rows; y++) {
+		Uint32 *row = buffer + (size_t)y * row_length;
+		if (stream) {
+			stream_pixels(row, count, color);
+		} else if (uniform_bytes(color)) {
+			memset(row, color & 0xFF, count * sizeof(Uint32));
+		} else {
+			fill_pixels(row, count, color);
+		}
+	}
+}
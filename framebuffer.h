@@ -0,0 +1,39 @@
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+
+// ### CONSTANTS ### //
+// Clears at least this large use non-temporal stores, which bypass the cache.
+// Smaller frames fit in it and are drawn over right away, so they stay cached
+#define FRAMEBUFFER_STREAM_BYTES (4 * 1024 * 1024)
+
+// ### STRUCTS ### //
+// Pixels draw calls write to, one per render job, so several can be drawn at once
+typedef struct {
+	Uint32 *pixels;
+	int width;
+	int height;
+	// Bytes per row
+	int pitch;
+	// SDL_PixelFormatEnum of the pixels, the rasterizers write ARGB8888
+	Uint32 format;
+} RenderTarget;
+
+// ### FUNCTION DECLARATIONS ### //
+// # CREATE AND DESTROY FUNCTIONS # //
+RenderTarget *create_render_target(int width, int height);
+void destroy_render_target(RenderTarget **target);
+// The pixels are reallocated and left uninitialized
+bool resize_render_target(RenderTarget *target, int width, int height);
+
+// Buffers are 32-bit pixels with pitch bytes per row, rectangles are not clipped
+// # CLEAR AND FILL FUNCTIONS # //
+void clear_framebuffer(Uint32 *buffer, int pitch, int width, int height, Uint32 color);
+// Pixels [min_x, max_x) x [min_y, max_y)
+void fill_rect(Uint32 *buffer, int pitch, int min_x, int min_y, int max_x, int max_y, Uint32 color);
+// Pixels [min_x, max_x) of one row
+void fill_span(Uint32 *row, int min_x, int max_x, Uint32 color);
+
+#endif
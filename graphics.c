@@ -1,17 +1,32 @@
 #include <math.h>
 #include <stdbool.h>
 #include "graphics.h"
+#include "tiler.h"
+#include "framebuffer.h"
 
 // ### CONSTANT DEFINITIONS ### //
 const float UNIT_EQ_TRIANGLE_CIRCUMCENTER = 0.57735f;
 const float UNIT_TETRAHEDRON_CIRCUMRADIUS = 0.6124f;
-const int SCREEN_WIDTH = 640;
-const int SCREEN_HEIGHT = 480;
-const float FIELD_OF_VIEW = 0.785f;
-const float NEAR =  0.1f;
-const float FAR = 1000.0f;
+const float GOLDEN_RATIO = 1.618034f;
 
-#define ASPECT_RATIO ( (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT )
+// Triangle vertices are snapped to 1/16 of a pixel
+#define SUBPIXEL_BITS 4
+#define SUBPIXEL_ONE (1 << SUBPIXEL_BITS)
+// Largest viewport coordinate, in pixels, the edge functions can hold without overflow
+#define MAX_RASTER_COORDINATE 4194304.0f
+// Vertices transformed per batch by transform_vertices_soa
+#define TRANSFORM_CHUNK 256
+// Narrower clip rectangles are rasterized pixel by pixel, not as spans
+#define SPAN_MIN_WIDTH 32
+// Rectangle widths the vector kernels take, measured against scalar
+#define SIMD_MIN_WIDTH 16
+#define SIMD_MAX_WIDTH 96
+// Instances transformed per pass by draw_mesh_instanced before their edges are drawn
+#define INSTANCE_BATCH 256
+// Fewest pixels of the projected bounding circle per triangle before a coarser level is drawn
+#define LOD_PIXELS_PER_TRIANGLE 16.0f
+// Projected bounding circles with a smaller radius, in pixels, are drawn as a point
+#define LOD_POINT_RADIUS 0.5f
 
 // ### FUNCTION DEFINITIONS ### //
 
@@ -22,6 +37,9 @@ static inline float min3(float x, float y, float z) {
 static inline float max3(float x, float y, float z) {
 	return fmaxf(fmaxf(x, y), z);
 }
+static inline bool vec3_equals(Vec3 v1, Vec3 v2) {
+	return v1.x == v2.x && v1.y == v2.y && v1.z == v2.z;
+}
 
 // ## STRUCT FUNCTIONS ## //
 // # CREATE AND DESTROY FUNCTIONS # //
@@ -99,6 +117,160 @@ Cube create_cube(Vec3 center, float side_length) {
 	return cube;
 }
 
+// Two triangles per side of a create_cube cube, counter-clockwise from outside
+static const int cube_faces[12][3] = {
+	{ 0, 1, 2 }, { 0, 2, 3 }, { 4, 6, 5 }, { 4, 7, 6 },
+	{ 0, 5, 1 }, { 0, 4, 5 }, { 3, 2, 6 }, { 3, 6, 7 },
+	{ 0, 3, 7 }, { 0, 7, 4 }, { 1, 5, 6 }, { 1, 6, 2 }
+};
+
+FilledCube create_filled_cube(Vec3 center, float side_length) {
+	FilledCube filled_cube = { .cube = create_cube(center, side_length) };
+	for (int i = 0; i < 12; i++) {
+		for (int j = 0; j < 3; j++) {
+			filled_cube.t_faces[i].vertices[j] = filled_cube.cube.vertices[cube_faces[i][j]];
+		}
+	}
+	
+	return filled_cube;
+}
+
+Mesh *mesh_from_tetrahedron(Tetrahedron th) {
+	return create_convex_mesh(th.vertices, 4);
+}
+
+Mesh *mesh_from_cube(Cube cube) {
+	return create_convex_mesh(cube.vertices, 8);
+}
+
+Mesh *create_platonic_mesh(PlatonicSolid solid, Vec3 center, float side_length) {
+	Vec3 points[20];
+	int count = 0;
+	// Points of a solid centered at the origin, with unit_side the edge length they produce
+	float unit_side = 1.0f;
+	float phi = GOLDEN_RATIO;
+	switch (solid) {
+		case TETRAHEDRON:
+			return mesh_from_tetrahedron(create_tetrahedron(center, side_length));
+		case HEXAHEDRON:
+			return mesh_from_cube(create_cube(center, side_length));
+		case OCTAHEDRON:
+			// (+-1, 0, 0), (0, +-1, 0), (0, 0, +-1)
+			for (int axis = 0; axis < 3; axis++) {
+				for (int sign = -1; sign <= 1; sign += 2) {
+					float v[3] = { 0.0f, 0.0f, 0.0f };
+					v[axis] = (float)sign;
+					points[count++] = (Vec3){ v[0], v[1], v[2] };
+				}
+			}
+			unit_side = sqrtf(2.0f);
+			break;
+		case DODECAHEDRON:
+			// (+-1, +-1, +-1) and the cyclic permutations of (0, +-1/phi, +-phi)
+			for (int i = 0; i < 8; i++) {
+				points[count++] = (Vec3){ (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f };
+			}
+			for (int i = 0; i < 4; i++) {
+				float a = (i & 1) ? 1.0f / phi : -1.0f / phi;
+				float b = (i & 2) ? phi : -phi;
+				points[count++] = (Vec3){ 0.0f, a, b };
+				points[count++] = (Vec3){ a, b, 0.0f };
+				points[count++] = (Vec3){ b, 0.0f, a };
+			}
+			unit_side = 2.0f / phi;
+			break;
+		case ICOSAHEDRON:
+			// Cyclic permutations of (0, +-1, +-phi)
+			for (int i = 0; i < 4; i++) {
+				float a = (i & 1) ? 1.0f : -1.0f;
+				float b = (i & 2) ? phi : -phi;
+				points[count++] = (Vec3){ 0.0f, a, b };
+				points[count++] = (Vec3){ a, b, 0.0f };
+				points[count++] = (Vec3){ b, 0.0f, a };
+			}
+			unit_side = 2.0f;
+			break;
+	}
+	
+	for (int i = 0; i < count; i++) {
+		points[i] = vec3_add(vec3_scale(points[i], side_length / unit_side), center);
+	}
+	return create_convex_mesh(points, count);
+}
+
+// ## RENDER CONTEXT ## //
+void init_render_context(RenderContext *ctx, Camera *cam, RenderTarget *target, Arena *frame_arena) {
+	if ((!ctx) || (!cam) || (!target)) {
+		return;
+	}
+	
+	ctx->cam = *cam;
+	ctx->target = target;
+	ctx->viewport_width = target->width;
+	ctx->viewport_height = target->height;
+	ctx->frame_arena = frame_arena;
+	ctx->tile_renderer = NULL;
+	ctx->bin_arena = NULL;
+	ctx->depth_buffer = NULL;
+	ctx->scissor = (ScreenRect){ 0, 0, target->width, target->height };
+	ctx->stats = NULL;
+	ctx->view_matrix = gen_view_matrix(cam);
+	ctx->projection_matrix = gen_perspective_projection_matrix(cam, (float)target->width / (float)target->height);
+	ctx->view_projection_matrix = mat4_mul(ctx->projection_matrix, ctx->view_matrix);
+	ctx->frustum = frustum_from_matrix(ctx->view_projection_matrix);
+	set_model_matrix(ctx, scale_transformation(1.0f));
+	init_raster_kernel();
+}
+
+bool update_render_context(RenderContext *ctx, Camera *cam) {
+	if ((!ctx) || (!cam)) {
+		return false;
+	}
+	
+	bool view_changed = !(vec3_equals(ctx->cam.eye, cam->eye) && vec3_equals(ctx->cam.center, cam->center) && vec3_equals(ctx->cam.up_direction, cam->up_direction));
+	bool lens_changed = ctx->cam.field_of_view != cam->field_of_view || ctx->cam.near_plane != cam->near_plane || ctx->cam.far_plane != cam->far_plane;
+	bool resized = ctx->viewport_width != ctx->target->width || ctx->viewport_height != ctx->target->height;
+	if (!(view_changed || lens_changed || resized)) {
+		return false;
+	}
+	
+	ctx->cam = *cam;
+	if (lens_changed || resized) {
+		ctx->viewport_width = ctx->target->width;
+		ctx->viewport_height = ctx->target->height;
+		ctx->scissor = (ScreenRect){ 0, 0, ctx->target->width, ctx->target->height };
+		ctx->projection_matrix = gen_perspective_projection_matrix(cam, (float)ctx->target->width / (float)ctx->target->height);
+	}
+	ctx->view_matrix = gen_view_matrix(cam);
+	ctx->view_projection_matrix = mat4_mul(ctx->projection_matrix, ctx->view_matrix);
+	ctx->frustum = frustum_from_matrix(ctx->view_projection_matrix);
+	ctx->model_view_projection_matrix = mat4_mul(ctx->view_projection_matrix, ctx->model_matrix);
+	return true;
+}
+
+void set_model_matrix(RenderContext *ctx, Matrix4 model_matrix) {
+	if (!ctx) {
+		return;
+	}
+	
+	ctx->model_matrix = model_matrix;
+	ctx->model_view_projection_matrix = mat4_mul(ctx->view_projection_matrix, model_matrix);
+	
+	// Length of the longest basis vector
+	float scale_squared = 0.0f;
+	for (int col = 0; col < 3; col++) {
+		Vec3 axis = { model_matrix.m[0][col], model_matrix.m[1][col], model_matrix.m[2][col] };
+		float length_squared = vec3_length_squared(axis);
+		scale_squared = length_squared > scale_squared ? length_squared : scale_squared;
+	}
+	ctx->model_scale = sqrtf(scale_squared);
+}
+
+Matrix4 transform_matrix(Transform transform) {
+	Matrix4 rotation = mat4_mul(rotation_zaxis(transform.rotation.z), mat4_mul(rotation_yaxis(transform.rotation.y), rotation_xaxis(transform.rotation.x)));
+	return mat4_mul(translate_vec(transform.position), mat4_mul(rotation, scale_transformation(transform.scale)));
+}
+
 // ## MATRIX TRANSFORMATIONS ## //
 Matrix4 gen_view_matrix(Camera *cam) {
 	// View-coordinates = World-coordinates from the camera's perspective
@@ -122,11 +294,13 @@ Matrix4 gen_view_matrix(Camera *cam) {
 	return view_matrix;
 }
 
-Matrix4 gen_perspective_projection_matrix() {
+Matrix4 gen_perspective_projection_matrix(Camera *cam, float aspect_ratio) {
+	float near = cam->near_plane;
+	float far = cam->far_plane;
 	Matrix4 perspective_projection_matrix = { .m = {
-			{1.0f / (ASPECT_RATIO * tanf(FIELD_OF_VIEW / 2.0f)), 0.0f, 0.0f, 0.0f},
-			{0.0f, 1.0f / tanf(FIELD_OF_VIEW / 2.0f), 0.0f, 0.0f},
-			{0.0f, 0.0f, -(FAR + NEAR) / (FAR - NEAR), -(2 * FAR * NEAR) / (FAR - NEAR)},
+			{1.0f / (aspect_ratio * tanf(cam->field_of_view / 2.0f)), 0.0f, 0.0f, 0.0f},
+			{0.0f, 1.0f / tanf(cam->field_of_view / 2.0f), 0.0f, 0.0f},
+			{0.0f, 0.0f, -(far + near) / (far - near), -(2 * far * near) / (far - near)},
 			{0.0f, 0.0f, -1.0f, 0.0f}
 		},
 	};
@@ -135,27 +309,250 @@ Matrix4 gen_perspective_projection_matrix() {
 }
 
 // The perspective information is encoded in w
+// Points clipped against the near plane have w >= the near distance, so w is never 0 here
 Vec3 perspective_divide(Vec4 v) {
-	// POTENTIAL BUG: Handle divide by 0 or very close to 0 values
-	return (Vec3){ v.x / v.w, v.y / v.w, v.z / v.w };
+	float inverse_w = 1.0f / v.w;
+	return (Vec3){ v.x * inverse_w, v.y * inverse_w, v.z * inverse_w };
 }
 
-Vec3 viewport_transform(Vec3 v) {
-	return (Vec3){ (v.x + 1.0f) / 2.0f * SCREEN_WIDTH, (1.0f - v.y) / 2.0f * SCREEN_HEIGHT, v.z };
+Vec3 viewport_transform(const RenderTarget *target, Vec3 v) {
+	return (Vec3){ (v.x + 1.0f) / 2.0f * target->width, (1.0f - v.y) / 2.0f * target->height, v.z };
 }
 
-Vec3 world_to_viewport(Camera *cam, Vec4 v) {
-	Matrix4 view_matrix = gen_view_matrix(cam);
-	Matrix4 projection_matrix = gen_perspective_projection_matrix();
-	
-	Vec4 projected_vector = mat4_vec4_mul(mat4_mul(projection_matrix, view_matrix), v);
+Vec3 world_to_viewport(RenderContext *ctx, Vec4 v) {
+	Vec4 projected_vector = mat4_vec4_mul(ctx->model_view_projection_matrix, v);
 	Vec3 perspective_vector = perspective_divide(projected_vector);
 	
-	return viewport_transform(perspective_vector);
+	return viewport_transform(ctx->target, perspective_vector);
+}
+
+void world_to_viewport_batch(RenderContext *ctx, const Vec3 *vertices, Vec3 *viewport_vertices, int count) {
+	if ((!ctx) || (!vertices) || (!viewport_vertices)) {
+		return;
+	}
+	
+	// Rows of the combined matrix, read once instead of copying the matrix per vertex
+	const float (*m)[4] = ctx->model_view_projection_matrix.m;
+	for (int i = 0; i < count; i++) {
+		Vec3 v = vertices[i];
+		Vec4 projected_vector = {
+			m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3],
+			m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3],
+			m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z + m[2][3],
+			m[3][0] * v.x + m[3][1] * v.y + m[3][2] * v.z + m[3][3],
+		};
+		viewport_vertices[i] = viewport_transform(ctx->target, perspective_divide(projected_vector));
+	}
+}
+
+static inline ClipVertex clip_vertex(const RenderTarget *target, Vec4 clip) {
+	ClipVertex vertex = { clip, { 0.0f, 0.0f, 0.0f }, clip_outcode(clip) };
+	if (!vertex.outcode) {
+		vertex.viewport = viewport_transform(target, perspective_divide(clip));
+	}
+	return vertex;
+}
+
+// Neither timed nor counted, for callers that only probe where vertices land
+static void transform_points(RenderContext *ctx, const Vec3 *vertices, ClipVertex *clip_vertices, int count) {
+	const float (*m)[4] = ctx->model_view_projection_matrix.m;
+	for (int i = 0; i < count; i++) {
+		Vec3 v = vertices[i];
+		clip_vertices[i] = clip_vertex(ctx->target, (Vec4){
+			m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3],
+			m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3],
+			m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z + m[2][3],
+			m[3][0] * v.x + m[3][1] * v.y + m[3][2] * v.z + m[3][3],
+		});
+	}
+}
+
+void transform_vertices(RenderContext *ctx, const Vec3 *vertices, ClipVertex *clip_vertices, int count) {
+	if ((!ctx) || (!vertices) || (!clip_vertices)) {
+		return;
+	}
+	
+	Uint64 timer = stats_start(ctx->stats);
+	transform_points(ctx, vertices, clip_vertices, count);
+	stats_lap(ctx->stats, STAT_STAGE_TRANSFORM, timer);
+	stats_count(ctx->stats, STAT_VERTICES_TRANSFORMED, count);
+}
+
+void transform_vertices_soa(RenderContext *ctx, const float *x, const float *y, const float *z, ClipVertex *clip_vertices, int count) {
+	if ((!ctx) || (!x) || (!y) || (!z) || (!clip_vertices)) {
+		return;
+	}
+	
+	// The vector transform runs over chunks that stay in L1, then the outcodes are added
+	Uint64 timer = stats_start(ctx->stats);
+	float clip_x[TRANSFORM_CHUNK];
+	float clip_y[TRANSFORM_CHUNK];
+	float clip_z[TRANSFORM_CHUNK];
+	float clip_w[TRANSFORM_CHUNK];
+	for (int start = 0; start < count; start += TRANSFORM_CHUNK) {
+		int chunk = count - start < TRANSFORM_CHUNK ? count - start : TRANSFORM_CHUNK;
+		mat4_transform_points_soa(&ctx->model_view_projection_matrix, x + start, y + start, z + start, clip_x, clip_y, clip_z, clip_w, chunk);
+		for (int i = 0; i < chunk; i++) {
+			clip_vertices[start + i] = clip_vertex(ctx->target, (Vec4){ clip_x[i], clip_y[i], clip_z[i], clip_w[i] });
+		}
+	}
+	stats_lap(ctx->stats, STAT_STAGE_TRANSFORM, timer);
+	stats_count(ctx->stats, STAT_VERTICES_TRANSFORMED, count);
+}
+
+ClipVertex *transform_mesh(RenderContext *ctx, const Mesh *mesh) {
+	if ((!ctx) || (!mesh)) {
+		return NULL;
+	}
+	
+	ClipVertex *clip_vertices = arena_alloc(ctx->frame_arena, mesh->vertex_count * sizeof(ClipVertex));
+	if (!clip_vertices) {
+		return NULL;
+	}
+	
+	transform_vertices_soa(ctx, mesh->x, mesh->y, mesh->z, clip_vertices, mesh->vertex_count);
+	return clip_vertices;
+}
+
+size_t frame_arena_size(const Mesh *mesh) {
+	if (!mesh) {
+		return FRAME_ARENA_SIZE;
+	}
+	
+	// Rounded up to the arena alignment
+	return FRAME_ARENA_SIZE + ((mesh->vertex_count * sizeof(ClipVertex) + 15) & ~(size_t)15);
+}
+
+bool sphere_visible(RenderContext *ctx, Vec3 center, float radius) {
+	if (!ctx) {
+		return false;
+	}
+	
+	// The frustum is kept in world space, so only the sphere is transformed
+	Vec4 world_center = mat4_vec4_mul(ctx->model_matrix, vec3_homogenous(center, 1.0f));
+	return sphere_in_frustum(&ctx->frustum, (Vec3){ world_center.x, world_center.y, world_center.z }, radius * ctx->model_scale);
+}
+
+float projected_radius(RenderContext *ctx, Vec3 center, float radius) {
+	if (!(ctx && ctx->target)) {
+		return 0.0f;
+	}
+	
+	// w of the center is its distance along the view direction
+	const float (*m)[4] = ctx->model_view_projection_matrix.m;
+	float w = m[3][0] * center.x + m[3][1] * center.y + m[3][2] * center.z + m[3][3];
+	float world_radius = radius * ctx->model_scale;
+	if (w <= world_radius) {
+		return (float)(ctx->target->width + ctx->target->height);
+	}
+	return world_radius * ctx->projection_matrix.m[1][1] * ctx->target->height / (2.0f * w);
+}
+
+ScreenRect screen_bounds(RenderContext *ctx, const Vec3 *vertices, int count) {
+	ScreenRect bounds = { 0, 0, 0, 0 };
+	if ((!ctx) || (!vertices) || count <= 0) {
+		return bounds;
+	}
+	
+	ClipVertex chunk[TRANSFORM_CHUNK];
+	int outside_all = ~0;
+	float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+	for (int start = 0; start < count; start += TRANSFORM_CHUNK) {
+		int chunk_count = count - start < TRANSFORM_CHUNK ? count - start : TRANSFORM_CHUNK;
+		// Dirty region queries are not drawing work, they stay out of the transform stats
+		transform_points(ctx, vertices + start, chunk, chunk_count);
+		for (int i = 0; i < chunk_count; i++) {
+			outside_all &= chunk[i].outcode;
+			if (chunk[i].outcode & CLIP_NEAR) {
+				// Behind the camera the projection flips, anything may be covered
+				min_x = min_y = -INFINITY;
+				max_x = max_y = INFINITY;
+				continue;
+			}
+			// Points beyond the other planes still project in the right direction
+			Vec3 v = chunk[i].outcode ? viewport_transform(ctx->target, perspective_divide(chunk[i].clip)) : chunk[i].viewport;
+			min_x = fminf(min_x, v.x);
+			min_y = fminf(min_y, v.y);
+			max_x = fmaxf(max_x, v.x);
+			max_y = fmaxf(max_y, v.y);
+		}
+	}
+	if (outside_all) {
+		return bounds;
+	}
+	
+	// A pixel of slack on each side for rounding, clamped in float before converting
+	bounds.min_x = (int)fmaxf(floorf(min_x) - 1.0f, 0.0f);
+	bounds.min_y = (int)fmaxf(floorf(min_y) - 1.0f, 0.0f);
+	bounds.max_x = (int)fminf(ceilf(max_x) + 2.0f, (float)ctx->target->width);
+	bounds.max_y = (int)fminf(ceilf(max_y) + 2.0f, (float)ctx->target->height);
+	return bounds;
+}
+
+// ## CLIPPING ## //
+// Sphere around the centroid, not minimal but enough to cull a handful of vertices
+static bool vertices_visible(RenderContext *ctx, const Vec3 *vertices, int count) {
+	Vec3 center = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < count; i++) {
+		center = vec3_add(center, vertices[i]);
+	}
+	center = vec3_scale(center, 1.0f / count);
+	
+	float radius_squared = 0.0f;
+	for (int i = 0; i < count; i++) {
+		float distance_squared = vec3_distance_squared(center, vertices[i]);
+		radius_squared = distance_squared > radius_squared ? distance_squared : radius_squared;
+	}
+	return sphere_visible(ctx, center, sqrtf(radius_squared));
+}
+
+// Viewport endpoints of the part of the edge inside the view volume
+static bool project_edge(const RenderTarget *target, ClipVertex from, ClipVertex to, Vec3 *viewport_from, Vec3 *viewport_to) {
+	// Both outside the same plane
+	if (from.outcode & to.outcode) {
+		return false;
+	}
+	if (!(from.outcode | to.outcode)) {
+		*viewport_from = from.viewport;
+		*viewport_to = to.viewport;
+		return true;
+	}
+	
+	Vec4 clip_from = from.clip;
+	Vec4 clip_to = to.clip;
+	if (!clip_line(&clip_from, &clip_to)) {
+		return false;
+	}
+	*viewport_from = viewport_transform(target, perspective_divide(clip_from));
+	*viewport_to = viewport_transform(target, perspective_divide(clip_to));
+	return true;
+}
+
+// Viewport polygon of the part of the triangle inside the view volume, as a fan
+// around polygon[0]; polygon must hold CLIP_MAX_POLYGON_VERTICES, returns the vertex count
+static int project_triangle(const RenderTarget *target, ClipVertex a, ClipVertex b, ClipVertex c, Vec3 *polygon) {
+	if (a.outcode & b.outcode & c.outcode) {
+		return 0;
+	}
+	if (!(a.outcode | b.outcode | c.outcode)) {
+		polygon[0] = a.viewport;
+		polygon[1] = b.viewport;
+		polygon[2] = c.viewport;
+		return 3;
+	}
+	
+	Vec4 clipped[CLIP_MAX_POLYGON_VERTICES] = { a.clip, b.clip, c.clip };
+	int count = clip_polygon(clipped, 3, a.outcode | b.outcode | c.outcode);
+	for (int i = 0; i < count; i++) {
+		polygon[i] = viewport_transform(target, perspective_divide(clipped[i]));
+	}
+	return count;
 }
 
 // ## DRAWING ALGORITHMS ## //
-Line bresenham_line(IVec2 p0, IVec2 p1) {
+// Writes the points of the line from p0 to p1 into points, which must hold
+// line_point_count(p0, p1) entries
+static int bresenham_fill(IVec2 p0, IVec2 p1, IVec2 *points) {
 	int x0 = p0.x;
 	int y0 = p0.y;
 	int x1 = p1.x;
@@ -173,13 +570,6 @@ Line bresenham_line(IVec2 p0, IVec2 p1) {
 	// and the rasterized line
 	int err = dx - dy;
 	
-	int capacity = dx + dy + 1;
-	// POTENTIAL FIX: Every malloc needs a free
-	IVec2* points = malloc(capacity * sizeof(Vec2));
-	if (!points) {
-		return (Line){ NULL, 0 };
-	}
-	
 	int index = 0;
 	while (true) {
 		points[index++] = (IVec2){ x0, y0};
@@ -199,7 +589,27 @@ Line bresenham_line(IVec2 p0, IVec2 p1) {
 			y0 += sy;
 		}
 	}
+	
+	return index;
+}
+
+// Diagonal steps move along both axes, so a line has one point per step
+// along its major axis
+static inline int line_point_count(IVec2 p0, IVec2 p1) {
+	int dx = abs(p1.x - p0.x);
+	int dy = abs(p1.y - p0.y);
+	return (dx > dy ? dx : dy) + 1;
+}
 
+Line bresenham_line(IVec2 p0, IVec2 p1) {
+	int capacity = line_point_count(p0, p1);
+	// POTENTIAL FIX: Every malloc needs a free
+	IVec2* points = malloc(capacity * sizeof(IVec2));
+	if (!points) {
+		return (Line){ NULL, 0 };
+	}
+	
+	int index = bresenham_fill(p0, p1, points);
 	return (Line){ points, index };
 }
 
@@ -216,17 +626,655 @@ bool point_in_triangle(Vec3 b_coordinates) {
 	return b_coordinates.x >= 0 && b_coordinates.y >= 0 && b_coordinates.z >= 0;
 }
 
+static inline bool to_subpixel(float v, Sint64 *fixed) {
+	// Also rejects NaN
+	if (!(fabsf(v) < MAX_RASTER_COORDINATE)) {
+		return false;
+	}
+	
+	*fixed = (Sint64)lrintf(v * SUBPIXEL_ONE);
+	return true;
+}
+
+bool setup_triangle(TriangleSetup *setup, Vec3 a, Vec3 b, Vec3 c) {
+	if (!setup) {
+		return false;
+	}
+	
+	Sint64 x[3], y[3];
+	if (!(to_subpixel(a.x, &x[0]) && to_subpixel(a.y, &y[0]) &&
+	      to_subpixel(b.x, &x[1]) && to_subpixel(b.y, &y[1]) &&
+	      to_subpixel(c.x, &x[2]) && to_subpixel(c.y, &y[2]))) {
+		return false;
+	}
+	
+	// Twice the signed area, in subpixel units
+	Sint64 area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+	if (area == 0) {
+		return false;
+	}
+	
+	// Depth plane through the snapped vertices, in pixel units
+	double x10 = (double)(x[1] - x[0]) / SUBPIXEL_ONE, y10 = (double)(y[1] - y[0]) / SUBPIXEL_ONE;
+	double x20 = (double)(x[2] - x[0]) / SUBPIXEL_ONE, y20 = (double)(y[2] - y[0]) / SUBPIXEL_ONE;
+	double pixel_area = x10 * y20 - x20 * y10;
+	double depth_a = ((b.z - a.z) * y20 - (c.z - a.z) * y10) / pixel_area;
+	double depth_b = ((c.z - a.z) * x10 - (b.z - a.z) * x20) / pixel_area;
+	setup->depth_a = (float)depth_a;
+	setup->depth_b = (float)depth_b;
+	setup->depth_c = (float)(a.z - depth_a * ((double)x[0] / SUBPIXEL_ONE) - depth_b * ((double)y[0] / SUBPIXEL_ONE));
+	setup->min_depth = min3(a.z, b.z, c.z);
+	setup->max_depth = max3(a.z, b.z, c.z);
+	// Swap to a single winding so the inside is where every edge function is positive
+	if (area < 0) {
+		Sint64 tmp_x = x[1], tmp_y = y[1];
+		x[1] = x[2];
+		y[1] = y[2];
+		x[2] = tmp_x;
+		y[2] = tmp_y;
+	}
+	
+	for (int i = 0; i < 3; i++) {
+		int j = (i + 1) % 3;
+		// E(p) = (v_j - v_i) x (p - v_i), sampled at pixel p = (x, y) * SUBPIXEL_ONE
+		Sint64 dx = x[j] - x[i];
+		Sint64 dy = y[j] - y[i];
+		setup->edge_a[i] = -dy * SUBPIXEL_ONE;
+		setup->edge_b[i] = dx * SUBPIXEL_ONE;
+		setup->edge_c[i] = dy * x[i] - dx * y[i];
+		
+		// Top-left rule: samples exactly on an edge belong to the triangle only for
+		// left edges (inside towards +x) and top edges (horizontal, inside towards +y)
+		bool top_left = (dy < 0) || (dy == 0 && dx > 0);
+		if (!top_left) {
+			setup->edge_c[i] -= 1;
+		}
+	}
+	
+	// Pixels whose sample lies within the subpixel bounds
+	Sint64 min_x = x[0] < x[1] ? (x[0] < x[2] ? x[0] : x[2]) : (x[1] < x[2] ? x[1] : x[2]);
+	Sint64 max_x = x[0] > x[1] ? (x[0] > x[2] ? x[0] : x[2]) : (x[1] > x[2] ? x[1] : x[2]);
+	Sint64 min_y = y[0] < y[1] ? (y[0] < y[2] ? y[0] : y[2]) : (y[1] < y[2] ? y[1] : y[2]);
+	Sint64 max_y = y[0] > y[1] ? (y[0] > y[2] ? y[0] : y[2]) : (y[1] > y[2] ? y[1] : y[2]);
+	setup->min_x = (int)((min_x + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS);
+	setup->min_y = (int)((min_y + SUBPIXEL_ONE - 1) >> SUBPIXEL_BITS);
+	setup->max_x = (int)(max_x >> SUBPIXEL_BITS);
+	setup->max_y = (int)(max_y >> SUBPIXEL_BITS);
+	return true;
+}
+
+// Floor and ceiling of n / d, for d > 0
+static inline Sint64 floor_div(Sint64 n, Sint64 d) {
+	Sint64 q = n / d;
+	return (n % d != 0 && n < 0) ? q - 1 : q;
+}
+
+static inline Sint64 ceil_div(Sint64 n, Sint64 d) {
+	return -floor_div(-n, d);
+}
+
+int rasterize_triangle_scalar(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	const Sint64 *a = setup->edge_a;
+	const Sint64 *b = setup->edge_b;
+	// Edge functions at the first pixel of the first row
+	Sint64 row_w0 = a[0] * min_x + b[0] * min_y + setup->edge_c[0];
+	Sint64 row_w1 = a[1] * min_x + b[1] * min_y + setup->edge_c[1];
+	Sint64 row_w2 = a[2] * min_x + b[2] * min_y + setup->edge_c[2];
+	
+	// Wide rows are filled as spans: each edge function is linear in x, so the
+	// covered pixels are where all three cross zero, one division per edge
+	bool spans = max_x - min_x >= SPAN_MIN_WIDTH;
+	int written = 0;
+	
+	int row_length = pitch / 4;
+	Uint32 *row = buffer + min_y * row_length;
+	for (int y = min_y; y < max_y; y++) {
+		if (spans) {
+			Sint64 row_w[3] = { row_w0, row_w1, row_w2 };
+			Sint64 first = min_x;
+			Sint64 last = max_x - 1;
+			for (int i = 0; i < 3; i++) {
+				if (a[i] > 0) {
+					Sint64 x = min_x + ceil_div(-row_w[i], a[i]);
+					first = x > first ? x : first;
+				} else if (a[i] < 0) {
+					Sint64 x = min_x + floor_div(row_w[i], -a[i]);
+					last = x < last ? x : last;
+				} else if (row_w[i] < 0) {
+					last = first - 1;
+				}
+			}
+			if (first <= last) {
+				fill_span(row, (int)first, (int)last + 1, color);
+				written += (int)(last - first + 1);
+			}
+		} else {
+			Sint64 w0 = row_w0;
+			Sint64 w1 = row_w1;
+			Sint64 w2 = row_w2;
+			for (int x = min_x; x < max_x; x++) {
+				// Sign bit of any edge function set means the pixel is outside
+				if ((w0 | w1 | w2) >= 0) {
+					row[x] = color;
+					written++;
+				}
+				w0 += a[0];
+				w1 += a[1];
+				w2 += a[2];
+			}
+		}
+		row_w0 += b[0];
+		row_w1 += b[1];
+		row_w2 += b[2];
+		row += row_length;
+	}
+	return written;
+}
+
+int rasterize_triangle_depth(Uint32 *buffer, int pitch, DepthBuffer *depth_buffer, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	if ((!buffer) || (!depth_buffer) || (!setup)) {
+		return 0;
+	}
+	
+	// Clip rectangle against the triangle bounds and the depth buffer
+	if (min_x < setup->min_x) min_x = setup->min_x;
+	if (min_y < setup->min_y) min_y = setup->min_y;
+	if (max_x > setup->max_x + 1) max_x = setup->max_x + 1;
+	if (max_y > setup->max_y + 1) max_y = setup->max_y + 1;
+	if (min_x < 0) min_x = 0;
+	if (min_y < 0) min_y = 0;
+	if (max_x > depth_buffer->width) max_x = depth_buffer->width;
+	if (max_y > depth_buffer->height) max_y = depth_buffer->height;
+	if (min_x >= max_x || min_y >= max_y) {
+		return 0;
+	}
+	
+	const Sint64 *a = setup->edge_a;
+	const Sint64 *b = setup->edge_b;
+	const Sint64 *c = setup->edge_c;
+	int row_length = pitch / 4;
+	int total_written = 0;
+	for (int block_y = min_y / DEPTH_BLOCK_SIZE; block_y <= (max_y - 1) / DEPTH_BLOCK_SIZE; block_y++) {
+		int y0 = block_y * DEPTH_BLOCK_SIZE > min_y ? block_y * DEPTH_BLOCK_SIZE : min_y;
+		int y1 = block_y * DEPTH_BLOCK_SIZE + DEPTH_BLOCK_SIZE < max_y ? block_y * DEPTH_BLOCK_SIZE + DEPTH_BLOCK_SIZE : max_y;
+		for (int block_x = min_x / DEPTH_BLOCK_SIZE; block_x <= (max_x - 1) / DEPTH_BLOCK_SIZE; block_x++) {
+			int x0 = block_x * DEPTH_BLOCK_SIZE > min_x ? block_x * DEPTH_BLOCK_SIZE : min_x;
+			int x1 = block_x * DEPTH_BLOCK_SIZE + DEPTH_BLOCK_SIZE < max_x ? block_x * DEPTH_BLOCK_SIZE + DEPTH_BLOCK_SIZE : max_x;
+			
+			// Skip blocks entirely outside an edge, testing the corner each edge increases towards
+			bool outside = false;
+			for (int i = 0; i < 3 && !outside; i++) {
+				int corner_x = a[i] > 0 ? x1 - 1 : x0;
+				int corner_y = b[i] > 0 ? y1 - 1 : y0;
+				outside = a[i] * corner_x + b[i] * corner_y + c[i] < 0;
+			}
+			if (outside) {
+				continue;
+			}
+			
+			// Nearest depth of the triangle inside the block: the plane is affine so its
+			// minimum over the block is at a corner, and it never goes below the vertices
+			float corner_depth_x = setup->depth_a > 0.0f ? (float)x0 : (float)(x1 - 1);
+			float corner_depth_y = setup->depth_b > 0.0f ? (float)y0 : (float)(y1 - 1);
+			float nearest = setup->depth_a * corner_depth_x + setup->depth_b * corner_depth_y + setup->depth_c;
+			if (nearest < setup->min_depth) {
+				nearest = setup->min_depth;
+			}
+			if (nearest >= depth_buffer->block_max_depth[block_y * depth_buffer->blocks_x + block_x]) {
+				continue;
+			}
+			
+			int written = 0;
+			for (int y = y0; y < y1; y++) {
+				Sint64 w0 = a[0] * x0 + b[0] * y + c[0];
+				Sint64 w1 = a[1] * x0 + b[1] * y + c[1];
+				Sint64 w2 = a[2] * x0 + b[2] * y + c[2];
+				float z = setup->depth_a * x0 + setup->depth_b * y + setup->depth_c;
+				Uint32 *row = buffer + y * row_length;
+				float *depth_row = depth_buffer->depth + y * depth_buffer->width;
+				for (int x = x0; x < x1; x++) {
+					if ((w0 | w1 | w2) >= 0 && z < depth_row[x]) {
+						depth_row[x] = z;
+						row[x] = color;
+						written++;
+					}
+					w0 += a[0];
+					w1 += a[1];
+					w2 += a[2];
+					z += setup->depth_a;
+				}
+			}
+			if (written) {
+				refresh_depth_block(depth_buffer, block_x, block_y);
+				total_written += written;
+			}
+		}
+	}
+	return total_written;
+}
+
+// # KERNEL SELECTION # //
+static TriangleKernel triangle_kernel = NULL;
+static RasterKernel triangle_kernel_type = RASTER_KERNEL_SCALAR;
+
+bool set_raster_kernel(RasterKernel kernel) {
+	if (!raster_kernel_supported(kernel)) {
+		return false;
+	}
+	
+	switch (kernel) {
+		case RASTER_KERNEL_SCALAR:
+			triangle_kernel = rasterize_triangle_scalar;
+			break;
+		case RASTER_KERNEL_SSE2:
+			triangle_kernel = rasterize_triangle_sse2;
+			break;
+		case RASTER_KERNEL_AVX2:
+			triangle_kernel = rasterize_triangle_avx2;
+			break;
+	}
+	triangle_kernel_type = kernel;
+	return true;
+}
+
+void init_raster_kernel() {
+	if (triangle_kernel) {
+		return;
+	}
+	
+	// AVX2 where the CPU has it: it beats scalar inside the width range
+	// rasterize_triangle sends it. SSE2 never does, it is only picked explicitly
+	if (!set_raster_kernel(RASTER_KERNEL_AVX2)) {
+		set_raster_kernel(RASTER_KERNEL_SCALAR);
+	}
+}
+
+RasterKernel get_raster_kernel() {
+	return triangle_kernel_type;
+}
+
+int rasterize_triangle(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	if ((!buffer) || (!setup)) {
+		return 0;
+	}
+	
+	// Clip rectangle against the triangle bounds
+	if (min_x < setup->min_x) min_x = setup->min_x;
+	if (min_y < setup->min_y) min_y = setup->min_y;
+	if (max_x > setup->max_x + 1) max_x = setup->max_x + 1;
+	if (max_y > setup->max_y + 1) max_y = setup->max_y + 1;
+	if (min_x >= max_x || min_y >= max_y) {
+		return 0;
+	}
+	
+	// Vector kernels use 32-bit lanes, very long edges need the 64-bit scalar path.
+	// Outside their width range scalar is faster: per-pixel loops for tiny
+	// triangles, span fills for wide ones
+	TriangleKernel kernel = triangle_kernel;
+	int width = max_x - min_x;
+	if (kernel && kernel != rasterize_triangle_scalar && width >= SIMD_MIN_WIDTH && width < SIMD_MAX_WIDTH && simd_kernel_fits(setup)) {
+		return kernel(buffer, pitch, setup, color, min_x, min_y, max_x, max_y);
+	}
+	return rasterize_triangle_scalar(buffer, pitch, setup, color, min_x, min_y, max_x, max_y);
+}
+
+// # DIRECT RASTERIZATION # //
+// These write straight into the framebuffer and never allocate
+static inline Uint32 color_to_argb(ColorRgb color) {
+	return ((Uint32)color.a << 24) | ((Uint32)color.r << 16) | ((Uint32)color.g << 8) | (Uint32)color.b;
+}
+
+static inline IVec2 viewport_to_pixel(Vec3 v) {
+	return (IVec2){ (int)v.x, (int)v.y };
+}
+
+// A Bresenham line clipped to a rectangle. Pixel k along the major axis sits
+// m(k) = round(k * minor_delta / major_delta) along the minor one, halves
+// rounded back towards p0, so the visible pixels are the consecutive steps
+// first..last and clipping never moves a pixel.
+typedef struct {
+	// Pixel at step first, and the moves along each axis
+	IVec2 start;
+	IVec2 major_step;
+	IVec2 minor_step;
+	int major_delta;
+	int minor_delta;
+	int first;
+	int last;
+	// m(first)
+	int run;
+} LineSpan;
+
+// Clips the steps k in [0, delta] of start + sign * k to [min, max)
+static bool clip_line_steps(int start, int sign, int delta, int min, int max, int *first, int *last) {
+	int low = sign > 0 ? min - start : start - (max - 1);
+	int high = sign > 0 ? max - 1 - start : start - min;
+	*first = low > 0 ? low : 0;
+	*last = high < delta ? high : delta;
+	return *first <= *last;
+}
+
+// Last step of run m, floor((2 * m + 1) * major_delta / (2 * minor_delta))
+static inline int line_run_end(int m, int major_delta, int minor_delta) {
+	return (int)((2 * (Sint64)m + 1) * major_delta / (2 * (Sint64)minor_delta));
+}
+
+static bool clip_line_span(LineSpan *span, IVec2 p0, IVec2 p1, int min_x, int min_y, int max_x, int max_y) {
+	int dx = abs(p1.x - p0.x);
+	int dy = abs(p1.y - p0.y);
+	int sx = p0.x < p1.x ? 1 : -1;
+	int sy = p0.y < p1.y ? 1 : -1;
+	
+	int first, last, first_run, last_run;
+	if (dx >= dy) {
+		span->major_step = (IVec2){ sx, 0 };
+		span->minor_step = (IVec2){ 0, sy };
+		span->major_delta = dx;
+		span->minor_delta = dy;
+		if (!clip_line_steps(p0.x, sx, dx, min_x, max_x, &first, &last) || !clip_line_steps(p0.y, sy, dy, min_y, max_y, &first_run, &last_run)) {
+			return false;
+		}
+	} else {
+		span->major_step = (IVec2){ 0, sy };
+		span->minor_step = (IVec2){ sx, 0 };
+		span->major_delta = dy;
+		span->minor_delta = dx;
+		if (!clip_line_steps(p0.y, sy, dy, min_y, max_y, &first, &last) || !clip_line_steps(p0.x, sx, dx, min_x, max_x, &first_run, &last_run)) {
+			return false;
+		}
+	}
+	
+	// The visible runs cover a range of steps, which meets the visible steps
+	if (span->minor_delta > 0) {
+		if (first_run > 0) {
+			int run_first = line_run_end(first_run - 1, span->major_delta, span->minor_delta) + 1;
+			first = run_first > first ? run_first : first;
+		}
+		int run_last = line_run_end(last_run, span->major_delta, span->minor_delta);
+		last = run_last < last ? run_last : last;
+		if (first > last) {
+			return false;
+		}
+	}
+	
+	// m(first) = ceil((2 * first * minor_delta - major_delta) / (2 * major_delta))
+	span->run = 0;
+	if (span->major_delta > 0) {
+		Sint64 numerator = 2 * (Sint64)first * span->minor_delta - span->major_delta;
+		Sint64 denominator = 2 * (Sint64)span->major_delta;
+		span->run = (int)((numerator + denominator - 1) / denominator);
+	}
+	span->first = first;
+	span->last = last;
+	span->start = (IVec2){
+		p0.x + span->major_step.x * first + span->minor_step.x * span->run,
+		p0.y + span->major_step.y * first + span->minor_step.y * span->run,
+	};
+	return true;
+}
+
+// Bresenham error of the span's first pixel, in (-2 * major_delta, 0]
+static inline int line_span_error(const LineSpan *span) {
+	return 2 * span->first * span->minor_delta - span->major_delta - 2 * span->run * span->major_delta;
+}
+
+// count pixels stride apart, horizontal runs are filled as spans
+static inline void fill_run(Uint32 *pixel, int stride, int count, Uint32 color) {
+	if (stride == 1) {
+		fill_span(pixel, 0, count, color);
+	} else if (stride == -1) {
+		fill_span(pixel, 1 - count, 1, color);
+	} else {
+		for (int i = 0; i < count; i++) {
+			*pixel = color;
+			pixel += stride;
+		}
+	}
+}
+
+int rasterize_line(Uint32 *buffer, int pitch, IVec2 p0, IVec2 p1, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	if (!buffer) {
+		return 0;
+	}
+	
+	LineSpan span;
+	if (!clip_line_span(&span, p0, p1, min_x, min_y, max_x, max_y)) {
+		return 0;
+	}
+	// One pixel per step along the major axis
+	int written = span.last - span.first + 1;
+	
+	int row_length = pitch / 4;
+	Uint32 *pixel = &buffer[span.start.y * row_length + span.start.x];
+	int major_stride = span.major_step.y * row_length + span.major_step.x;
+	int minor_stride = span.minor_step.y * row_length + span.minor_step.x;
+	
+	if (span.major_delta >= 2 * span.minor_delta) {
+		// Run-slice: every run is at least two pixels long, so step whole runs.
+		// Runs are q or q + 1 steps, the remainder decides which
+		if (span.minor_delta == 0) {
+			fill_run(pixel, major_stride, written, color);
+			return written;
+		}
+		
+		int denominator = 2 * span.minor_delta;
+		int run_steps = 2 * span.major_delta / denominator;
+		int run_remainder = 2 * span.major_delta % denominator;
+		int end = line_run_end(span.run, span.major_delta, span.minor_delta);
+		int remainder = (int)((2 * (Sint64)span.run + 1) * span.major_delta - (Sint64)end * denominator);
+		
+		int k = span.first;
+		while (k <= span.last) {
+			int run_last = end < span.last ? end : span.last;
+			fill_run(pixel, major_stride, run_last - k + 1, color);
+			pixel += (run_last - k + 1) * major_stride + minor_stride;
+			k = run_last + 1;
+			end += run_steps;
+			remainder += run_remainder;
+			if (remainder >= denominator) {
+				end++;
+				remainder -= denominator;
+			}
+		}
+		return written;
+	}
+	
+	// Short runs, step pixel by pixel
+	int error = line_span_error(&span);
+	for (int k = span.first; k <= span.last; k++) {
+		*pixel = color;
+		pixel += major_stride;
+		error += 2 * span.minor_delta;
+		if (error > 0) {
+			pixel += minor_stride;
+			error -= 2 * span.major_delta;
+		}
+	}
+	return written;
+}
+
+int rasterize_line_depth(Uint32 *buffer, int pitch, DepthBuffer *depth_buffer, IVec2 p0, IVec2 p1, float z0, float z1, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	if ((!buffer) || (!depth_buffer)) {
+		return 0;
+	}
+	if (min_x < 0) min_x = 0;
+	if (min_y < 0) min_y = 0;
+	if (max_x > depth_buffer->width) max_x = depth_buffer->width;
+	if (max_y > depth_buffer->height) max_y = depth_buffer->height;
+	
+	LineSpan span;
+	if (!clip_line_span(&span, p0, p1, min_x, min_y, max_x, max_y)) {
+		return 0;
+	}
+	
+	int row_length = pitch / 4;
+	int depth_row_length = depth_buffer->width;
+	Uint32 *pixel = &buffer[span.start.y * row_length + span.start.x];
+	float *depth = &depth_buffer->depth[span.start.y * depth_row_length + span.start.x];
+	int major_stride = span.major_step.y * row_length + span.major_step.x;
+	int minor_stride = span.minor_step.y * row_length + span.minor_step.x;
+	int depth_major_stride = span.major_step.y * depth_row_length + span.major_step.x;
+	int depth_minor_stride = span.minor_step.y * depth_row_length + span.minor_step.x;
+	
+	// Depth is linear in the step along the major axis
+	float z_step = span.major_delta > 0 ? (z1 - z0) / span.major_delta : 0.0f;
+	
+	int written = 0;
+	int error = line_span_error(&span);
+	for (int k = span.first; k <= span.last; k++) {
+		// Depth only decreases here, so the block maxima stay valid upper bounds
+		float z = z0 + z_step * k;
+		if (z < *depth) {
+			*depth = z;
+			*pixel = color;
+			written++;
+		}
+		pixel += major_stride;
+		depth += depth_major_stride;
+		error += 2 * span.minor_delta;
+		if (error > 0) {
+			pixel += minor_stride;
+			depth += depth_minor_stride;
+			error -= 2 * span.major_delta;
+		}
+	}
+	return written;
+}
+
+// Rasterizes what is binned so far, so the bin arena can be reset for the rest
+// of the frame. Only possible with a bin arena of its own, frame_arena also
+// holds the vertices being drawn
+static bool flush_bins(RenderContext *ctx) {
+	if (!ctx->bin_arena) {
+		return false;
+	}
+	
+	tile_renderer_flush(ctx->tile_renderer);
+	stats_count(ctx->stats, STAT_PIXELS_WRITTEN, tile_renderer_pixels_written(ctx->tile_renderer));
+	arena_reset(ctx->bin_arena);
+	return true;
+}
+
+// Rasterizes immediately, or bins for the tile renderer when the context has one
+// Binning counts as rasterization; binned pixels are counted when the tiles are flushed
+// Returns false when the line could not be binned
+static bool emit_line(RenderContext *ctx, ClipVertex clip_from, ClipVertex clip_to, Uint32 color) {
+	Uint64 timer = stats_start(ctx->stats);
+	Vec3 from, to;
+	bool visible = project_edge(ctx->target, clip_from, clip_to, &from, &to);
+	timer = stats_lap(ctx->stats, STAT_STAGE_CLIP, timer);
+	if (!visible) {
+		return true;
+	}
+	
+	IVec2 p0 = viewport_to_pixel(from);
+	IVec2 p1 = viewport_to_pixel(to);
+	int written = 0;
+	bool binned = true;
+	if (ctx->tile_renderer) {
+		Arena *arena = ctx->bin_arena ? ctx->bin_arena : ctx->frame_arena;
+		binned = tile_renderer_add_line(ctx->tile_renderer, arena, ctx->target, ctx->depth_buffer, ctx->scissor, p0, p1, from.z, to.z, color);
+		if ((!binned) && flush_bins(ctx)) {
+			binned = tile_renderer_add_line(ctx->tile_renderer, arena, ctx->target, ctx->depth_buffer, ctx->scissor, p0, p1, from.z, to.z, color);
+		}
+	} else if (ctx->depth_buffer) {
+		written = rasterize_line_depth(ctx->target->pixels, ctx->target->pitch, ctx->depth_buffer, p0, p1, from.z, to.z, color, ctx->scissor.min_x, ctx->scissor.min_y, ctx->scissor.max_x, ctx->scissor.max_y);
+	} else {
+		written = rasterize_line(ctx->target->pixels, ctx->target->pitch, p0, p1, color, ctx->scissor.min_x, ctx->scissor.min_y, ctx->scissor.max_x, ctx->scissor.max_y);
+	}
+	stats_lap(ctx->stats, STAT_STAGE_RASTER, timer);
+	stats_count(ctx->stats, STAT_LINES_RASTERIZED, binned);
+	stats_count(ctx->stats, STAT_PIXELS_WRITTEN, written);
+	return binned;
+}
+
+static bool emit_triangle(RenderContext *ctx, const TriangleSetup *setup, Uint32 color) {
+	Uint64 timer = stats_start(ctx->stats);
+	int written = 0;
+	bool binned = true;
+	if (ctx->tile_renderer) {
+		Arena *arena = ctx->bin_arena ? ctx->bin_arena : ctx->frame_arena;
+		binned = tile_renderer_add_triangle(ctx->tile_renderer, arena, ctx->target, ctx->depth_buffer, ctx->scissor, setup, color);
+		if ((!binned) && flush_bins(ctx)) {
+			binned = tile_renderer_add_triangle(ctx->tile_renderer, arena, ctx->target, ctx->depth_buffer, ctx->scissor, setup, color);
+		}
+	} else if (ctx->depth_buffer) {
+		written = rasterize_triangle_depth(ctx->target->pixels, ctx->target->pitch, ctx->depth_buffer, setup, color, ctx->scissor.min_x, ctx->scissor.min_y, ctx->scissor.max_x, ctx->scissor.max_y);
+	} else {
+		written = rasterize_triangle(ctx->target->pixels, ctx->target->pitch, setup, color, ctx->scissor.min_x, ctx->scissor.min_y, ctx->scissor.max_x, ctx->scissor.max_y);
+	}
+	stats_lap(ctx->stats, STAT_STAGE_RASTER, timer);
+	stats_count(ctx->stats, STAT_TRIANGLES_RASTERIZED, binned);
+	stats_count(ctx->stats, STAT_PIXELS_WRITTEN, written);
+	return binned;
+}
+
+// Clips the triangle and emits what is left as a fan
+static bool emit_clipped_triangle(RenderContext *ctx, ClipVertex a, ClipVertex b, ClipVertex c, Uint32 color) {
+	Uint64 timer = stats_start(ctx->stats);
+	Vec3 polygon[CLIP_MAX_POLYGON_VERTICES];
+	int count = project_triangle(ctx->target, a, b, c, polygon);
+	bool binned = true;
+	for (int i = 1; i + 1 < count; i++) {
+		TriangleSetup setup;
+		bool valid = setup_triangle(&setup, polygon[0], polygon[i], polygon[i + 1]);
+		stats_lap(ctx->stats, STAT_STAGE_CLIP, timer);
+		if (valid) {
+			binned &= emit_triangle(ctx, &setup, color);
+		}
+		timer = stats_start(ctx->stats);
+	}
+	stats_lap(ctx->stats, STAT_STAGE_CLIP, timer);
+	return binned;
+}
+
+static bool emit_edges(RenderContext *ctx, ClipVertex *clip_vertices, const int (*edges)[2], int edge_count, Uint32 color) {
+	bool binned = true;
+	for (int i = 0; i < edge_count; i++) {
+		binned &= emit_line(ctx, clip_vertices[edges[i][0]], clip_vertices[edges[i][1]], color);
+	}
+	return binned;
+}
+
+// Determinant of the x, y and w rows of the clip space vertices: the signed area of
+// the projected triangle times the three w, positive when it is counter-clockwise
+// on screen. Tests the winding before clipping, vertices behind the camera included
+static inline float clip_winding(Vec4 a, Vec4 b, Vec4 c) {
+	return a.x * (b.y * c.w - c.y * b.w) - b.x * (a.y * c.w - c.y * a.w) + c.x * (a.y * b.w - b.y * a.w);
+}
+
+// Back faces, and faces seen edge on, are dropped before they are clipped
+static bool emit_faces(RenderContext *ctx, ClipVertex *clip_vertices, const int (*triangles)[3], int triangle_count, Uint32 color) {
+	int culled = 0;
+	bool binned = true;
+	for (int i = 0; i < triangle_count; i++) {
+		ClipVertex a = clip_vertices[triangles[i][0]];
+		ClipVertex b = clip_vertices[triangles[i][1]];
+		ClipVertex c = clip_vertices[triangles[i][2]];
+		if (clip_winding(a.clip, b.clip, c.clip) <= 0.0f) {
+			culled++;
+			continue;
+		}
+		binned &= emit_clipped_triangle(ctx, a, b, c, color);
+	}
+	stats_count(ctx->stats, STAT_TRIANGLES_CULLED, culled);
+	return binned;
+}
+
 // ## DRAWING FUNCTIONS ## //
-bool draw_object(Uint32 *buffer, int pitch, ViewObject *object) {
-	if ((!buffer) || (!object)) {
+bool draw_object(RenderTarget *target, ViewObject *object) {
+	if ((!target) || (!object)) {
 		return false;
 	}
 	
 	Pixel *pixels = object->pixels;
 	for (int i = 0; i < object->count; i++) {
+		if (pixels[i].pos.x < 0 || pixels[i].pos.x >= target->width || pixels[i].pos.y < 0 || pixels[i].pos.y >= target->height) {
+			continue;
+		}
 		// Pixel at coordinates (x, y)
-		// (0, 0) at top left and (639, 479) at bottom right
-		buffer[pixels[i].pos.y * (pitch / 4) + pixels[i].pos.x] = (pixels[i].color.a << 24) | (pixels[i].color.r << 16) | (pixels[i].color.g << 8) | pixels[i].color.b;
+		// (0, 0) at top left and (width - 1, height - 1) at bottom right
+		target->pixels[pixels[i].pos.y * (target->pitch / 4) + pixels[i].pos.x] = (pixels[i].color.a << 24) | (pixels[i].color.r << 16) | (pixels[i].color.g << 8) | pixels[i].color.b;
 	}
 	return true;
 }
@@ -279,63 +1327,88 @@ ViewObject *object_to_view_object(Object *object, ColorRgb color) {
 }
 
 // ## GEOMETRIC FUNCTIONS ## //
-Line get_line_points(Vec3 from, Vec3 to, Camera *cam) {
-	if (!cam) {
+// Point lists come from ctx->frame_arena and stay valid until it is reset
+Line get_line_points(Vec3 from, Vec3 to, RenderContext *ctx) {
+	if (!ctx) {
 		return (Line){ NULL, 0 };
 	}
 	
-	Vec3 viewport_from = world_to_viewport(cam, vec3_homogenous(from, 1.0f));
-	Vec3 viewport_to = world_to_viewport(cam, vec3_homogenous(to, 1.0f));
-	Line line = bresenham_line((IVec2){ (int)viewport_from.x, (int)viewport_from.y}, (IVec2){ (int)viewport_to.x, (int)viewport_to.y});
+	Vec3 endpoints[2] = { from, to };
+	ClipVertex clip_vertices[2];
+	transform_vertices(ctx, endpoints, clip_vertices, 2);
+	Vec3 viewport_from, viewport_to;
+	if (!project_edge(ctx->target, clip_vertices[0], clip_vertices[1], &viewport_from, &viewport_to)) {
+		return (Line){ NULL, 0 };
+	}
+	IVec2 p0 = viewport_to_pixel(viewport_from);
+	IVec2 p1 = viewport_to_pixel(viewport_to);
 	
-	return line;
+	IVec2 *points = arena_alloc(ctx->frame_arena, line_point_count(p0, p1) * sizeof(IVec2));
+	if (!points) {
+		return (Line){ NULL, 0 };
+	}
+	
+	return (Line){ points, bresenham_fill(p0, p1, points) };
 }
 
-IVec2 *get_triangle_points(Triangle t, Camera *cam, int *point_count) {
+IVec2 *get_triangle_points(Triangle t, RenderContext *ctx, int *point_count) {
 	if (!point_count) {
 		return NULL;
 	}
-	if (!cam) {
-		*point_count = 0;
+	*point_count = 0;
+	if (!ctx) {
 		return NULL;
 	}
 	
-	// World -> Viewport coordinates
-	Vec3 a = world_to_viewport(cam, vec3_homogenous(t.vertices[0], 1.0f));
-	Vec3 b = world_to_viewport(cam, vec3_homogenous(t.vertices[1], 1.0f));
-	Vec3 c = world_to_viewport(cam, vec3_homogenous(t.vertices[2], 1.0f));
+	// World -> Clip -> Viewport coordinates, the visible part as a fan
+	ClipVertex clip_vertices[3];
+	transform_vertices(ctx, t.vertices, clip_vertices, 3);
+	Vec3 polygon[CLIP_MAX_POLYGON_VERTICES];
+	int polygon_count = project_triangle(ctx->target, clip_vertices[0], clip_vertices[1], clip_vertices[2], polygon);
 	
-	// Max Rectangular Bound
-	int min_x = (int)floorf(min3(a.x, b.x, c.x));
-	int max_x = (int)ceilf(max3(a.x, b.x, c.x));
-	int min_y = (int)floorf(min3(a.y, b.y, c.y));
-	int max_y = (int)ceilf(max3(a.y, b.y, c.y));
-	
-	// POTENTIAL FIX: Every malloc needs a free...
-	int capacity = (max_x - min_x + 1) * (max_y - min_y + 1);
-	IVec2 *points = malloc(capacity * sizeof(IVec2));
+	// Max Rectangular Bound of every fan triangle
+	int capacity = 0;
+	for (int i = 1; i + 1 < polygon_count; i++) {
+		Vec3 a = polygon[0];
+		Vec3 b = polygon[i];
+		Vec3 c = polygon[i + 1];
+		capacity += ((int)ceilf(max3(a.x, b.x, c.x)) - (int)floorf(min3(a.x, b.x, c.x)) + 1) * ((int)ceilf(max3(a.y, b.y, c.y)) - (int)floorf(min3(a.y, b.y, c.y)) + 1);
+	}
+	if (capacity == 0) {
+		return NULL;
+	}
+	IVec2 *points = arena_alloc(ctx->frame_arena, capacity * sizeof(IVec2));
 	if (!points) {
-		*point_count = 0;
 		return NULL;
 	}
 	
-	Vec2 a_pixel = { a.x, a.y };
-	Vec2 b_pixel = { b.x, b.y };
-	Vec2 c_pixel = { c.x, c.y };
-	Vec3 b_coordinates = { 0.0f, 0.0f, 0.0f };
 	int index = 0;
-	for (int x = min_x; x < max_x; x++) {
-		for (int y = min_y; y < max_y; y++) {
-			b_coordinates = barycentric_coordinates(
-				a_pixel, b_pixel, c_pixel,
-				(Vec2){ (float)x, (float)y }
-			);
-			
-			if (point_in_triangle(b_coordinates)) {
-				// POTENTIAL FIX: This is in case of barycentric rounding error...
-				if (index < capacity) {
-					points[index] = (IVec2){ x, y };
-					index++;
+	for (int i = 1; i + 1 < polygon_count; i++) {
+		Vec3 a = polygon[0];
+		Vec3 b = polygon[i];
+		Vec3 c = polygon[i + 1];
+		int min_x = (int)floorf(min3(a.x, b.x, c.x));
+		int max_x = (int)ceilf(max3(a.x, b.x, c.x));
+		int min_y = (int)floorf(min3(a.y, b.y, c.y));
+		int max_y = (int)ceilf(max3(a.y, b.y, c.y));
+		
+		Vec2 a_pixel = { a.x, a.y };
+		Vec2 b_pixel = { b.x, b.y };
+		Vec2 c_pixel = { c.x, c.y };
+		Vec3 b_coordinates = { 0.0f, 0.0f, 0.0f };
+		for (int x = min_x; x < max_x; x++) {
+			for (int y = min_y; y < max_y; y++) {
+				b_coordinates = barycentric_coordinates(
+					a_pixel, b_pixel, c_pixel,
+					(Vec2){ (float)x, (float)y }
+				);
+				
+				if (point_in_triangle(b_coordinates)) {
+					// POTENTIAL FIX: This is in case of barycentric rounding error...
+					if (index < capacity) {
+						points[index] = (IVec2){ x, y };
+						index++;
+					}
 				}
 			}
 		}
@@ -345,185 +1418,324 @@ IVec2 *get_triangle_points(Triangle t, Camera *cam, int *point_count) {
 	return points;
 }
 
-IVec2 *get_tetrahedron_points(Tetrahedron th, Camera *cam, int *point_count) {
-	if (!point_count) {
-		return NULL;
-	}
-	if (!cam) {
-		*point_count = 0;
-		return NULL;
-	}
-	
-	// POTENTIAL FIX: Every malloc needs a free...
-	Line *edges = malloc(6 * sizeof(Line));
-	if (!edges) {
-		*point_count = 0;
-		return NULL;
-	}
-	
+// Rasterizes the visible part of the indexed edges into one point list allocated from the frame arena
+static IVec2 *get_edge_points(RenderContext *ctx, ClipVertex *clip_vertices, const int (*edges)[2], int edge_count, int *point_count) {
+	// Exact size first, so the points are written once into a single block
+	Vec3 from, to;
 	int total_point_count = 0;
-	for (int i = 0; i < 6; i++) {
-		edges[i] = get_line_points(th.vertices[th.edges[i][0]], th.vertices[th.edges[i][1]], cam);
-		total_point_count += edges[i].count;
+	for (int i = 0; i < edge_count; i++) {
+		if (project_edge(ctx->target, clip_vertices[edges[i][0]], clip_vertices[edges[i][1]], &from, &to)) {
+			total_point_count += line_point_count(viewport_to_pixel(from), viewport_to_pixel(to));
+		}
 	}
 	
-	IVec2 *points = malloc(total_point_count * sizeof(IVec2));
+	IVec2 *points = arena_alloc(ctx->frame_arena, total_point_count * sizeof(IVec2));
 	if (!points) {
-		destroy_lines(edges, 6);
 		*point_count = 0;
 		return NULL;
 	}
 	
 	int index = 0;
-	for (int i = 0; i < 6; i++) {
-		for (int j = 0; j < edges[i].count; j++) {
-			points[index] = edges[i].points[j];
-			index++;
+	for (int i = 0; i < edge_count; i++) {
+		if (project_edge(ctx->target, clip_vertices[edges[i][0]], clip_vertices[edges[i][1]], &from, &to)) {
+			index += bresenham_fill(viewport_to_pixel(from), viewport_to_pixel(to), points + index);
 		}
 	}
 	
-	destroy_lines(edges, 6);
 	*point_count = index;
 	return points;
 }
 
-Line *get_cube_edges(Cube cube, Camera *cam) {
-	if (!cam) {
+IVec2 *get_tetrahedron_points(Tetrahedron th, RenderContext *ctx, int *point_count) {
+	if (!point_count) {
 		return NULL;
 	}
-	// POTENTIAL FIX: Every malloc needs a free...
-	Line *edges = malloc(12 * sizeof(Line));
-	if (!edges) {
+	if (!ctx) {
+		*point_count = 0;
 		return NULL;
 	}
 	
-	// Convert to viewport coordinates
-	Vec3 viewport_vertices[8];
-	for (int i = 0; i < 8; i++) {
-		viewport_vertices[i] = world_to_viewport(cam, vec3_homogenous(cube.vertices[i], 1.0f));
+	// Each vertex is shared by three edges, transform them once
+	ClipVertex clip_vertices[4];
+	transform_vertices(ctx, th.vertices, clip_vertices, 4);
+	
+	return get_edge_points(ctx, clip_vertices, (const int (*)[2])th.edges, 6, point_count);
+}
+
+Line *get_cube_edges(Cube cube, RenderContext *ctx) {
+	if (!ctx) {
+		return NULL;
 	}
+	Line *edges = arena_alloc(ctx->frame_arena, 12 * sizeof(Line));
+	if (!edges) {
+		return NULL;
+	}
+	
+	// Convert to clip coordinates
+	ClipVertex clip_vertices[8];
+	transform_vertices(ctx, cube.vertices, clip_vertices, 8);
 	
-	// Construct the edges of the cube
+	// Construct the edges of the cube, edges outside the view volume are left empty
 	for (int i = 0; i < 12; i++) {
-		Vec3 from_vector = viewport_vertices[cube.edges[i][0]];
-		Vec3 to_vector = viewport_vertices[cube.edges[i][1]];
+		Vec3 from, to;
+		if (!project_edge(ctx->target, clip_vertices[cube.edges[i][0]], clip_vertices[cube.edges[i][1]], &from, &to)) {
+			edges[i] = (Line){ NULL, 0 };
+			continue;
+		}
+		IVec2 from_pixel = viewport_to_pixel(from);
+		IVec2 to_pixel = viewport_to_pixel(to);
+		IVec2 *points = arena_alloc(ctx->frame_arena, line_point_count(from_pixel, to_pixel) * sizeof(IVec2));
+		if (!points) {
+			return NULL;
+		}
 		// edges[i] is equivalent to *(edges + i)
-		edges[i] = bresenham_line((IVec2){ (int)from_vector.x, (int)from_vector.y }, (IVec2){ (int)to_vector.x, (int)to_vector.y });
+		edges[i] = (Line){ points, bresenham_fill(from_pixel, to_pixel, points) };
 	}
 	
 	return edges;
 }
 
-IVec2 *get_cube_points(Cube cube, Camera *cam, int *point_count) {
+IVec2 *get_cube_points(Cube cube, RenderContext *ctx, int *point_count) {
 	if (!point_count) {
 		return NULL;
 	}
-	if (!cam) {
+	if (!ctx) {
 		*point_count = 0;
 		return NULL;
 	}
-	// Every malloc
-	Line *edges = get_cube_edges(cube, cam);
-	if (!edges) {
-		*point_count = 0;
-		return NULL;
+	
+	ClipVertex clip_vertices[8];
+	transform_vertices(ctx, cube.vertices, clip_vertices, 8);
+	
+	return get_edge_points(ctx, clip_vertices, (const int (*)[2])cube.edges, 12, point_count);
+}
+
+bool draw_line(RenderContext *ctx, Vec3 from, Vec3 to, ColorRgb color) {
+	if ((!ctx) || (!ctx->target)) {
+		return false;
 	}
 	
-	int total_points = 0;
-	for (int i = 0; i < 12; i++) {
-		total_points += edges[i].count;
+	Vec3 endpoints[2] = { from, to };
+	ClipVertex clip_vertices[2];
+	transform_vertices(ctx, endpoints, clip_vertices, 2);
+	return emit_line(ctx, clip_vertices[1], clip_vertices[0], color_to_argb(color));
+}
+
+bool draw_triangle(RenderContext *ctx, Triangle t, ColorRgb color) {
+	if (!(ctx && ctx->target)) {
+		return false;
 	}
-	// POTENTIAL FIX: Every malloc needs a free...
-	IVec2 *points = malloc(total_points * sizeof(IVec2));
 	
-	if (!points) {
-		// Needs a free
-		destroy_lines(edges, 12);
-		*point_count = 0;
-		return NULL;
+	ClipVertex clip_vertices[3];
+	transform_vertices(ctx, t.vertices, clip_vertices, 3);
+	return emit_clipped_triangle(ctx, clip_vertices[0], clip_vertices[1], clip_vertices[2], color_to_argb(color));
+}
+
+bool draw_tetrahedron(RenderContext *ctx, Tetrahedron th, ColorRgb color) {
+	if (!(ctx && ctx->target)) {
+		return false;
 	}
 	
-	int index = 0;
-	for (int i = 0; i < 12; i++) {
-		for (int j = 0; j < edges[i].count; j++) {
-			points[index] = edges[i].points[j];
-			index++;
-		}
+	if (!vertices_visible(ctx, th.vertices, 4)) {
+		return true;
 	}
 	
-	destroy_lines(edges, 12);
-	*point_count = index;
-	return points;
+	ClipVertex clip_vertices[4];
+	transform_vertices(ctx, th.vertices, clip_vertices, 4);
+	return emit_edges(ctx, clip_vertices, (const int (*)[2])th.edges, 6, color_to_argb(color));
 }
 
-bool draw_line(Uint32 *buffer, Camera *cam, Vec3 from, Vec3 to, ColorRgb color, int pitch) {
-	if ((!buffer) || (!cam)) {
+bool draw_cube(RenderContext *ctx, Cube cube, ColorRgb color) {
+	if (!(ctx && ctx->target)) {
 		return false;
 	}
 	
-	Line line = get_line_points(to, from, cam);
-	if (!line.points) {
-		return false;
+	if (!vertices_visible(ctx, cube.vertices, 8)) {
+		return true;
 	}
-	Object *object = points_to_object(line.points, line.count);
-	if (!object) {
+	
+	ClipVertex clip_vertices[8];
+	transform_vertices(ctx, cube.vertices, clip_vertices, 8);
+	return emit_edges(ctx, clip_vertices, (const int (*)[2])cube.edges, 12, color_to_argb(color));
+}
+
+bool draw_filled_tetrahedron(RenderContext *ctx, Tetrahedron th, ColorRgb color) {
+	if (!(ctx && ctx->target)) {
 		return false;
 	}
-	ViewObject *view_object = object_to_view_object(object, color);
-	if (!view_object) {
+	
+	if (!vertices_visible(ctx, th.vertices, 4)) {
+		return true;
+	}
+	
+	// Each face is wound away from the vertex opposite it, the tetrahedron may be given either way round
+	int faces[4][3];
+	for (int i = 0; i < 4; i++) {
+		int a = (i + 1) % 4;
+		int b = (i + 2) % 4;
+		int c = (i + 3) % 4;
+		Vec3 normal = vec3_cross_product(vec3_sub(th.vertices[b], th.vertices[a]), vec3_sub(th.vertices[c], th.vertices[a]));
+		bool inward = vec3_dot_product(normal, vec3_sub(th.vertices[i], th.vertices[a])) > 0.0f;
+		faces[i][0] = a;
+		faces[i][1] = inward ? c : b;
+		faces[i][2] = inward ? b : c;
+	}
+	
+	ClipVertex clip_vertices[4];
+	transform_vertices(ctx, th.vertices, clip_vertices, 4);
+	return emit_faces(ctx, clip_vertices, (const int (*)[3])faces, 4, color_to_argb(color));
+}
+
+bool draw_filled_cube(RenderContext *ctx, FilledCube filled_cube, ColorRgb color) {
+	if (!(ctx && ctx->target)) {
 		return false;
 	}
 	
-	return draw_object(buffer, pitch, view_object);
+	if (!vertices_visible(ctx, filled_cube.cube.vertices, 8)) {
+		return true;
+	}
+	
+	// The faces carry their own vertices, three apiece
+	static const int face_vertices[12][3] = {
+		{ 0, 1, 2 }, { 3, 4, 5 }, { 6, 7, 8 }, { 9, 10, 11 },
+		{ 12, 13, 14 }, { 15, 16, 17 }, { 18, 19, 20 }, { 21, 22, 23 },
+		{ 24, 25, 26 }, { 27, 28, 29 }, { 30, 31, 32 }, { 33, 34, 35 }
+	};
+	ClipVertex clip_vertices[36];
+	transform_vertices(ctx, &filled_cube.t_faces[0].vertices[0], clip_vertices, 36);
+	return emit_faces(ctx, clip_vertices, face_vertices, 12, color_to_argb(color));
 }
 
-bool draw_triangle(Uint32 *buffer, Camera *cam, Triangle t, ColorRgb color, int pitch) {
-	if (!(buffer && cam)) {
+bool draw_mesh(RenderContext *ctx, const Mesh *mesh, ColorRgb color) {
+	if (!(ctx && ctx->target && mesh)) {
 		return false;
 	}
 	
-	int npoints;
-	IVec2 *points = get_triangle_points(t, cam, &npoints);
-	Object *object = points_to_object(points, npoints);
-	ViewObject *view_object = object_to_view_object(object, color);
+	if (mesh->bounds_radius >= 0.0f && !sphere_visible(ctx, mesh->bounds_center, mesh->bounds_radius)) {
+		return true;
+	}
 	
-	if (!(points && object && view_object)) {
+	// Every edge reads its endpoints from the shared post-transform cache
+	ClipVertex *clip_vertices = transform_mesh(ctx, mesh);
+	if (!clip_vertices) {
 		return false;
 	}
 	
-	return draw_object(buffer, pitch, view_object);
+	return emit_edges(ctx, clip_vertices, (const int (*)[2])mesh->edges, mesh->edge_count, color_to_argb(color));
 }
 
-bool draw_tetrahedron(Uint32 *buffer, Camera *cam, Tetrahedron th, ColorRgb color, int pitch) {
-	if (!(buffer && cam)) {
+bool draw_filled_mesh(RenderContext *ctx, const Mesh *mesh, ColorRgb color) {
+	if (!(ctx && ctx->target && mesh)) {
 		return false;
 	}
 	
-	int npoints;
-	IVec2 *points = get_tetrahedron_points(th, cam, &npoints);
-	Object *object = points_to_object(points, npoints);
-	ViewObject *view_object = object_to_view_object(object, color);
+	if (mesh->bounds_radius >= 0.0f && !sphere_visible(ctx, mesh->bounds_center, mesh->bounds_radius)) {
+		return true;
+	}
 	
-	if (!(points && object && view_object)) {
+	ClipVertex *clip_vertices = transform_mesh(ctx, mesh);
+	if (!clip_vertices) {
 		return false;
 	}
 	
-	return draw_object(buffer, pitch, view_object);
+	return emit_faces(ctx, clip_vertices, (const int (*)[3])mesh->triangles, mesh->triangle_count, color_to_argb(color));
 }
 
-bool draw_cube(Uint32 *buffer, Camera *cam, Cube cube, ColorRgb color, int pitch) {
-	if (!(buffer && cam)) {
+int mesh_lod_level(RenderContext *ctx, const MeshLod *lod) {
+	if (!(ctx && ctx->target && lod && lod->level_count > 0)) {
+		return -1;
+	}
+	
+	const Mesh *full = lod->levels[0];
+	if (full->bounds_radius < 0.0f) {
+		return 0;
+	}
+	float radius = projected_radius(ctx, full->bounds_center, full->bounds_radius);
+	if (radius < LOD_POINT_RADIUS) {
+		return lod->level_count;
+	}
+	// The finest level whose triangles each get enough of the covered pixels
+	float triangle_budget = 3.14159265f * radius * radius / LOD_PIXELS_PER_TRIANGLE;
+	int level = 0;
+	while (level + 1 < lod->level_count && lod->levels[level]->triangle_count > triangle_budget) {
+		level++;
+	}
+	return level;
+}
+
+static bool draw_lod(RenderContext *ctx, const MeshLod *lod, ColorRgb color, bool filled) {
+	if (!(ctx && ctx->target && lod && lod->level_count > 0)) {
+		return false;
+	}
+	
+	const Mesh *full = lod->levels[0];
+	if (full->bounds_radius >= 0.0f && !sphere_visible(ctx, full->bounds_center, full->bounds_radius)) {
+		return true;
+	}
+	
+	int level = mesh_lod_level(ctx, lod);
+	if (level == lod->level_count) {
+		// A line from the center to itself is a single depth tested pixel
+		ClipVertex center;
+		transform_vertices(ctx, &full->bounds_center, &center, 1);
+		return emit_line(ctx, center, center, color_to_argb(color));
+	}
+	return filled ? draw_filled_mesh(ctx, lod->levels[level], color) : draw_mesh(ctx, lod->levels[level], color);
+}
+
+bool draw_mesh_lod(RenderContext *ctx, const MeshLod *lod, ColorRgb color) {
+	return draw_lod(ctx, lod, color, false);
+}
+
+bool draw_filled_mesh_lod(RenderContext *ctx, const MeshLod *lod, ColorRgb color) {
+	return draw_lod(ctx, lod, color, true);
+}
+
+bool draw_mesh_instanced(RenderContext *ctx, const Mesh *mesh, const Matrix4 *model_matrices, const ColorRgb *colors, int instance_count) {
+	if (!(ctx && ctx->target && mesh && model_matrices && colors)) {
 		return false;
 	}
-	// Get screen points of the cube
-	int npoints;
-	IVec2 *points = get_cube_points(cube, cam, &npoints);
-	Object *object = points_to_object(points, npoints);
-	ViewObject *view_object = object_to_view_object(object, color);
+	if (instance_count <= 0 || mesh->vertex_count == 0) {
+		return true;
+	}
 	
-	if (!(points && object && view_object)) {
+	// One buffer for every batch, the tile renderer copies what it bins out of it
+	// Batches shrink to what the arena has left, down to one instance at a time
+	size_t instance_bytes = (size_t)mesh->vertex_count * sizeof(ClipVertex);
+	size_t available = arena_remaining(ctx->frame_arena);
+	if (!ctx->bin_arena) {
+		// Half of it stays free for the bins
+		available /= 2;
+	}
+	int batch_size = instance_count < INSTANCE_BATCH ? instance_count : INSTANCE_BATCH;
+	if ((size_t)batch_size > available / instance_bytes) {
+		batch_size = available / instance_bytes > 1 ? (int)(available / instance_bytes) : 1;
+	}
+	ClipVertex *clip_vertices = arena_alloc(ctx->frame_arena, (size_t)batch_size * mesh->vertex_count * sizeof(ClipVertex));
+	if (!clip_vertices) {
 		return false;
 	}
 	
-	return draw_object(buffer, pitch, view_object);
-}
\ No newline at end of file
+	int visible_instances[INSTANCE_BATCH];
+	bool binned = true;
+	for (int start = 0; start < instance_count; start += batch_size) {
+		int end = start + batch_size < instance_count ? start + batch_size : instance_count;
+		
+		// Transform pass: the vertices of every instance left after culling, back to back
+		int visible_count = 0;
+		for (int i = start; i < end; i++) {
+			set_model_matrix(ctx, model_matrices[i]);
+			if (mesh->bounds_radius >= 0.0f && !sphere_visible(ctx, mesh->bounds_center, mesh->bounds_radius)) {
+				continue;
+			}
+			transform_vertices_soa(ctx, mesh->x, mesh->y, mesh->z, clip_vertices + (size_t)visible_count * mesh->vertex_count, mesh->vertex_count);
+			visible_instances[visible_count++] = i;
+		}
+		
+		// Raster pass: the shared edge list over each instance's vertices
+		for (int k = 0; k < visible_count; k++) {
+			binned &= emit_edges(ctx, clip_vertices + (size_t)k * mesh->vertex_count, (const int (*)[2])mesh->edges, mesh->edge_count, color_to_argb(colors[visible_instances[k]]));
+		}
+	}
+	return binned;
+}
@@ -1,6 +1,26 @@
+#ifndef GRAPHICS_H
+#define GRAPHICS_H
+
 #include <SDL2/SDL.h>
 #include <stdbool.h>
 #include "linalg.h"
+#include "arena.h"
+#include "mesh.h"
+#include "depth.h"
+#include "clip.h"
+#include "dirty.h"
+#include "framebuffer.h"
+#include "stats.h"
+
+// ### CONSTANTS ### //
+// Lens of a camera nothing else is known about
+#define DEFAULT_FIELD_OF_VIEW 0.785f
+#define DEFAULT_NEAR_PLANE 0.1f
+#define DEFAULT_FAR_PLANE 1000.0f
+// Scratch memory for the intermediate geometry of one frame, see frame_arena_size
+#define FRAME_ARENA_SIZE (16 * 1024 * 1024)
+// Tile bins; when a frame bins more, what is binned so far is rasterized and the arena reused
+#define BIN_ARENA_SIZE (16 * 1024 * 1024)
 
 // ### STRUCTS  AND ENUMS ### //
 // ## STRUCTS ## //
@@ -8,6 +28,11 @@ typedef struct {
 	Vec3 eye;
 	Vec3 center;
 	Vec3 up_direction;
+	// Vertical, in radians
+	float field_of_view;
+	// Distances to the clip planes
+	float near_plane;
+	float far_plane;
 } Camera;
 
 typedef struct {
@@ -51,6 +76,35 @@ typedef struct {
 	Vec3 vertices[3];
 } Triangle;
 
+// Placement of an object, the model vertices themselves never change
+typedef struct {
+	Vec3 position;
+	// Euler angles in radians, applied about x, then y, then z
+	Vec3 rotation;
+	float scale;
+} Transform;
+
+// Screen-space triangle prepared for half-space rasterization
+// Edge function i at pixel (x, y) is edge_a[i] * x + edge_b[i] * y + edge_c[i],
+// a pixel is covered when all three are >= 0 (top-left rule folded into edge_c)
+typedef struct {
+	Sint64 edge_a[3];
+	Sint64 edge_b[3];
+	Sint64 edge_c[3];
+	// Depth plane depth_a * x + depth_b * y + depth_c; normalized device depth is
+	// affine in screen space, so this is the perspective-correct depth
+	float depth_a;
+	float depth_b;
+	float depth_c;
+	float min_depth;
+	float max_depth;
+	// Inclusive pixel bounding box
+	int min_x;
+	int min_y;
+	int max_x;
+	int max_y;
+} TriangleSetup;
+
 typedef struct {
 	Vec3 vertices[4];
 	int edges[6][2];
@@ -66,6 +120,50 @@ typedef struct {
 	Triangle t_faces[12];
 } FilledCube;
 
+// Vertex after the view-projection transform
+// viewport is only filled in when outcode is 0, clipped edges are divided later
+typedef struct {
+	Vec4 clip;
+	Vec3 viewport;
+	int outcode;
+} ClipVertex;
+
+// Defined in tiler.h
+typedef struct TileRenderer TileRenderer;
+
+// Per-frame transform state, rebuilt only when the camera or the target size changes
+typedef struct {
+	Camera cam;
+	// Draw calls write its pixels, and the projection follows its aspect ratio
+	RenderTarget *target;
+	// Target size the projection was built for
+	int viewport_width;
+	int viewport_height;
+	Matrix4 view_matrix;
+	Matrix4 projection_matrix;
+	Matrix4 view_projection_matrix;
+	// Model matrix of the following draw calls, folded into the view-projection
+	Matrix4 model_matrix;
+	Matrix4 model_view_projection_matrix;
+	// Largest axis scale of the model matrix, for bounding sphere radii
+	float model_scale;
+	// World space planes of the view volume, for culling bounding spheres
+	Frustum frustum;
+	// Scratch memory for intermediate geometry, reset once per frame
+	Arena *frame_arena;
+	// When set, draw calls are binned and rasterized in parallel by tile_renderer_flush
+	TileRenderer *tile_renderer;
+	// Holds only the bins when set, otherwise they come from frame_arena. Once it is
+	// full, draw calls flush the tile renderer, reset it and bin the rest of the frame
+	Arena *bin_arena;
+	// When set, draw calls are depth tested against it and write to it
+	DepthBuffer *depth_buffer;
+	// Draw calls only write pixels inside it, the whole target by default
+	ScreenRect scissor;
+	// When set, draw calls time their stages and count their work into it
+	FrameStats *stats;
+} RenderContext;
+
 // ## ENUMS ## //
 typedef enum {
 	TETRAHEDRON,
@@ -75,6 +173,15 @@ typedef enum {
 	ICOSAHEDRON,
 } PlatonicSolid;
 
+typedef enum {
+	RASTER_KERNEL_SCALAR,
+	RASTER_KERNEL_SSE2,
+	RASTER_KERNEL_AVX2,
+} RasterKernel;
+
+// Fills the covered pixels of an already clipped rectangle, returns how many
+typedef int (*TriangleKernel)(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+
 
 // ### FUNCTION DECLARATIONS ### //
 
@@ -84,32 +191,129 @@ void destroy_lines(Line* lines, int count);
 
 Tetrahedron create_tetrahedron(Vec3 center, float side_length);
 Cube create_cube(Vec3 center, float side_length);
+// The cube, and its sides as triangles counter-clockwise from outside
+FilledCube create_filled_cube(Vec3 center, float side_length);
+
+// Indexed meshes of the solids, free with destroy_mesh
+Mesh *mesh_from_tetrahedron(Tetrahedron th);
+Mesh *mesh_from_cube(Cube cube);
+Mesh *create_platonic_mesh(PlatonicSolid solid, Vec3 center, float side_length);
+
+// ## RENDER CONTEXT ## //
+void init_render_context(RenderContext *ctx, Camera *cam, RenderTarget *target, Arena *frame_arena);
+// Returns whether the camera or the target size changed and the cached matrices were rebuilt
+// A resize also resets the scissor to the whole target
+bool update_render_context(RenderContext *ctx, Camera *cam);
+// Model matrix for the following draw calls, the identity until set
+// Composed with the view-projection once here instead of once per vertex
+void set_model_matrix(RenderContext *ctx, Matrix4 model_matrix);
+// Scale, then rotation about x, y and z, then translation
+Matrix4 transform_matrix(Transform transform);
 
 // ## MATRIX TRANSFORMATIONS ## //
 Matrix4 gen_view_matrix(Camera *cam);
-Matrix4 gen_perspective_projection_matrix();
+Matrix4 gen_perspective_projection_matrix(Camera *cam, float aspect_ratio);
 
 Vec3 perspective_divide(Vec4 v);
-Vec3 viewport_transform(Vec3 v);
+// Normalized device coordinates to the target's pixels
+Vec3 viewport_transform(const RenderTarget *target, Vec3 v);
 
-Vec3 world_to_viewport(Camera *cam, Vec4 v);
+// Model space points go through the cached model-view-projection
+// No clipping, only for points known to be in front of the camera
+Vec3 world_to_viewport(RenderContext *ctx, Vec4 v);
+void world_to_viewport_batch(RenderContext *ctx, const Vec3 *vertices, Vec3 *viewport_vertices, int count);
+// Same, into clip space with the outcodes, for geometry that may need clipping
+void transform_vertices(RenderContext *ctx, const Vec3 *vertices, ClipVertex *clip_vertices, int count);
+void transform_vertices_soa(RenderContext *ctx, const float *x, const float *y, const float *z, ClipVertex *clip_vertices, int count);
+// Post-transform vertex cache: every vertex of the mesh transformed once, from the frame arena
+ClipVertex *transform_mesh(RenderContext *ctx, const Mesh *mesh);
+// FRAME_ARENA_SIZE plus room for transform_mesh of the mesh, when there is one
+size_t frame_arena_size(const Mesh *mesh);
+// Whether any of the model space sphere can be inside the view volume
+bool sphere_visible(RenderContext *ctx, Vec3 center, float radius);
+// Radius in pixels of the model space sphere once projected, through the same
+// model-view-projection as world_to_viewport. Larger than the target when the
+// camera is inside the sphere
+float projected_radius(RenderContext *ctx, Vec3 center, float radius);
+// Pixels that drawing anything spanned by the model space points can touch,
+// empty when they are culled, the whole target when they cross the near plane
+ScreenRect screen_bounds(RenderContext *ctx, const Vec3 *vertices, int count);
 
 
 // ## DRAWING  ALGORITHMS ## //
 // Input: integer approximation of the (x, y) components in viewport coordinates
 // "pixel coordinates"
 Line bresenham_line(IVec2 p0, IVec2 p1);
+// Writes the Bresenham line straight into the buffer, only inside [min_x, max_x) x [min_y, max_y).
+// The line is clipped to the rectangle up front and shallow lines are drawn a run at a time
+// The rasterizers return the number of pixels written
+int rasterize_line(Uint32 *buffer, int pitch, IVec2 p0, IVec2 p1, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+// Same, with depth linearly interpolated from z0 to z1, tested and written per pixel
+int rasterize_line_depth(Uint32 *buffer, int pitch, DepthBuffer *depth_buffer, IVec2 p0, IVec2 p1, float z0, float z1, Uint32 color, int min_x, int min_y, int max_x, int max_y);
 // Input: viewport coordinates
 // Returns whether a point is to the left of the side v1 to v2
 Vec3 barycentric_coordinates(Vec2 a, Vec2 b, Vec2 c, Vec2 point);
 bool point_in_triangle(Vec3 b_coordinates);
+// Input: viewport coordinates, either winding
+// Returns false for degenerate triangles or ones outside the fixed-point range
+bool setup_triangle(TriangleSetup *setup, Vec3 a, Vec3 b, Vec3 c);
+// Fills the covered pixels inside [min_x, max_x) x [min_y, max_y), row by row,
+// with the selected coverage kernel
+int rasterize_triangle(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+
+// Depth tested version, walks DEPTH_BLOCK_SIZE blocks and skips the ones the
+// depth buffer already has closer geometry in everywhere
+int rasterize_triangle_depth(Uint32 *buffer, int pitch, DepthBuffer *depth_buffer, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+
+// # TRIANGLE COVERAGE KERNELS # //
+// Input: rectangle already clipped to the triangle bounds
+// All kernels produce identical coverage
+int rasterize_triangle_scalar(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+int rasterize_triangle_sse2(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+int rasterize_triangle_avx2(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y);
+// Whether the vector kernels can hold this triangle's edge steps in 32-bit lanes
+bool simd_kernel_fits(const TriangleSetup *setup);
+bool raster_kernel_supported(RasterKernel kernel);
+// Picks AVX2 if the CPU supports it, else scalar, unless a kernel is already set.
+// Called from the main thread by init_render_context and create_tile_renderer,
+// tile workers only read the selection
+void init_raster_kernel();
+// Triangles too small, too wide or too large for the vector kernels still go to scalar
+bool set_raster_kernel(RasterKernel kernel);
+RasterKernel get_raster_kernel();
 
 // ## DRAWING FUNCTIONS ## //
-bool draw_object(Uint32 *buffer, int pitch, ViewObject* object);
-bool draw_line(Uint32 *buffer, Camera *cam, Vec3 from, Vec3 to, ColorRgb Color, int pitch);
-bool draw_triangle(Uint32 *buffer, Camera *cam, Triangle t, ColorRgb color, int pitch);
-bool draw_tetrahedron(Uint32 *buffer, Camera *cam, Tetrahedron th, ColorRgb color, int pitch);
-bool draw_cube(Uint32 *buffer, Camera *cam, Cube cube, ColorRgb color, int pitch);
+// Pixels outside the target are skipped
+bool draw_object(RenderTarget *target, ViewObject* object);
+// These draw into ctx->target
+// They return false when a primitive could not be binned, even after a flush of
+// ctx->bin_arena; the rest of the draw call is still drawn
+bool draw_line(RenderContext *ctx, Vec3 from, Vec3 to, ColorRgb Color);
+bool draw_triangle(RenderContext *ctx, Triangle t, ColorRgb color);
+bool draw_tetrahedron(RenderContext *ctx, Tetrahedron th, ColorRgb color);
+bool draw_cube(RenderContext *ctx, Cube cube, ColorRgb color);
+// Objects are culled by their bounding sphere, then every primitive is clipped
+// to the view volume before the perspective divide
+// Wireframe of the mesh edges
+bool draw_mesh(RenderContext *ctx, const Mesh *mesh, ColorRgb color);
+// Solids: triangles that are clockwise on screen face away from the camera and
+// are culled before clipping. Closed solids only, they need a depth buffer to
+// draw over each other correctly
+bool draw_filled_tetrahedron(RenderContext *ctx, Tetrahedron th, ColorRgb color);
+bool draw_filled_cube(RenderContext *ctx, FilledCube filled_cube, ColorRgb color);
+bool draw_filled_mesh(RenderContext *ctx, const Mesh *mesh, ColorRgb color);
+// Level of detail picked from the projected size of the full mesh's bounds: the
+// finest level with few enough triangles for the pixels it covers. Returns
+// lod->level_count when it covers less than a pixel, -1 on bad input
+int mesh_lod_level(RenderContext *ctx, const MeshLod *lod);
+// The picked level as draw_mesh or draw_filled_mesh would, or a single pixel at
+// the center of the bounds when it covers less than one
+bool draw_mesh_lod(RenderContext *ctx, const MeshLod *lod, ColorRgb color);
+bool draw_filled_mesh_lod(RenderContext *ctx, const MeshLod *lod, ColorRgb color);
+// The mesh once per model matrix, in the matching color: batches of instances
+// are culled and transformed in one pass, then drawn from the shared edge list
+// The model matrix of the last instance is left set
+bool draw_mesh_instanced(RenderContext *ctx, const Mesh *mesh, const Matrix4 *model_matrices, const ColorRgb *colors, int instance_count);
 
 // ## DRAWING UTILS ## //
 Object *points_to_object(IVec2 *points, int count);
@@ -117,10 +321,13 @@ Pixel ivec2_to_pixel(IVec2 v, ColorRgb color);
 ViewObject *object_to_view_object(Object *object, ColorRgb color);
 
 // ## GEOMETRIC FUNCTIONS ## //
-Line get_line_points(Vec3 from, Vec3 to, Camera *cam);
-IVec2 *get_triangle_points(Triangle t, Camera *cam, int *point_count);
+// Point lists are allocated from ctx->frame_arena: valid until the arena is reset, never freed
+Line get_line_points(Vec3 from, Vec3 to, RenderContext *ctx);
+IVec2 *get_triangle_points(Triangle t, RenderContext *ctx, int *point_count);
+
+IVec2 *get_tetrahedron_points(Tetrahedron th, RenderContext *ctx, int *point_count);
 
-IVec2 *get_tetrahedron_points(Tetrahedron th, Camera *cam, int *point_count);
+Line *get_cube_edges(Cube cube, RenderContext *ctx);
+IVec2 *get_cube_points(Cube cube, RenderContext *ctx, int *point_count);
 
-Line *get_cube_edges(Cube cube, Camera *cam);
-IVec2 *get_cube_points(Cube cube, Camera *cam, int *point_count);
\ No newline at end of file
+#endif
\ No newline at end of file
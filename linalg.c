@@ -468,6 +468,126 @@ Matrix4 translate_vec(Vec3 t) {
 	return translation_matrix;
 }
 
+// ## QUATERNIONS ## //
+// # CONSTRUCTION # //
+Quat quat_identity() {
+	Quat q = { 0.0f, 0.0f, 0.0f, 1.0f };
+	return q;
+}
+
+Quat quat_from_axis_angle(Vec3 axis, float theta) {
+	Vec3 n = vec3_normalize(axis);
+	float s = sinf(theta * 0.5f);
+	Quat q = { n.x * s, n.y * s, n.z * s, cosf(theta * 0.5f) };
+	return q;
+}
+
+Quat quat_from_euler(Vec3 angles) {
+	float cx = cosf(angles.x * 0.5f), sx = sinf(angles.x * 0.5f);
+	float cy = cosf(angles.y * 0.5f), sy = sinf(angles.y * 0.5f);
+	float cz = cosf(angles.z * 0.5f), sz = sinf(angles.z * 0.5f);
+	
+	// Expanded qz * qy * qx
+	Quat q = {
+		sx * cy * cz - cx * sy * sz,
+		cx * sy * cz + sx * cy * sz,
+		cx * cy * sz - sx * sy * cz,
+		cx * cy * cz + sx * sy * sz,
+	};
+	return q;
+}
+
+// # QUATERNION OPERATIONS # //
+Quat quat_mul(Quat a, Quat b) {
+	Quat q = {
+		a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+		a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+		a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+		a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+	};
+	return q;
+}
+
+Quat quat_conjugate(Quat q) {
+	Quat c = { -q.x, -q.y, -q.z, q.w };
+	return c;
+}
+
+float quat_dot(Quat a, Quat b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+Quat quat_normalize(Quat q) {
+	float length_squared = quat_dot(q, q);
+	if (length_squared == 0.0f) {
+		return quat_identity();
+	}
+	
+	float inverse_length = 1.0f / sqrtf(length_squared);
+	Quat n = { q.x * inverse_length, q.y * inverse_length, q.z * inverse_length, q.w * inverse_length };
+	return n;
+}
+
+Vec3 quat_rotate_vec3(Quat q, Vec3 v) {
+	// v + w * t + u x t, with u the vector part and t = 2 * (u x v)
+	Vec3 u = { q.x, q.y, q.z };
+	Vec3 t = vec3_scale(vec3_cross_product(u, v), 2.0f);
+	return vec3_add(vec3_add(v, vec3_scale(t, q.w)), vec3_cross_product(u, t));
+}
+
+Matrix4 quat_to_mat4(Quat q) {
+	float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+	float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+	float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+	
+	Matrix4 rotation_matrix = { .m = {
+			{1.0f - 2.0f * (yy + zz), 2.0f * (xy - wz), 2.0f * (xz + wy), 0.0f},
+			{2.0f * (xy + wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz - wx), 0.0f},
+			{2.0f * (xz - wy), 2.0f * (yz + wx), 1.0f - 2.0f * (xx + yy), 0.0f},
+			{0.0f, 0.0f, 0.0f, 1.0f}
+		},
+	};
+	
+	return rotation_matrix;
+}
+
+// # INTERPOLATION # //
+static Quat quat_blend(Quat a, Quat b, float cos_angle, float t) {
+	// q and -q are the same rotation, flip b to stay on the shorter arc
+	float tb = cos_angle < 0.0f ? -t : t;
+	float ta = 1.0f - t;
+	Quat q = { a.x * ta + b.x * tb, a.y * ta + b.y * tb, a.z * ta + b.z * tb, a.w * ta + b.w * tb };
+	return quat_normalize(q);
+}
+
+Quat quat_nlerp(Quat a, Quat b, float t) {
+	return quat_blend(a, b, quat_dot(a, b), t);
+}
+
+Quat quat_slerp(Quat a, Quat b, float t) {
+	// nlerp runs fast at the ends of the arc and slow in the middle
+	// A cubic in t, fitted against the angle between a and b, undoes that
+	// to within about a tenth of a degree of true slerp
+	float cos_angle = quat_dot(a, b);
+	float d = fabsf(cos_angle);
+	float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	float k = A * (t - 0.5f) * (t - 0.5f) + B;
+	float corrected_t = t + t * (t - 0.5f) * (t - 1.0f) * k;
+	return quat_blend(a, b, cos_angle, corrected_t);
+}
+
+// # BATCH CONVERSION # //
+void quat_to_mat4_batch(const Quat *q, Matrix4 *out, int count) {
+	if (!q || !out) {
+		return;
+	}
+	
+	for (int i = 0; i < count; i++) {
+		out[i] = quat_to_mat4(q[i]);
+	}
+}
+
 // # MATRIX UTILS FUNCTIONS #//
 // Matrix order 2
 void print_mat2(Matrix2 m) {
@@ -1,4 +1,8 @@
+#ifndef LINALG_H
+#define LINALG_H
+
 #include <stdio.h>
+#include <stdbool.h>
 
 // ### STRUCTS ### //
 
@@ -30,10 +34,27 @@ typedef struct {
 	float m[3][3];
 } Matrix3;
 
+// Rows are 16-byte aligned so they can be loaded straight into SSE registers
 typedef struct {
-	float m[4][4];
+	_Alignas(16) float m[4][4];
 } Matrix4;
 
+// ## QUATERNION STRUCTS ## //
+// Rotation by angle a about unit axis n: (n * sin(a / 2), cos(a / 2))
+typedef struct {
+	float x;
+	float y;
+	float z;
+	float w;
+} Quat;
+
+// ## ENUMS ## //
+typedef enum {
+	LINALG_KERNEL_SCALAR,
+	LINALG_KERNEL_SSE2,
+	LINALG_KERNEL_AVX2,
+} LinalgKernel;
+
 // ### FUNCTION DECLARATIONS ### //
 
 // ## VECTOR STRUCTS ## //
@@ -150,11 +171,54 @@ Matrix4 rotation_yaxis(float theta);
 Matrix4 rotation_zaxis(float theta);
 
 // Scaling
-Matrix4 scaling_matrix(float scalar);
+Matrix4 scale_transformation(float scalar);
 
 // Translation
 Matrix4 translate_vec(Vec3 t);
 
+// ## QUATERNIONS ## //
+// # CONSTRUCTION # //
+Quat quat_identity();
+// The axis does not need to be normalized
+Quat quat_from_axis_angle(Vec3 axis, float theta);
+// Same rotation as rotation_zaxis(z) * rotation_yaxis(y) * rotation_xaxis(x)
+Quat quat_from_euler(Vec3 angles);
+
+// # QUATERNION OPERATIONS # //
+// Rotation b followed by rotation a
+Quat quat_mul(Quat a, Quat b);
+Quat quat_conjugate(Quat q);
+float quat_dot(Quat a, Quat b);
+Quat quat_normalize(Quat q);
+// q must be unit length
+Vec3 quat_rotate_vec3(Quat q, Vec3 v);
+Matrix4 quat_to_mat4(Quat q);
+
+// # INTERPOLATION # //
+// Both take the shorter arc and return a unit quaternion
+Quat quat_nlerp(Quat a, Quat b, float t);
+// nlerp with t corrected to near constant angular speed, no trigonometry
+Quat quat_slerp(Quat a, Quat b, float t);
+
+// # BATCH CONVERSION # //
+// Rotation matrices of count unit quaternions
+void quat_to_mat4_batch(const Quat *q, Matrix4 *out, int count);
+
+// ## BATCH OPERATIONS ## //
+// Structure of arrays streams: element i is (x[i], y[i], z[i])
+// Outputs may alias the inputs; every kernel gives bit-identical results, as long
+// as linalg_simd.c is built with -ffp-contract=off like the Makefile does, so the
+// compiler cannot fuse the scalar path's multiplies and adds
+// Homogeneous transform of count points with w = 1
+void mat4_transform_points_soa(const Matrix4 *m, const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, float *out_w, int count);
+void vec3_normalize_soa(const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, int count);
+void vec3_dot_soa(const float *x1, const float *y1, const float *z1, const float *x2, const float *y2, const float *z2, float *out, int count);
+
+// The best supported kernel is picked on first use, this overrides it
+bool linalg_kernel_supported(LinalgKernel kernel);
+bool set_linalg_kernel(LinalgKernel kernel);
+LinalgKernel get_linalg_kernel();
+
 // # MATRIX UTILS FUNCTIONS #//
 // ...
 
@@ -164,4 +228,6 @@ void print_mat3(Matrix3 m);
 // Matrix order 4
 void print_mat4(Matrix4 m);
 
-// ...
\ No newline at end of file
+// ...
+
+#endif
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include <math.h>
+#include <stdbool.h>
+#include "linalg.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LINALG_SIMD_X86 1
+#endif
+
+// ### FUNCTION DEFINITIONS ### //
+// All kernels round exactly like the scalar one: separate multiplies and adds
+// in the same order, no fused multiply-add and no reciprocal estimates
+
+// ## SCALAR KERNELS ## //
+static void transform_points_scalar(const Matrix4 *m, const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, float *out_w, int start, int count) {
+	const float (*r)[4] = m->m;
+	for (int i = start; i < count; i++) {
+		float px = x[i];
+		float py = y[i];
+		float pz = z[i];
+		out_x[i] = r[0][0] * px + r[0][1] * py + r[0][2] * pz + r[0][3];
+		out_y[i] = r[1][0] * px + r[1][1] * py + r[1][2] * pz + r[1][3];
+		out_z[i] = r[2][0] * px + r[2][1] * py + r[2][2] * pz + r[2][3];
+		out_w[i] = r[3][0] * px + r[3][1] * py + r[3][2] * pz + r[3][3];
+	}
+}
+
+static void normalize_scalar(const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, int start, int count) {
+	for (int i = start; i < count; i++) {
+		float magnitude = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+		// Zero vectors are left as they are, like vec3_normalize
+		float scale = magnitude == 0.0f ? 1.0f : 1.0f / magnitude;
+		out_x[i] = x[i] * scale;
+		out_y[i] = y[i] * scale;
+		out_z[i] = z[i] * scale;
+	}
+}
+
+static void dot_scalar(const float *x1, const float *y1, const float *z1, const float *x2, const float *y2, const float *z2, float *out, int start, int count) {
+	for (int i = start; i < count; i++) {
+		out[i] = x1[i] * x2[i] + y1[i] * y2[i] + z1[i] * z2[i];
+	}
+}
+
+#ifdef LINALG_SIMD_X86
+// ## SSE2 KERNELS ## //
+// 4 elements per step, the remainder goes through the scalar kernels
+__attribute__((target("sse2")))
+static int transform_points_sse2(const Matrix4 *m, const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, float *out_w, int count) {
+	__m128 r[4][4];
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++) {
+			r[row][col] = _mm_set1_ps(m->m[row][col]);
+		}
+	}
+	
+	float *out[4] = { out_x, out_y, out_z, out_w };
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 px = _mm_loadu_ps(x + i);
+		__m128 py = _mm_loadu_ps(y + i);
+		__m128 pz = _mm_loadu_ps(z + i);
+		for (int row = 0; row < 4; row++) {
+			__m128 sum = _mm_add_ps(_mm_mul_ps(r[row][0], px), _mm_mul_ps(r[row][1], py));
+			sum = _mm_add_ps(_mm_add_ps(sum, _mm_mul_ps(r[row][2], pz)), r[row][3]);
+			_mm_storeu_ps(out[row] + i, sum);
+		}
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static int normalize_sse2(const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, int count) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 vx = _mm_loadu_ps(x + i);
+		__m128 vy = _mm_loadu_ps(y + i);
+		__m128 vz = _mm_loadu_ps(z + i);
+		__m128 length_squared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+		__m128 magnitude = _mm_sqrt_ps(length_squared);
+		__m128 is_zero = _mm_cmpeq_ps(magnitude, zero);
+		// Divide by 1 instead of 0 in the zero lanes, then keep 1 as the scale there
+		__m128 scale = _mm_div_ps(one, _mm_or_ps(_mm_andnot_ps(is_zero, magnitude), _mm_and_ps(is_zero, one)));
+		_mm_storeu_ps(out_x + i, _mm_mul_ps(vx, scale));
+		_mm_storeu_ps(out_y + i, _mm_mul_ps(vy, scale));
+		_mm_storeu_ps(out_z + i, _mm_mul_ps(vz, scale));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static int dot_sse2(const float *x1, const float *y1, const float *z1, const float *x2, const float *y2, const float *z2, float *out, int count) {
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 sum = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(x1 + i), _mm_loadu_ps(x2 + i)), _mm_mul_ps(_mm_loadu_ps(y1 + i), _mm_loadu_ps(y2 + i)));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(z1 + i), _mm_loadu_ps(z2 + i)));
+		_mm_storeu_ps(out + i, sum);
+	}
+	return i;
+}
+
+// ## AVX2 KERNELS ## //
+// 8 elements per step
+__attribute__((target("avx2")))
+static int transform_points_avx2(const Matrix4 *m, const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, float *out_w, int count) {
+	__m256 r[4][4];
+	for (int row = 0; row < 4; row++) {
+		for (int col = 0; col < 4; col++) {
+			r[row][col] = _mm256_set1_ps(m->m[row][col]);
+		}
+	}
+	
+	float *out[4] = { out_x, out_y, out_z, out_w };
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 px = _mm256_loadu_ps(x + i);
+		__m256 py = _mm256_loadu_ps(y + i);
+		__m256 pz = _mm256_loadu_ps(z + i);
+		for (int row = 0; row < 4; row++) {
+			__m256 sum = _mm256_add_ps(_mm256_mul_ps(r[row][0], px), _mm256_mul_ps(r[row][1], py));
+			sum = _mm256_add_ps(_mm256_add_ps(sum, _mm256_mul_ps(r[row][2], pz)), r[row][3]);
+			_mm256_storeu_ps(out[row] + i, sum);
+		}
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int normalize_avx2(const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, int count) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 vx = _mm256_loadu_ps(x + i);
+		__m256 vy = _mm256_loadu_ps(y + i);
+		__m256 vz = _mm256_loadu_ps(z + i);
+		__m256 length_squared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+		__m256 magnitude = _mm256_sqrt_ps(length_squared);
+		__m256 scale = _mm256_div_ps(one, _mm256_blendv_ps(magnitude, one, _mm256_cmp_ps(magnitude, zero, _CMP_EQ_OQ)));
+		_mm256_storeu_ps(out_x + i, _mm256_mul_ps(vx, scale));
+		_mm256_storeu_ps(out_y + i, _mm256_mul_ps(vy, scale));
+		_mm256_storeu_ps(out_z + i, _mm256_mul_ps(vz, scale));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int dot_avx2(const float *x1, const float *y1, const float *z1, const float *x2, const float *y2, const float *z2, float *out, int count) {
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 sum = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(x1 + i), _mm256_loadu_ps(x2 + i)), _mm256_mul_ps(_mm256_loadu_ps(y1 + i), _mm256_loadu_ps(y2 + i)));
+		sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(z1 + i), _mm256_loadu_ps(z2 + i)));
+		_mm256_storeu_ps(out + i, sum);
+	}
+	return i;
+}
+
+bool linalg_kernel_supported(LinalgKernel kernel) {
+	// linalg does not depend on SDL, the compiler builtins do the CPUID checks
+	switch (kernel) {
+		case LINALG_KERNEL_SCALAR:
+			return true;
+		case LINALG_KERNEL_SSE2:
+			return __builtin_cpu_supports("sse2");
+		case LINALG_KERNEL_AVX2:
+			return __builtin_cpu_supports("avx2");
+	}
+	return false;
+}
+#else
+// No vector kernels on this architecture
+bool linalg_kernel_supported(LinalgKernel kernel) {
+	return kernel == LINALG_KERNEL_SCALAR;
+}
+#endif
+
+// ## KERNEL SELECTION ## //
+static bool linalg_kernel_chosen = false;
+static LinalgKernel linalg_kernel = LINALG_KERNEL_SCALAR;
+
+bool set_linalg_kernel(LinalgKernel kernel) {
+	if (!linalg_kernel_supported(kernel)) {
+		return false;
+	}
+	
+	linalg_kernel = kernel;
+	linalg_kernel_chosen = true;
+	return true;
+}
+
+LinalgKernel get_linalg_kernel() {
+	if (!linalg_kernel_chosen) {
+		// Widest supported kernel, every thread picks the same one
+		if (!set_linalg_kernel(LINALG_KERNEL_AVX2) && !set_linalg_kernel(LINALG_KERNEL_SSE2)) {
+			set_linalg_kernel(LINALG_KERNEL_SCALAR);
+		}
+	}
+	return linalg_kernel;
+}
+
+// ## BATCH OPERATIONS ## //
+void mat4_transform_points_soa(const Matrix4 *m, const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, float *out_w, int count) {
+	if (!(m && x && y && z && out_x && out_y && out_z && out_w)) {
+		return;
+	}
+	
+	int done = 0;
+#ifdef LINALG_SIMD_X86
+	switch (get_linalg_kernel()) {
+		case LINALG_KERNEL_AVX2:
+			done = transform_points_avx2(m, x, y, z, out_x, out_y, out_z, out_w, count);
+			break;
+		case LINALG_KERNEL_SSE2:
+			done = transform_points_sse2(m, x, y, z, out_x, out_y, out_z, out_w, count);
+			break;
+		case LINALG_KERNEL_SCALAR:
+			break;
+	}
+#endif
+	transform_points_scalar(m, x, y, z, out_x, out_y, out_z, out_w, done, count);
+}
+
+void vec3_normalize_soa(const float *x, const float *y, const float *z, float *out_x, float *out_y, float *out_z, int count) {
+	if (!(x && y && z && out_x && out_y && out_z)) {
+		return;
+	}
+	
+	int done = 0;
+#ifdef LINALG_SIMD_X86
+	switch (get_linalg_kernel()) {
+		case LINALG_KERNEL_AVX2:
+			done = normalize_avx2(x, y, z, out_x, out_y, out_z, count);
+			break;
+		case LINALG_KERNEL_SSE2:
+			done = normalize_sse2(x, y, z, out_x, out_y, out_z, count);
+			break;
+		case LINALG_KERNEL_SCALAR:
+			break;
+	}
+#endif
+	normalize_scalar(x, y, z, out_x, out_y, out_z, done, count);
+}
+
+void vec3_dot_soa(const float *x1, const float *y1, const float *z1, const float *x2, const float *y2, const float *z2, float *out, int count) {
+	if (!(x1 && y1 && z1 && x2 && y2 && z2 && out)) {
+		return;
+	}
+	
+	int done = 0;
+#ifdef LINALG_SIMD_X86
+	switch (get_linalg_kernel()) {
+		case LINALG_KERNEL_AVX2:
+			done = dot_avx2(x1, y1, z1, x2, y2, z2, out, count);
+			break;
+		case LINALG_KERNEL_SSE2:
+			done = dot_sse2(x1, y1, z1, x2, y2, z2, out, count);
+			break;
+		case LINALG_KERNEL_SCALAR:
+			break;
+	}
+#endif
+	dot_scalar(x1, y1, z1, x2, y2, z2, out, done, count);
+}
@@ -0,0 +1,1009 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <math.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include "loader.h"
+
+// ### CONSTANT DEFINITIONS ### //
+#define CACHE_MAGIC "MESHBIN3"
+// Stored as written, so a cache from a machine of the other byte order does not match
+#define CACHE_BYTE_ORDER 0x01020304u
+#define STL_HEADER_SIZE 80
+#define STL_TRIANGLE_SIZE 50
+#define PLY_MAX_ELEMENTS 16
+#define PLY_MAX_PROPERTIES 32
+// Mantissa digits kept by parse_number, more only move the exponent
+#define MAX_MANTISSA_DIGITS 19
+
+// ### STRUCTS AND ENUMS ### //
+// Contents of a whole file, mapped where the platform allows it
+typedef struct {
+	unsigned char *data;
+	size_t size;
+} FileView;
+
+typedef struct {
+	const unsigned char *at;
+	const unsigned char *end;
+} Cursor;
+
+typedef struct {
+	char magic[8];
+	uint32_t byte_order;
+	int32_t vertex_count;
+	int32_t triangle_count;
+	int32_t edge_count;
+	float bounds_center[3];
+	float bounds_radius;
+	// Of the file the mesh was loaded from, 0 when there was none
+	uint64_t source_size;
+	// Detail levels in the file, each behind a header of its own, finest first
+	int32_t level_count;
+	int32_t reserved;
+} CacheHeader;
+
+typedef enum {
+	PLY_ASCII,
+	PLY_BINARY_LITTLE_ENDIAN,
+	PLY_BINARY_BIG_ENDIAN,
+} PlyFormat;
+
+typedef enum {
+	PLY_NONE,
+	PLY_INT8,
+	PLY_UINT8,
+	PLY_INT16,
+	PLY_UINT16,
+	PLY_INT32,
+	PLY_UINT32,
+	PLY_FLOAT32,
+	PLY_FLOAT64,
+} PlyType;
+
+typedef struct {
+	PlyType type;
+	// Type of the element count for lists, PLY_NONE for single values
+	PlyType count_type;
+	char name[32];
+} PlyProperty;
+
+typedef struct {
+	char name[32];
+	long count;
+	PlyProperty properties[PLY_MAX_PROPERTIES];
+	int property_count;
+} PlyElement;
+
+typedef struct {
+	PlyFormat format;
+	PlyElement elements[PLY_MAX_ELEMENTS];
+	int element_count;
+} PlyHeader;
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## FILES ## //
+static bool open_file_view(const char *path, FileView *view) {
+	*view = (FileView){ NULL, 0 };
+	if (!path) {
+		return false;
+	}
+	
+#ifdef _WIN32
+	// No mapping here, the file is read in one go
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		return false;
+	}
+	long size = -1;
+	if (fseek(file, 0, SEEK_END) == 0) {
+		size = ftell(file);
+	}
+	if (size <= 0 || fseek(file, 0, SEEK_SET) != 0) {
+		fclose(file);
+		return false;
+	}
+	view->data = malloc(size);
+	if ((!view->data) || fread(view->data, 1, size, file) != (size_t)size) {
+		free(view->data);
+		view->data = NULL;
+		fclose(file);
+		return false;
+	}
+	fclose(file);
+	view->size = size;
+	return true;
+#else
+	int descriptor = open(path, O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size <= 0) {
+		close(descriptor);
+		return false;
+	}
+	// Private and writable: writes are copied on write and never reach the file
+	void *data = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+	madvise(data, status.st_size, MADV_SEQUENTIAL);
+	view->data = data;
+	view->size = status.st_size;
+	return true;
+#endif
+}
+
+static void close_file_view(FileView *view) {
+	if (!view->data) {
+		return;
+	}
+	
+#ifdef _WIN32
+	free(view->data);
+#else
+	munmap(view->data, view->size);
+#endif
+	*view = (FileView){ NULL, 0 };
+}
+
+MeshFormat mesh_format_from_path(const char *path) {
+	const char *extension = path ? strrchr(path, '.') : NULL;
+	if (!extension) {
+		return MESH_FORMAT_UNKNOWN;
+	}
+	
+	char lower[8] = { 0 };
+	for (int i = 0; i < 7 && extension[i + 1]; i++) {
+		lower[i] = tolower((unsigned char)extension[i + 1]);
+	}
+	if (strcmp(lower, "obj") == 0) {
+		return MESH_FORMAT_OBJ;
+	}
+	if (strcmp(lower, "ply") == 0) {
+		return MESH_FORMAT_PLY;
+	}
+	if (strcmp(lower, "stl") == 0) {
+		return MESH_FORMAT_STL;
+	}
+	if (strcmp(lower, "cache") == 0) {
+		return MESH_FORMAT_CACHE;
+	}
+	return MESH_FORMAT_UNKNOWN;
+}
+
+// ## TEXT ## //
+// The file is not terminated, so every read checks the end
+static inline void skip_blanks(Cursor *cursor) {
+	while (cursor->at < cursor->end && (*cursor->at == ' ' || *cursor->at == '\t' || *cursor->at == '\r')) {
+		cursor->at++;
+	}
+}
+
+static inline void skip_whitespace(Cursor *cursor) {
+	while (cursor->at < cursor->end && isspace(*cursor->at)) {
+		cursor->at++;
+	}
+}
+
+static inline void skip_line(Cursor *cursor) {
+	const unsigned char *newline = memchr(cursor->at, '\n', cursor->end - cursor->at);
+	cursor->at = newline ? newline + 1 : cursor->end;
+}
+
+static inline bool at_line_end(const Cursor *cursor) {
+	return cursor->at >= cursor->end || *cursor->at == '\n' || *cursor->at == '#';
+}
+
+// Decimal number with an optional fraction and exponent; digits go into an
+// integer mantissa and are scaled once, which is exact for typical model files
+static bool parse_number(Cursor *cursor, double *value) {
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+	const unsigned char *at = cursor->at;
+	const unsigned char *end = cursor->end;
+	bool negative = false;
+	if (at < end && (*at == '-' || *at == '+')) {
+		negative = *at == '-';
+		at++;
+	}
+	
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool any_digit = false;
+	for (; at < end && isdigit(*at); at++) {
+		any_digit = true;
+		if (digits < MAX_MANTISSA_DIGITS) {
+			mantissa = mantissa * 10 + (*at - '0');
+			digits += mantissa > 0;
+		} else {
+			exponent++;
+		}
+	}
+	if (at < end && *at == '.') {
+		for (at++; at < end && isdigit(*at); at++) {
+			any_digit = true;
+			if (digits < MAX_MANTISSA_DIGITS) {
+				mantissa = mantissa * 10 + (*at - '0');
+				digits += mantissa > 0;
+				exponent--;
+			}
+		}
+	}
+	if (!any_digit) {
+		return false;
+	}
+	if (at < end && (*at == 'e' || *at == 'E')) {
+		const unsigned char *exponent_start = at++;
+		bool negative_exponent = false;
+		if (at < end && (*at == '-' || *at == '+')) {
+			negative_exponent = *at == '-';
+			at++;
+		}
+		if (at < end && isdigit(*at)) {
+			int written = 0;
+			for (; at < end && isdigit(*at); at++) {
+				written = written < 10000 ? written * 10 + (*at - '0') : written;
+			}
+			exponent += negative_exponent ? -written : written;
+		} else {
+			// An "e" with no digits is not part of the number
+			at = exponent_start;
+		}
+	}
+	
+	double result = (double)mantissa;
+	if (exponent < 0) {
+		result = exponent >= -22 ? result / powers[-exponent] : result * pow(10.0, exponent);
+	} else if (exponent > 0) {
+		result = exponent <= 22 ? result * powers[exponent] : result * pow(10.0, exponent);
+	}
+	*value = negative ? -result : result;
+	cursor->at = at;
+	return true;
+}
+
+static bool parse_float(Cursor *cursor, float *value) {
+	double number;
+	skip_blanks(cursor);
+	if (!parse_number(cursor, &number)) {
+		return false;
+	}
+	*value = (float)number;
+	return true;
+}
+
+// Whether the line starts with the keyword as a whole word
+static bool line_keyword(const Cursor *cursor, const char *keyword) {
+	size_t length = strlen(keyword);
+	if ((size_t)(cursor->end - cursor->at) <= length || memcmp(cursor->at, keyword, length) != 0) {
+		return false;
+	}
+	unsigned char next = cursor->at[length];
+	return next == ' ' || next == '\t';
+}
+
+// ## OBJ ## //
+// Vertex references of an "f" line, the cursor is after the keyword
+static int obj_face_corners(Cursor cursor) {
+	int corners = 0;
+	while (true) {
+		skip_blanks(&cursor);
+		if (at_line_end(&cursor)) {
+			return corners;
+		}
+		corners++;
+		while (cursor.at < cursor.end && !isspace(*cursor.at)) {
+			cursor.at++;
+		}
+	}
+}
+
+// One corner: the vertex, then any texture and normal references which are skipped
+static bool obj_corner(Cursor *cursor, int vertices_so_far, int vertex_count, int *vertex) {
+	double number;
+	skip_blanks(cursor);
+	if (!parse_number(cursor, &number)) {
+		return false;
+	}
+	while (cursor->at < cursor->end && !isspace(*cursor->at)) {
+		cursor->at++;
+	}
+	
+	// Negative indices count back from the last vertex read
+	if (!(number >= INT32_MIN && number <= INT32_MAX)) {
+		return false;
+	}
+	long index = (long)number;
+	index = index < 0 ? vertices_so_far + index : index - 1;
+	if (index < 0 || index >= vertex_count) {
+		return false;
+	}
+	*vertex = (int)index;
+	return true;
+}
+
+Mesh *load_obj(const char *path) {
+	FileView view;
+	if (!open_file_view(path, &view)) {
+		return NULL;
+	}
+	
+	// Counting pass
+	long vertex_count = 0;
+	long triangle_count = 0;
+	Cursor cursor = { view.data, view.data + view.size };
+	while (cursor.at < cursor.end) {
+		skip_blanks(&cursor);
+		if (line_keyword(&cursor, "v")) {
+			vertex_count++;
+		} else if (line_keyword(&cursor, "f")) {
+			int corners = obj_face_corners((Cursor){ cursor.at + 1, cursor.end });
+			triangle_count += corners >= 3 ? corners - 2 : 0;
+		}
+		skip_line(&cursor);
+	}
+	Mesh *mesh = NULL;
+	if (vertex_count > 0 && triangle_count > 0 && vertex_count <= INT32_MAX && 3 * triangle_count <= INT32_MAX) {
+		mesh = create_mesh(vertex_count, triangle_count, 3 * triangle_count);
+	}
+	if (!mesh) {
+		close_file_view(&view);
+		return NULL;
+	}
+	
+	// Filling pass
+	int vertex = 0;
+	int triangle = 0;
+	bool valid = true;
+	cursor = (Cursor){ view.data, view.data + view.size };
+	while (valid && cursor.at < cursor.end) {
+		skip_blanks(&cursor);
+		if (line_keyword(&cursor, "v")) {
+			cursor.at++;
+			valid = parse_float(&cursor, &mesh->x[vertex]) && parse_float(&cursor, &mesh->y[vertex]) && parse_float(&cursor, &mesh->z[vertex]);
+			vertex++;
+		} else if (line_keyword(&cursor, "f")) {
+			cursor.at++;
+			int corners = obj_face_corners(cursor);
+			int first, previous, current;
+			valid = corners < 3 || (obj_corner(&cursor, vertex, mesh->vertex_count, &first) && obj_corner(&cursor, vertex, mesh->vertex_count, &previous));
+			for (int i = 2; valid && i < corners; i++) {
+				valid = obj_corner(&cursor, vertex, mesh->vertex_count, &current);
+				mesh->triangles[triangle][0] = first;
+				mesh->triangles[triangle][1] = previous;
+				mesh->triangles[triangle][2] = current;
+				triangle++;
+				previous = current;
+			}
+		}
+		skip_line(&cursor);
+	}
+	close_file_view(&view);
+	
+	if ((!valid) || (!mesh_build_edges(mesh))) {
+		destroy_mesh(&mesh);
+		return NULL;
+	}
+	mesh_update_bounds(mesh);
+	return mesh;
+}
+
+// ## PLY ## //
+static PlyType ply_type(const char *name) {
+	static const struct {
+		const char *name;
+		PlyType type;
+	} types[] = {
+		{ "char", PLY_INT8 }, { "int8", PLY_INT8 }, { "uchar", PLY_UINT8 }, { "uint8", PLY_UINT8 },
+		{ "short", PLY_INT16 }, { "int16", PLY_INT16 }, { "ushort", PLY_UINT16 }, { "uint16", PLY_UINT16 },
+		{ "int", PLY_INT32 }, { "int32", PLY_INT32 }, { "uint", PLY_UINT32 }, { "uint32", PLY_UINT32 },
+		{ "float", PLY_FLOAT32 }, { "float32", PLY_FLOAT32 }, { "double", PLY_FLOAT64 }, { "float64", PLY_FLOAT64 },
+	};
+	for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+		if (strcmp(name, types[i].name) == 0) {
+			return types[i].type;
+		}
+	}
+	return PLY_NONE;
+}
+
+static int ply_type_size(PlyType type) {
+	static const int sizes[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+	return sizes[type];
+}
+
+// Reads the next whitespace separated word of the header line into word
+static bool header_word(Cursor *cursor, char *word, size_t capacity) {
+	skip_blanks(cursor);
+	size_t length = 0;
+	while (cursor->at < cursor->end && !isspace(*cursor->at)) {
+		if (length + 1 < capacity) {
+			word[length++] = *cursor->at;
+		}
+		cursor->at++;
+	}
+	word[length] = '\0';
+	return length > 0;
+}
+
+// Leaves the cursor at the first byte of the body
+static bool parse_ply_header(Cursor *cursor, PlyHeader *header) {
+	char word[32];
+	if (!(header_word(cursor, word, sizeof(word)) && strcmp(word, "ply") == 0)) {
+		return false;
+	}
+	skip_line(cursor);
+	
+	header->element_count = 0;
+	bool has_format = false;
+	while (cursor->at < cursor->end) {
+		if (!header_word(cursor, word, sizeof(word))) {
+			skip_line(cursor);
+			continue;
+		}
+		if (strcmp(word, "end_header") == 0) {
+			skip_line(cursor);
+			return has_format;
+		}
+	
+		if (strcmp(word, "format") == 0) {
+			header_word(cursor, word, sizeof(word));
+			has_format = true;
+			if (strcmp(word, "ascii") == 0) {
+				header->format = PLY_ASCII;
+			} else if (strcmp(word, "binary_little_endian") == 0) {
+				header->format = PLY_BINARY_LITTLE_ENDIAN;
+			} else if (strcmp(word, "binary_big_endian") == 0) {
+				header->format = PLY_BINARY_BIG_ENDIAN;
+			} else {
+				return false;
+			}
+		} else if (strcmp(word, "element") == 0) {
+			if (header->element_count == PLY_MAX_ELEMENTS) {
+				return false;
+			}
+			PlyElement *element = &header->elements[header->element_count++];
+			element->property_count = 0;
+			double count;
+			if (!(header_word(cursor, element->name, sizeof(element->name)) && (skip_blanks(cursor), parse_number(cursor, &count)) && count >= 0.0 && count <= INT32_MAX)) {
+				return false;
+			}
+			element->count = (long)count;
+			// The mesh is sized from one of each, a second one would be written past it
+			for (int e = 0; e < header->element_count - 1; e++) {
+				bool known = strcmp(element->name, "vertex") == 0 || strcmp(element->name, "face") == 0;
+				if (known && strcmp(header->elements[e].name, element->name) == 0) {
+					return false;
+				}
+			}
+		} else if (strcmp(word, "property") == 0) {
+			if (header->element_count == 0) {
+				return false;
+			}
+			PlyElement *element = &header->elements[header->element_count - 1];
+			if (element->property_count == PLY_MAX_PROPERTIES) {
+				return false;
+			}
+			PlyProperty *property = &element->properties[element->property_count++];
+			header_word(cursor, word, sizeof(word));
+			property->count_type = PLY_NONE;
+			if (strcmp(word, "list") == 0) {
+				header_word(cursor, word, sizeof(word));
+				property->count_type = ply_type(word);
+				header_word(cursor, word, sizeof(word));
+				if (property->count_type == PLY_NONE || property->count_type >= PLY_FLOAT32) {
+					return false;
+				}
+			}
+			property->type = ply_type(word);
+			if (!(property->type != PLY_NONE && header_word(cursor, property->name, sizeof(property->name)))) {
+				return false;
+			}
+		}
+		// Comments and obj_info lines are skipped with the rest of their line
+		skip_line(cursor);
+	}
+	return false;
+}
+
+static bool ply_read(Cursor *cursor, PlyFormat format, PlyType type, double *value) {
+	if (format == PLY_ASCII) {
+		skip_whitespace(cursor);
+		return parse_number(cursor, value);
+	}
+	
+	int size = ply_type_size(type);
+	if (cursor->end - cursor->at < size) {
+		return false;
+	}
+	// Assembled in little endian order, whatever the machine's is
+	unsigned char bytes[8];
+	for (int i = 0; i < size; i++) {
+		bytes[i] = format == PLY_BINARY_LITTLE_ENDIAN ? cursor->at[i] : cursor->at[size - 1 - i];
+	}
+	cursor->at += size;
+	uint64_t bits = 0;
+	for (int i = size - 1; i >= 0; i--) {
+		bits = bits << 8 | bytes[i];
+	}
+	switch (type) {
+		case PLY_INT8:
+			*value = (int8_t)bits;
+			break;
+		case PLY_UINT8:
+			*value = (uint8_t)bits;
+			break;
+		case PLY_INT16:
+			*value = (int16_t)bits;
+			break;
+		case PLY_UINT16:
+			*value = (uint16_t)bits;
+			break;
+		case PLY_INT32:
+			*value = (int32_t)bits;
+			break;
+		case PLY_UINT32:
+			*value = (uint32_t)bits;
+			break;
+		case PLY_FLOAT32: {
+			uint32_t word = (uint32_t)bits;
+			float number;
+			memcpy(&number, &word, sizeof(number));
+			*value = number;
+			break;
+		}
+		case PLY_FLOAT64:
+			memcpy(value, &bits, sizeof(*value));
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+static int ply_property_index(const PlyElement *element, const char *name, bool list) {
+	for (int i = 0; i < element->property_count; i++) {
+		if (strcmp(element->properties[i].name, name) == 0 && (element->properties[i].count_type != PLY_NONE) == list) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+// Walks the whole body. Without a mesh, only the face triangles are counted;
+// with one, the positions and fans are written into it
+static bool read_ply_body(Cursor cursor, const PlyHeader *header, Mesh *mesh, long *triangle_count) {
+	long triangle = 0;
+	for (int e = 0; e < header->element_count; e++) {
+		const PlyElement *element = &header->elements[e];
+		bool vertices = strcmp(element->name, "vertex") == 0;
+		bool faces = strcmp(element->name, "face") == 0;
+		int coordinates[3] = { -1, -1, -1 };
+		int indices = -1;
+		if (vertices) {
+			coordinates[0] = ply_property_index(element, "x", false);
+			coordinates[1] = ply_property_index(element, "y", false);
+			coordinates[2] = ply_property_index(element, "z", false);
+		} else if (faces) {
+			indices = ply_property_index(element, "vertex_indices", true);
+			indices = indices >= 0 ? indices : ply_property_index(element, "vertex_index", true);
+		}
+	
+		for (long i = 0; i < element->count; i++) {
+			for (int p = 0; p < element->property_count; p++) {
+				const PlyProperty *property = &element->properties[p];
+				double value;
+				if (property->count_type == PLY_NONE) {
+					if (!ply_read(&cursor, header->format, property->type, &value)) {
+						return false;
+					}
+					for (int axis = 0; mesh && i < mesh->vertex_count && axis < 3; axis++) {
+						if (p == coordinates[axis]) {
+							float *positions[3] = { mesh->x, mesh->y, mesh->z };
+							positions[axis][i] = (float)value;
+						}
+					}
+					continue;
+				}
+	
+				double count;
+				if (!(ply_read(&cursor, header->format, property->count_type, &count) && count >= 0.0 && count <= INT32_MAX)) {
+					return false;
+				}
+				int corners = (int)count;
+				if (p == indices && corners >= 3) {
+					triangle += corners - 2;
+				}
+				// Binary values that are not needed are stepped over without decoding
+				if (header->format != PLY_ASCII && !(mesh && p == indices)) {
+					size_t skip = (size_t)corners * ply_type_size(property->type);
+					if ((size_t)(cursor.end - cursor.at) < skip) {
+						return false;
+					}
+					cursor.at += skip;
+					continue;
+				}
+				int first = 0;
+				int previous = 0;
+				for (int c = 0; c < corners; c++) {
+					if (!ply_read(&cursor, header->format, property->type, &value)) {
+						return false;
+					}
+					if (!(mesh && p == indices)) {
+						continue;
+					}
+					// Written so that NaN fails too
+					if (!(value >= 0.0 && value < mesh->vertex_count)) {
+						return false;
+					}
+					int current = (int)value;
+					if (c == 0) {
+						first = current;
+					} else if (c >= 2) {
+						long t = triangle - (corners - 2) + (c - 2);
+						mesh->triangles[t][0] = first;
+						mesh->triangles[t][1] = previous;
+						mesh->triangles[t][2] = current;
+					}
+					previous = current;
+				}
+			}
+		}
+		if (vertices && mesh && (coordinates[0] < 0 || coordinates[1] < 0 || coordinates[2] < 0)) {
+			return false;
+		}
+	}
+	*triangle_count = triangle;
+	return true;
+}
+
+Mesh *load_ply(const char *path) {
+	FileView view;
+	if (!open_file_view(path, &view)) {
+		return NULL;
+	}
+	
+	Cursor cursor = { view.data, view.data + view.size };
+	PlyHeader header;
+	long vertex_count = -1;
+	long triangle_count = 0;
+	bool valid = parse_ply_header(&cursor, &header);
+	for (int e = 0; valid && e < header.element_count; e++) {
+		if (strcmp(header.elements[e].name, "vertex") == 0) {
+			vertex_count = header.elements[e].count;
+		}
+	}
+	valid = valid && read_ply_body(cursor, &header, NULL, &triangle_count);
+	Mesh *mesh = NULL;
+	if (valid && vertex_count > 0 && triangle_count > 0 && vertex_count <= INT32_MAX && 3 * triangle_count <= INT32_MAX) {
+		mesh = create_mesh(vertex_count, triangle_count, 3 * triangle_count);
+	}
+	
+	valid = mesh && read_ply_body(cursor, &header, mesh, &triangle_count);
+	close_file_view(&view);
+	if ((!valid) || (!mesh_build_edges(mesh))) {
+		destroy_mesh(&mesh);
+		return NULL;
+	}
+	mesh_update_bounds(mesh);
+	return mesh;
+}
+
+// ## STL ## //
+static inline uint32_t read_u32_le(const unsigned char *bytes) {
+	return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static inline float read_f32_le(const unsigned char *bytes) {
+	uint32_t bits = read_u32_le(bytes);
+	// Both zeros weld together
+	bits = bits == 0x80000000u ? 0 : bits;
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static inline uint32_t hash_position(const float *position) {
+	uint32_t bits[3];
+	memcpy(bits, position, sizeof(bits));
+	uint32_t hash = bits[0] * 0x9E3779B1u;
+	hash = (hash ^ bits[1]) * 0x85EBCA77u;
+	hash = (hash ^ bits[2]) * 0xC2B2AE3Du;
+	return hash ^ hash >> 16;
+}
+
+Mesh *load_stl(const char *path) {
+	FileView view;
+	if (!open_file_view(path, &view)) {
+		return NULL;
+	}
+	
+	// ASCII files, which start with "solid", do not have the size their count implies
+	uint32_t count = view.size >= STL_HEADER_SIZE + 4 ? read_u32_le(view.data + STL_HEADER_SIZE) : 0;
+	if (count == 0 || count > INT32_MAX / 3 || (view.size - STL_HEADER_SIZE - 4) / STL_TRIANGLE_SIZE < count) {
+		close_file_view(&view);
+		return NULL;
+	}
+	
+	// Welding state in one allocation: the unique positions, the vertex of each
+	// corner and an open addressing table of vertex indices, at most half full
+	size_t corner_count = 3 * (size_t)count;
+	size_t table_size = 1;
+	while (table_size < 2 * corner_count) {
+		table_size *= 2;
+	}
+	float *positions = malloc(3 * corner_count * sizeof(float) + (corner_count + table_size) * sizeof(int));
+	if (!positions) {
+		close_file_view(&view);
+		return NULL;
+	}
+	int *corners = (int*)(positions + 3 * corner_count);
+	int *table = corners + corner_count;
+	for (size_t i = 0; i < table_size; i++) {
+		table[i] = -1;
+	}
+	
+	int vertex_count = 0;
+	int triangle_count = 0;
+	const unsigned char *triangle = view.data + STL_HEADER_SIZE + 4;
+	for (uint32_t t = 0; t < count; t++, triangle += STL_TRIANGLE_SIZE) {
+		// The facet normal comes first and is not needed, the winding gives it
+		int *triangle_corners = &corners[3 * (size_t)triangle_count];
+		for (int c = 0; c < 3; c++) {
+			float *position = &positions[3 * (size_t)vertex_count];
+			for (int axis = 0; axis < 3; axis++) {
+				position[axis] = read_f32_le(triangle + 12 + 12 * c + 4 * axis);
+			}
+			size_t slot = hash_position(position) & (table_size - 1);
+			while (table[slot] >= 0 && memcmp(&positions[3 * (size_t)table[slot]], position, 3 * sizeof(float)) != 0) {
+				slot = (slot + 1) & (table_size - 1);
+			}
+			if (table[slot] < 0) {
+				table[slot] = vertex_count++;
+			}
+			triangle_corners[c] = table[slot];
+		}
+		// Triangles that lost a corner to welding are dropped
+		if (triangle_corners[0] != triangle_corners[1] && triangle_corners[1] != triangle_corners[2] && triangle_corners[2] != triangle_corners[0]) {
+			triangle_count++;
+		}
+	}
+	close_file_view(&view);
+	
+	Mesh *mesh = triangle_count > 0 ? create_mesh(vertex_count, triangle_count, 3 * triangle_count) : NULL;
+	if (!mesh) {
+		free(positions);
+		return NULL;
+	}
+	for (int i = 0; i < vertex_count; i++) {
+		mesh->x[i] = positions[3 * i];
+		mesh->y[i] = positions[3 * i + 1];
+		mesh->z[i] = positions[3 * i + 2];
+	}
+	memcpy(mesh->triangles, corners, triangle_count * sizeof(int[3]));
+	free(positions);
+	
+	if (!mesh_build_edges(mesh)) {
+		destroy_mesh(&mesh);
+		return NULL;
+	}
+	mesh_update_bounds(mesh);
+	return mesh;
+}
+
+Mesh *load_mesh(const char *path) {
+	switch (mesh_format_from_path(path)) {
+		case MESH_FORMAT_OBJ:
+			return load_obj(path);
+		case MESH_FORMAT_PLY:
+			return load_ply(path);
+		case MESH_FORMAT_STL:
+			return load_stl(path);
+		default:
+			return NULL;
+	}
+}
+
+// ## BINARY CACHE ## //
+// Every array is a multiple of 4 bytes after a header of 56, so all stay aligned when mapped.
+// Size of one level with its header
+static size_t cache_size(long vertex_count, long triangle_count, long edge_count) {
+	return sizeof(CacheHeader) + triangle_count * sizeof(int[3]) + edge_count * sizeof(int[2]) + 3 * vertex_count * sizeof(float);
+}
+
+static bool write_cache_level(FILE *file, const Mesh *mesh, int level_count, uint64_t source_size) {
+	CacheHeader header = {
+		.byte_order = CACHE_BYTE_ORDER,
+		.vertex_count = mesh->vertex_count,
+		.triangle_count = mesh->triangle_count,
+		.edge_count = mesh->edge_count,
+		.bounds_center = { mesh->bounds_center.x, mesh->bounds_center.y, mesh->bounds_center.z },
+		.bounds_radius = mesh->bounds_radius,
+		.source_size = source_size,
+		.level_count = level_count,
+	};
+	memcpy(header.magic, CACHE_MAGIC, sizeof(header.magic));
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+	written = written && fwrite(mesh->triangles, sizeof(int[3]), mesh->triangle_count, file) == (size_t)mesh->triangle_count;
+	written = written && fwrite(mesh->edges, sizeof(int[2]), mesh->edge_count, file) == (size_t)mesh->edge_count;
+	written = written && fwrite(mesh->x, sizeof(float), mesh->vertex_count, file) == (size_t)mesh->vertex_count;
+	written = written && fwrite(mesh->y, sizeof(float), mesh->vertex_count, file) == (size_t)mesh->vertex_count;
+	written = written && fwrite(mesh->z, sizeof(float), mesh->vertex_count, file) == (size_t)mesh->vertex_count;
+	return written;
+}
+
+static bool save_cache(Mesh *const *levels, int level_count, const char *source_path, const char *path) {
+	if ((!levels) || level_count < 1 || level_count > MESH_LOD_MAX_LEVELS || (!path)) {
+		return false;
+	}
+	for (int i = 0; i < level_count; i++) {
+		if (!levels[i]) {
+			return false;
+		}
+	}
+	struct stat source;
+	if (source_path && stat(source_path, &source) != 0) {
+		return false;
+	}
+	
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	uint64_t source_size = source_path ? (uint64_t)source.st_size : 0;
+	bool written = true;
+	for (int i = 0; i < level_count && written; i++) {
+		written = write_cache_level(file, levels[i], level_count, source_size);
+	}
+	written = (fclose(file) == 0) && written;
+	
+	// A partly written cache would be mapped as valid by a later run if its size happened to fit
+	if (!written) {
+		remove(path);
+	}
+	return written;
+}
+
+bool save_mesh_cache(const Mesh *mesh, const char *source_path, const char *path) {
+	Mesh *levels[1] = { (Mesh*)mesh };
+	return mesh ? save_cache(levels, 1, source_path, path) : false;
+}
+
+bool save_mesh_lod_cache(const MeshLod *lod, const char *source_path, const char *path) {
+	return lod ? save_cache(lod->levels, lod->level_count, source_path, path) : false;
+}
+
+// A negative index wraps around to a large unsigned one, so one compare catches both ends
+static bool indices_in_range(const int *indices, long count, int vertex_count) {
+	unsigned int invalid = 0;
+	for (long i = 0; i < count; i++) {
+		invalid |= (unsigned int)indices[i] >= (unsigned int)vertex_count;
+	}
+	return invalid == 0;
+}
+
+// Points the mesh into the level at *offset and moves past it, false when the
+// level is not one this machine wrote or runs past the end of the file
+static bool map_cache_level(const FileView *view, size_t *offset, CacheHeader *header, Mesh *mesh) {
+	if (view->size - *offset < sizeof(*header)) {
+		return false;
+	}
+	memcpy(header, view->data + *offset, sizeof(*header));
+	bool valid = memcmp(header->magic, CACHE_MAGIC, sizeof(header->magic)) == 0 && header->byte_order == CACHE_BYTE_ORDER
+		&& header->vertex_count >= 0 && header->triangle_count >= 0 && header->edge_count >= 0
+		&& view->size - *offset >= cache_size(header->vertex_count, header->triangle_count, header->edge_count);
+	// Every draw indexes the positions with these, unchecked
+	unsigned char *memory = view->data + *offset + sizeof(*header);
+	if ((!valid) || !indices_in_range((const int*)memory, 3L * header->triangle_count + 2L * header->edge_count, header->vertex_count)) {
+		return false;
+	}
+	
+	// The arrays are used in place
+	mesh->triangles = (int (*)[3])memory;
+	memory += header->triangle_count * sizeof(int[3]);
+	mesh->edges = (int (*)[2])memory;
+	memory += header->edge_count * sizeof(int[2]);
+	mesh->x = (float*)memory;
+	mesh->y = mesh->x + header->vertex_count;
+	mesh->z = mesh->y + header->vertex_count;
+	mesh->vertex_count = header->vertex_count;
+	mesh->triangle_count = header->triangle_count;
+	mesh->edge_count = header->edge_count;
+	mesh->edge_capacity = header->edge_count;
+	mesh->bounds_center = (Vec3){ header->bounds_center[0], header->bounds_center[1], header->bounds_center[2] };
+	mesh->bounds_radius = header->bounds_radius;
+	*offset += cache_size(header->vertex_count, header->triangle_count, header->edge_count);
+	return true;
+}
+
+MappedMesh *map_mesh_cache(const char *path) {
+	FileView view;
+	if (!open_file_view(path, &view)) {
+		return NULL;
+	}
+	MappedMesh *mapped = calloc(1, sizeof(MappedMesh));
+	if (!mapped) {
+		close_file_view(&view);
+		return NULL;
+	}
+	
+	// The full mesh, then the coarser levels its header counts, up to the end of the file
+	size_t offset = 0;
+	CacheHeader header;
+	bool valid = map_cache_level(&view, &offset, &header, &mapped->mesh);
+	int level_count = valid ? header.level_count : 0;
+	valid = valid && level_count >= 1 && level_count <= MESH_LOD_MAX_LEVELS;
+	mapped->lod.levels[0] = &mapped->mesh;
+	mapped->lod.level_count = 1;
+	while (valid && mapped->lod.level_count < level_count) {
+		Mesh *level = &mapped->coarser[mapped->lod.level_count - 1];
+		valid = map_cache_level(&view, &offset, &header, level) && header.level_count == level_count;
+		mapped->lod.levels[mapped->lod.level_count++] = level;
+	}
+	if (!(valid && offset == view.size)) {
+		close_file_view(&view);
+		free(mapped);
+		return NULL;
+	}
+	mapped->mapping = view.data;
+	mapped->size = view.size;
+	return mapped;
+}
+
+void unmap_mesh_cache(MappedMesh **mapped) {
+	if ((!mapped) || (!(*mapped))) {
+		return;
+	}
+	
+	FileView view = { (*mapped)->mapping, (*mapped)->size };
+	close_file_view(&view);
+	free(*mapped);
+	*mapped = NULL;
+}
+
+// Nanoseconds where the platform keeps them, whole seconds otherwise
+static long long modified_time(const struct stat *info) {
+#if defined(__APPLE__)
+	return (long long)info->st_mtimespec.tv_sec * 1000000000LL + info->st_mtimespec.tv_nsec;
+#elif defined(_WIN32)
+	return (long long)info->st_mtime * 1000000000LL;
+#else
+	return (long long)info->st_mtim.tv_sec * 1000000000LL + info->st_mtim.tv_nsec;
+#endif
+}
+
+bool mesh_cache_fresh(const char *path, const char *cache_path) {
+	struct stat source;
+	struct stat cache;
+	if ((!path) || (!cache_path) || stat(path, &source) != 0 || stat(cache_path, &cache) != 0) {
+		return false;
+	}
+	// A source saved in the same tick as the cache may be newer than it
+	if (modified_time(&cache) <= modified_time(&source)) {
+		return false;
+	}
+	
+	// Catches sources replaced by an older file, or changed within the clock's resolution
+	FILE *file = fopen(cache_path, "rb");
+	if (!file) {
+		return false;
+	}
+	CacheHeader header;
+	bool fresh = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, CACHE_MAGIC, sizeof(header.magic)) == 0
+		&& header.source_size == (uint64_t)source.st_size;
+	fclose(file);
+	return fresh;
+}
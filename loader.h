@@ -0,0 +1,67 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "mesh.h"
+
+// ### STRUCTS AND ENUMS ### //
+typedef enum {
+	MESH_FORMAT_UNKNOWN,
+	MESH_FORMAT_OBJ,
+	MESH_FORMAT_PLY,
+	MESH_FORMAT_STL,
+	MESH_FORMAT_CACHE,
+} MeshFormat;
+
+// Mesh whose arrays point straight into a mapped cache file, with the detail
+// levels the cache holds. Writes to them stay private to the process, the file
+// is never changed
+typedef struct {
+	Mesh mesh;
+	// lod.levels[0] is mesh, the coarser levels are in coarser; all are owned by
+	// the mapping, so the lod is never passed to destroy_mesh_lod
+	MeshLod lod;
+	Mesh coarser[MESH_LOD_MAX_LEVELS - 1];
+	void *mapping;
+	size_t size;
+} MappedMesh;
+
+// ### FUNCTION DECLARATIONS ### //
+// # LOADING # //
+// From the file extension, case insensitive
+MeshFormat mesh_format_from_path(const char *path);
+// The file is mapped and read twice, once to count and once to fill a single
+// create_mesh allocation, so nothing is allocated per vertex or per face.
+// Polygons are split into fans, the unique edges are built and the bounds computed.
+// Return NULL when the file cannot be read or is malformed
+
+// Positions of "v" lines and the vertex of each "f" corner, other lines are skipped
+Mesh *load_obj(const char *path);
+// ASCII and binary of either byte order; x, y, z of "vertex" and the
+// "vertex_indices" list of "face", other elements and properties are skipped
+Mesh *load_ply(const char *path);
+// Binary only; corners with the same position are welded into one vertex
+Mesh *load_stl(const char *path);
+// Any of the three, by extension
+Mesh *load_mesh(const char *path);
+
+// # BINARY CACHE # //
+// The mesh arrays as they are in memory, behind a short header; only readable
+// on machines with the same byte order and int size. The header keeps the size
+// of source_path, which may be NULL for a mesh not loaded from a file
+bool save_mesh_cache(const Mesh *mesh, const char *source_path, const char *path);
+// Every level of the lod, one after the other, so a later run maps them instead
+// of simplifying the mesh again
+bool save_mesh_lod_cache(const MeshLod *lod, const char *source_path, const char *path);
+// Maps the cache and all its levels without copying the arrays. The triangle and
+// edge indices are read once to check they are in range, the positions are loaded
+// on first use. Returns NULL for a cache that is truncated, from another machine
+// or out of range
+MappedMesh *map_mesh_cache(const char *path);
+void unmap_mesh_cache(MappedMesh **mapped);
+// Whether the cache exists, was written after the source file last changed and
+// was made from a source of the size it has now
+bool mesh_cache_fresh(const char *path, const char *cache_path);
+
+#endif
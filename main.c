@@ -1,31 +1,730 @@
 #include <SDL2/SDL.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <stdbool.h>
 #include "graphics.h"
+#include "tiler.h"
+#include "framebuffer.h"
+#include "stats.h"
+#include "loader.h"
 
 // ### CONSTANTS ### //
-extern const int SCREEN_WIDTH;
-extern const int SCREEN_HEIGHT;
-extern const float FIELD_OF_VIEW;
-extern const float NEAR;
-extern const float FAR;
+// Render target size when --width and --height are not given
+const int DEFAULT_WIDTH = 640;
+const int DEFAULT_HEIGHT = 480;
 const float X_ROTATION_THETA = 0.01f;
 const float Y_ROTATION_THETA = 0.01f;
 const float Z_ROTATION_THETA = 0.01f;
+const float TWO_PI = 6.2831853f;
+// Frames rendered by --headless when --frames is not given
+const int DEFAULT_HEADLESS_FRAMES = 600;
+// Window mode presents at this rate, unless the display's vsync is slower
+const int TARGET_FRAME_RATE = 60;
+// Longest the event loop blocks waiting for a rendered frame
+const Uint32 EVENT_POLL_MS = 4;
+// --model meshes are scaled so their bounding sphere matches the cube's
+const float MODEL_RADIUS = 4.33f;
+// Detail levels built for a --model, enough to take a million triangles down to a few thousand
+const int MODEL_LOD_LEVELS = MESH_LOD_MAX_LEVELS;
+// Rendered frames in flight between the render thread and the window
+#define PRESENT_SLOTS 3
 
-// ### MAIN FUNCTION ###
-int main() {
+// ### STRUCTS ### //
+typedef struct {
+	bool headless;
+	int frame_count;
+	int width;
+	int height;
+	// Frame i is written to <dump_prefix>_<i>.ppm when set
+	const char *dump_prefix;
+	// Redraw every pixel of every frame instead of only what changed
+	bool full_redraw;
+	// Start with the animation paused
+	bool still;
+	// Draw the rolling frame stats over the top left corner
+	bool overlay;
+	// Every frame's stage times and counters are written to this CSV file when set
+	const char *stats_path;
+	// Draw the cube and tetrahedron as solids instead of wireframes
+	bool filled;
+	// Mesh file drawn in place of the cube when set
+	const char *model_path;
+	// Draw every triangle of the model instead of the detail level its size on screen needs
+	bool full_detail;
+	// Frame and bin arenas of at least this many megabytes when not 0, so a reference
+	// run never has to flush its bins
+	int arena_megabytes;
+} Options;
+
+typedef enum {
+	SCENE_CUBE,
+	SCENE_TETRAHEDRON,
+	SCENE_TRIANGLE,
+	SCENE_OBJECT_COUNT,
+} SceneObject;
+
+// Everything drawn each frame, shared by the window and headless loops
+typedef struct {
+	Cube cube;
+	// Same cube with its faces, for drawing it solid
+	FilledCube filled_cube;
+	Tetrahedron th;
+	Triangle t;
+	ColorRgb red;
+	ColorRgb green;
+	ColorRgb blue;
+	// The cube spins through its model matrix, its vertices stay as created
+	Transform cube_transform;
+	// Loaded --model, spun like the cube in its place, with its detail levels.
+	// Either owned or mapped from its cache; model is the full detail level
+	MeshLod *loaded_model;
+	MappedMesh *mapped_model;
+	const MeshLod *model_lod;
+	const Mesh *model;
+	bool full_detail;
+	// Centers the model on the origin at the cube's size
+	Matrix4 model_fit;
+	// Box around its bounding sphere, in model space
+	Vec3 model_corners[8];
+	bool paused;
+	bool filled;
+	// Screen bounds of each object as last drawn, and whether it moved since
+	ScreenRect bounds[SCENE_OBJECT_COUNT];
+	bool changed[SCENE_OBJECT_COUNT];
+} Scene;
+
+// Per-frame resources, created once
+typedef struct {
+	Camera cam;
+	RenderContext ctx;
+	Arena *frame_arena;
+	Arena *bin_arena;
+	TileRenderer *tile_renderer;
+	DepthBuffer *depth_buffer;
+	// Kept between frames, only the dirty region is cleared and redrawn
+	RenderTarget *target;
+	DirtyRegion dirty;
+	// Set for the first frame, and whenever the camera moves or the target is resized
+	bool full_redraw;
+	bool incremental;
+	// The frame being rendered; its stages are only timed while ctx.stats points here,
+	// the frame time always is
+	FrameStats stats;
+	StatsHistory history;
+	int frame_number;
+	bool overlay;
+	// CSV rows of every frame are written here when set
+	FILE *stats_file;
+} Renderer;
+
+// One rendered frame on its way to the window texture
+typedef struct {
+	// Same size as the render target; only the dirty rectangles are current,
+	// as the texture keeps everything else from earlier frames
+	Uint32 *pixels;
+	int width;
+	int height;
+	int pitch;
+	DirtyRegion dirty;
+} PresentSlot;
+
+// FIFO of rendered frames: the render thread fills the slots in order while the
+// window uploads and presents the earlier ones in the same order
+typedef struct {
+	Renderer *renderer;
+	Scene *scene;
+	PresentSlot slots[PRESENT_SLOTS];
+	SDL_sem *free_slots;
+	SDL_sem *ready_slots;
+	// Input from the event loop, applied by the render thread between frames
+	SDL_mutex *input_lock;
+	bool toggle_pause;
+	int resize_width;
+	int resize_height;
+	// Upload and present time of the latest frame the window showed
+	Uint64 present_ticks;
+	SDL_atomic_t quit;
+} PresentQueue;
+
+// ### FUNCTION DEFINITIONS ### //
+static void print_usage(const char *program) {
+	printf("Usage: %s [--headless] [--frames N] [--width W] [--height H] [--dump PREFIX] [--full-redraw] [--still] [--overlay] [--stats FILE] [--filled] [--model FILE] [--full-detail] [--arena MB]\n", program);
+	printf("  --headless      render offscreen without a window, as fast as possible\n");
+	printf("  --frames N      number of headless frames (default %d)\n", DEFAULT_HEADLESS_FRAMES);
+	printf("  --width W       render target width in pixels (default %d)\n", DEFAULT_WIDTH);
+	printf("  --height H      render target height in pixels (default %d)\n", DEFAULT_HEIGHT);
+	printf("  --dump PREFIX   write every headless frame to PREFIX_NNNN.ppm\n");
+	printf("  --full-redraw   redraw the whole frame every frame, not only what changed\n");
+	printf("  --still         start with the animation paused (space toggles it)\n");
+	printf("  --overlay       draw the p50 and p99 stage times and the frame counters\n");
+	printf("  --stats FILE    write the stage times and counters of every frame to a CSV file\n");
+	printf("  --filled        draw the cube and tetrahedron as solids\n");
+	printf("  --model FILE    draw an OBJ, PLY or STL mesh in place of the cube, cached in FILE.cache\n");
+	printf("  --full-detail   draw every triangle of the model, not the detail level its size needs\n");
+	printf("  --arena MB      make the frame and bin arenas at least MB megabytes each\n");
+}
+
+static bool parse_options(int argc, char *argv[], Options *options) {
+	*options = (Options){ false, DEFAULT_HEADLESS_FRAMES, DEFAULT_WIDTH, DEFAULT_HEIGHT, NULL, false, false, false, NULL, false, NULL, false, 0 };
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0) {
+			options->headless = true;
+		} else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			options->frame_count = atoi(argv[++i]);
+			if (options->frame_count <= 0) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+			options->width = atoi(argv[++i]);
+			if (options->width <= 0) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+			options->height = atoi(argv[++i]);
+			if (options->height <= 0) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "--dump") == 0 && i + 1 < argc) {
+			options->dump_prefix = argv[++i];
+		} else if (strcmp(argv[i], "--full-redraw") == 0) {
+			options->full_redraw = true;
+		} else if (strcmp(argv[i], "--still") == 0) {
+			options->still = true;
+		} else if (strcmp(argv[i], "--overlay") == 0) {
+			options->overlay = true;
+		} else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+			options->stats_path = argv[++i];
+		} else if (strcmp(argv[i], "--filled") == 0) {
+			options->filled = true;
+		} else if (strcmp(argv[i], "--model") == 0 && i + 1 < argc) {
+			options->model_path = argv[++i];
+		} else if (strcmp(argv[i], "--full-detail") == 0) {
+			options->full_detail = true;
+		} else if (strcmp(argv[i], "--arena") == 0 && i + 1 < argc) {
+			options->arena_megabytes = atoi(argv[++i]);
+			if (options->arena_megabytes <= 0) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+	}
+
+	// Frames are only dumped offscreen
+	return options->headless || !options->dump_prefix;
+}
+
+static void init_scene(Scene *scene, bool paused, bool filled, bool full_detail) {
+	// Cube
+	Vec3 origin = { 0.0f, 0.0f, 0.0f };
+	float side_length = 5.0f;
+	scene->cube = create_cube(origin, side_length);
+	scene->filled_cube = create_filled_cube(origin, side_length);
+	scene->red = (ColorRgb){ 200, 0, 0, 255 };
+	scene->green = (ColorRgb){ 0, 200, 0, 255 };
+	scene->blue = (ColorRgb){ 0, 0, 200, 255 };
+
+	// Tetrehedron
+	scene->th = create_tetrahedron(origin, side_length);
+
+	// Triangle
+	scene->t = (Triangle){
+		.vertices = {
+			(Vec3){ 2.5f, 0.0f, 0.0f }, (Vec3){ 0.0f, 4.33f, 0.0f }, (Vec3){ -2.5f, 0.0f, 0.0f }
+		},
+	};
+
+	// Cube placement
+	scene->cube_transform = (Transform){ origin, { 0.0f, 0.0f, 0.0f }, 1.0f };
+	scene->paused = paused;
+	scene->filled = filled;
+	scene->loaded_model = NULL;
+	scene->mapped_model = NULL;
+	scene->model_lod = NULL;
+	scene->model = NULL;
+	scene->full_detail = full_detail;
+
+	// Nothing drawn yet
+	for (int i = 0; i < SCENE_OBJECT_COUNT; i++) {
+		scene->bounds[i] = (ScreenRect){ 0, 0, 0, 0 };
+		scene->changed[i] = true;
+	}
+}
+
+// Maps the binary cache next to the file when it is newer than the file,
+// otherwise parses the file, simplifies it into its detail levels and writes
+// them all to the cache for the next run
+static bool load_scene_model(Scene *scene, const char *path) {
+	char cache_path[4096];
+	if (snprintf(cache_path, sizeof(cache_path), "%s.cache", path) >= (int)sizeof(cache_path)) {
+		return false;
+	}
+	if (mesh_cache_fresh(path, cache_path)) {
+		scene->mapped_model = map_mesh_cache(cache_path);
+	}
+	if (scene->mapped_model) {
+		scene->model_lod = &scene->mapped_model->lod;
+	} else {
+		Mesh *mesh = load_mesh(path);
+		scene->loaded_model = mesh ? create_mesh_lod(mesh, MODEL_LOD_LEVELS) : NULL;
+		destroy_mesh(&mesh);
+		if (!scene->loaded_model) {
+			return false;
+		}
+		if (!save_mesh_lod_cache(scene->loaded_model, path, cache_path)) {
+			printf("Error writing %s\n", cache_path);
+		}
+		scene->model_lod = scene->loaded_model;
+	}
+	scene->model = scene->model_lod->levels[0];
+
+	Vec3 center = scene->model->bounds_center;
+	float radius = scene->model->bounds_radius;
+	float scale = radius > 0.0f ? MODEL_RADIUS / radius : 1.0f;
+	Vec3 position = { -center.x * scale, -center.y * scale, -center.z * scale };
+	scene->model_fit = transform_matrix((Transform){ position, { 0.0f, 0.0f, 0.0f }, scale });
+	for (int i = 0; i < 8; i++) {
+		scene->model_corners[i] = (Vec3){
+			center.x + (i & 1 ? radius : -radius),
+			center.y + (i & 2 ? radius : -radius),
+			center.z + (i & 4 ? radius : -radius),
+		};
+	}
+	return true;
+}
+
+static void release_scene_model(Scene *scene) {
+	destroy_mesh_lod(&scene->loaded_model);
+	unmap_mesh_cache(&scene->mapped_model);
+	scene->model_lod = NULL;
+	scene->model = NULL;
+}
+
+// frame_arena_size is at least FRAME_ARENA_SIZE, more to fit the vertices of a loaded model
+static bool create_renderer(Renderer *renderer, int width, int height, bool incremental, size_t frame_arena_size, size_t bin_arena_size) {
+	// Allocated once, reset at the start of every frame
+	renderer->frame_arena = create_arena(frame_arena_size);
+	if (!renderer->frame_arena) {
+		printf("Frame arena allocation error\n");
+		return false;
+	}
+	renderer->bin_arena = create_arena(bin_arena_size);
+	if (!renderer->bin_arena) {
+		printf("Bin arena allocation error\n");
+		destroy_arena(&renderer->frame_arena);
+		return false;
+	}
+
+	// Uploaded to the window texture, or dumped, one dirty rectangle at a time
+	renderer->target = create_render_target(width, height);
+	if (!renderer->target) {
+		printf("Render target allocation error\n");
+		destroy_arena(&renderer->bin_arena);
+		destroy_arena(&renderer->frame_arena);
+		return false;
+	}
+	renderer->full_redraw = true;
+	renderer->incremental = incremental;
+	dirty_region_clear(&renderer->dirty);
+	frame_stats_reset(&renderer->stats);
+	stats_history_clear(&renderer->history);
+	renderer->frame_number = 0;
+	renderer->overlay = false;
+	renderer->stats_file = NULL;
+
+	// Rasterizes the binned draw calls on every CPU
+	renderer->tile_renderer = create_tile_renderer(0);
+	if (!renderer->tile_renderer) {
+		printf("Tile renderer error\n");
+		destroy_render_target(&renderer->target);
+		destroy_arena(&renderer->bin_arena);
+		destroy_arena(&renderer->frame_arena);
+		return false;
+	}
+
+	// Shared by every draw call, so overlapping objects occlude each other
+	renderer->depth_buffer = create_depth_buffer(width, height);
+	if (!renderer->depth_buffer) {
+		printf("Depth buffer allocation error\n");
+		destroy_tile_renderer(&renderer->tile_renderer);
+		destroy_render_target(&renderer->target);
+		destroy_arena(&renderer->bin_arena);
+		destroy_arena(&renderer->frame_arena);
+		return false;
+	}
+
+	// Graphics variables
+	Vec3 eye = { 0.0f, 0.0f, 12.0f };
+	Vec3 center = { 0.0f, 0.0f, 0.0f };
+	Vec3 up = { 0.0f, 1.0f, 0.0f };
+	renderer->cam = (Camera){ eye, center, up, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	init_render_context(&renderer->ctx, &renderer->cam, renderer->target, renderer->frame_arena);
+	renderer->ctx.tile_renderer = renderer->tile_renderer;
+	renderer->ctx.bin_arena = renderer->bin_arena;
+	renderer->ctx.depth_buffer = renderer->depth_buffer;
+	return true;
+}
+
+static void destroy_renderer(Renderer *renderer) {
+	destroy_depth_buffer(&renderer->depth_buffer);
+	destroy_tile_renderer(&renderer->tile_renderer);
+	destroy_render_target(&renderer->target);
+	destroy_arena(&renderer->bin_arena);
+	destroy_arena(&renderer->frame_arena);
+}
+
+// The next frame sees the new size through the render context and redraws everything
+static bool resize_renderer(Renderer *renderer, int width, int height) {
+	DepthBuffer *depth_buffer = create_depth_buffer(width, height);
+	if ((!depth_buffer) || (!resize_render_target(renderer->target, width, height))) {
+		destroy_depth_buffer(&depth_buffer);
+		return false;
+	}
+	destroy_depth_buffer(&renderer->depth_buffer);
+	renderer->depth_buffer = depth_buffer;
+	renderer->ctx.depth_buffer = depth_buffer;
+	return true;
+}
+
+// The cube is placed by its transform, the rest directly in world space
+static void set_object_model_matrix(RenderContext *ctx, Scene *scene, SceneObject object) {
+	if (object == SCENE_CUBE && scene->model) {
+		set_model_matrix(ctx, mat4_mul(transform_matrix(scene->cube_transform), scene->model_fit));
+	} else if (object == SCENE_CUBE) {
+		set_model_matrix(ctx, transform_matrix(scene->cube_transform));
+	} else {
+		set_model_matrix(ctx, scale_transformation(1.0f));
+	}
+}
+
+static ScreenRect object_bounds(RenderContext *ctx, Scene *scene, SceneObject object) {
+	set_object_model_matrix(ctx, scene, object);
+	switch (object) {
+		case SCENE_CUBE:
+			if (scene->model) {
+				return screen_bounds(ctx, scene->model_corners, 8);
+			}
+			// The axis of rotation joins two of the cube's vertices
+			return screen_bounds(ctx, scene->cube.vertices, 8);
+		case SCENE_TETRAHEDRON:
+			return screen_bounds(ctx, scene->th.vertices, 4);
+		default:
+			return screen_bounds(ctx, scene->t.vertices, 3);
+	}
+}
+
+static void draw_scene_object(RenderContext *ctx, Scene *scene, SceneObject object) {
+	set_object_model_matrix(ctx, scene, object);
+	switch (object) {
+		case SCENE_CUBE: {
+			if (scene->model) {
+				bool model_draw_result;
+				if (scene->full_detail) {
+					model_draw_result = scene->filled ? draw_filled_mesh(ctx, scene->model, scene->green) : draw_mesh(ctx, scene->model, scene->green);
+				} else {
+					model_draw_result = scene->filled ? draw_filled_mesh_lod(ctx, scene->model_lod, scene->green) : draw_mesh_lod(ctx, scene->model_lod, scene->green);
+				}
+				if (!model_draw_result) {
+					printf("Error drawing model\n");
+				}
+				break;
+			}
+			// Cube, and its axis of rotation
+			bool cube_draw_result = scene->filled ? draw_filled_cube(ctx, scene->filled_cube, scene->green) : draw_cube(ctx, scene->cube, scene->green);
+			if (!cube_draw_result) {
+				printf("Error drawing cube\n");
+			}
+			bool line_draw_result = draw_line(ctx, scene->cube.vertices[0], scene->cube.vertices[6], scene->blue);
+			if (!line_draw_result) {
+				printf("Error drawing line\n");
+			}
+			break;
+		}
+		case SCENE_TETRAHEDRON: {
+			bool th_draw_result = scene->filled ? draw_filled_tetrahedron(ctx, scene->th, scene->red) : draw_tetrahedron(ctx, scene->th, scene->red);
+			if (!th_draw_result) {
+				printf("Error drawing tetrahedron\n");
+			}
+			break;
+		}
+		default: {
+			bool triangle_draw_result = draw_triangle(ctx, scene->t, scene->green);
+			if (!triangle_draw_result) {
+				printf("Error drawing triangle\n");
+			}
+			break;
+		}
+	}
+}
+
+// Redraws only the region covered by changed objects before and after they
+// moved, leaving renderer->dirty as the rectangles that were redrawn
+static void render_frame(Renderer *renderer, Scene *scene) {
+	Uint64 frame_start = SDL_GetPerformanceCounter();
+	frame_stats_reset(&renderer->stats);
+	arena_reset(renderer->frame_arena);
+	arena_reset(renderer->bin_arena);
+	// Rebuild the view-projection only if the camera moved or the target was resized,
+	// either moves everything on screen
+	RenderContext *ctx = &renderer->ctx;
+	if (update_render_context(ctx, &renderer->cam) || !renderer->incremental) {
+		renderer->full_redraw = true;
+	}
+
+	DirtyRegion *dirty = &renderer->dirty;
+	dirty_region_clear(dirty);
+	for (int i = 0; i < SCENE_OBJECT_COUNT; i++) {
+		if (scene->changed[i] || renderer->full_redraw) {
+			ScreenRect bounds = object_bounds(ctx, scene, i);
+			dirty_region_add(dirty, scene->bounds[i]);
+			dirty_region_add(dirty, bounds);
+			scene->bounds[i] = bounds;
+			scene->changed[i] = false;
+		}
+	}
+	RenderTarget *target = renderer->target;
+	ScreenRect whole_target = { 0, 0, target->width, target->height };
+	if (renderer->overlay) {
+		// Its numbers change every frame
+		dirty_region_add(dirty, stats_overlay_bounds(target));
+	}
+	if (renderer->full_redraw) {
+		dirty_region_clear(dirty);
+		dirty_region_add(dirty, whole_target);
+		renderer->full_redraw = false;
+	}
+
+	// The rectangles are disjoint, so clearing them all first never erases a redrawn one.
+	// A region that is the whole target is cleared as one span, not row by row
+	Uint64 timer = stats_start(ctx->stats);
+	ScreenRect first = dirty->rects[0];
+	bool whole = dirty->count == 1 && first.min_x <= 0 && first.min_y <= 0 && first.max_x >= target->width && first.max_y >= target->height;
+	if (whole) {
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0xFF000000);
+		clear_depth_buffer(renderer->depth_buffer);
+	} else {
+		for (int i = 0; i < dirty->count; i++) {
+			ScreenRect rect = dirty->rects[i];
+			fill_rect(target->pixels, target->pitch, rect.min_x, rect.min_y, rect.max_x, rect.max_y, 0xFF000000);
+			clear_depth_rect(renderer->depth_buffer, rect.min_x, rect.min_y, rect.max_x, rect.max_y);
+		}
+	}
+	stats_lap(ctx->stats, STAT_STAGE_CLEAR, timer);
+
+	// Every object reaching into a rectangle is drawn again, clipped to it,
+	// so unchanged objects overlapping a moved one are restored
+	// What a draw takes from the frame arena is dead once it returns, the bins are
+	// in the bin arena, so each draw gets the whole frame arena
+	for (int i = 0; i < dirty->count; i++) {
+		ctx->scissor = dirty->rects[i];
+		for (int j = 0; j < SCENE_OBJECT_COUNT; j++) {
+			if (screen_rects_overlap(scene->bounds[j], dirty->rects[i])) {
+				size_t mark = arena_mark(renderer->frame_arena);
+				draw_scene_object(ctx, scene, j);
+				stats_count(ctx->stats, STAT_BYTES_ALLOCATED, (long)(renderer->frame_arena->offset - mark));
+				arena_rewind(renderer->frame_arena, mark);
+			}
+		}
+	}
+	ctx->scissor = whole_target;
+
+	// Rasterize the binned objects, before the frame arena is reset
+	timer = stats_start(ctx->stats);
+	tile_renderer_flush(renderer->tile_renderer);
+	stats_lap(ctx->stats, STAT_STAGE_RASTER, timer);
+	stats_count(ctx->stats, STAT_PIXELS_WRITTEN, tile_renderer_pixels_written(renderer->tile_renderer));
+	stats_count(ctx->stats, STAT_BYTES_ALLOCATED, (long)(renderer->frame_arena->offset + renderer->bin_arena->offset));
+
+	// Shows the frames before this one, this frame is only timed once it is done
+	if (renderer->overlay) {
+		stats_draw_overlay(target, &renderer->history);
+	}
+	renderer->stats.frame_ticks = SDL_GetPerformanceCounter() - frame_start;
+}
+
+// Adds the frame to the rolling percentiles and the CSV file, once its present time is known
+static void record_frame_stats(Renderer *renderer) {
+	stats_history_add(&renderer->history, &renderer->stats);
+	if (renderer->stats_file) {
+		stats_write_csv_row(renderer->stats_file, renderer->frame_number, &renderer->stats);
+	}
+	renderer->frame_number++;
+}
+
+static void update_scene(Scene *scene) {
+	if (scene->paused) {
+		return;
+	}
+
+	// Only the angles advance, wrapped so they keep their precision in long sessions
+	Vec3 *rotation = &scene->cube_transform.rotation;
+	rotation->x = fmodf(rotation->x + X_ROTATION_THETA, TWO_PI);
+	rotation->y = fmodf(rotation->y + Y_ROTATION_THETA, TWO_PI);
+	rotation->z = fmodf(rotation->z + Z_ROTATION_THETA, TWO_PI);
+	scene->changed[SCENE_CUBE] = true;
+}
+
+// Binary PPM (P6), the alpha channel is dropped
+static bool write_ppm(const char *path, const RenderTarget *target) {
+	int width = target->width;
+	int height = target->height;
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+
+	Uint8 *row = malloc(width * 3);
+	if (!row) {
+		fclose(file);
+		return false;
+	}
+
+	bool result = fprintf(file, "P6\n%d %d\n255\n", width, height) > 0;
+	for (int y = 0; y < height && result; y++) {
+		const Uint32 *pixels = target->pixels + y * (target->pitch / 4);
+		for (int x = 0; x < width; x++) {
+			row[3 * x] = (pixels[x] >> 16) & 0xFF;
+			row[3 * x + 1] = (pixels[x] >> 8) & 0xFF;
+			row[3 * x + 2] = pixels[x] & 0xFF;
+		}
+		result = fwrite(row, 3, width, file) == (size_t)width;
+	}
+
+	free(row);
+	return (fclose(file) == 0) && result;
+}
+
+// Renders into memory with no window and no frame pacing, then reports the throughput
+static int run_headless(Renderer *renderer, Scene *scene, Options *options) {
+	// Only rendering is timed, the dumps are excluded
+	Uint64 render_ticks = 0;
+	long redrawn_pixels = 0;
+	for (int frame = 0; frame < options->frame_count; frame++) {
+		Uint64 frame_start = SDL_GetPerformanceCounter();
+		render_frame(renderer, scene);
+		update_scene(scene);
+		render_ticks += SDL_GetPerformanceCounter() - frame_start;
+		redrawn_pixels += dirty_region_area(&renderer->dirty);
+
+		// Writing the dump stands in for presenting the frame
+		if (options->dump_prefix) {
+			char path[4096];
+			snprintf(path, sizeof(path), "%s_%04d.ppm", options->dump_prefix, frame);
+			Uint64 timer = stats_start(renderer->ctx.stats);
+			if (!write_ppm(path, renderer->target)) {
+				printf("Error writing %s\n", path);
+				return 1;
+			}
+			stats_lap(renderer->ctx.stats, STAT_STAGE_PRESENT, timer);
+		}
+		record_frame_stats(renderer);
+	}
+
+	double seconds = (double)render_ticks / (double)SDL_GetPerformanceFrequency();
+	RenderTarget *target = renderer->target;
+	double redrawn_fraction = (double)redrawn_pixels / ((double)options->frame_count * target->width * target->height);
+	// Percentiles of the last STATS_HISTORY frames
+	double p50 = stats_history_percentile_ms(&renderer->history, STAT_STAGE_COUNT, 50.0);
+	double p99 = stats_history_percentile_ms(&renderer->history, STAT_STAGE_COUNT, 99.0);
+	printf("frames,width,height,threads,seconds,ms_per_frame,fps,redrawn_fraction,p50_ms,p99_ms\n");
+	printf("%d,%d,%d,%d,%.6f,%.4f,%.1f,%.4f,%.4f,%.4f\n", options->frame_count, target->width, target->height, tile_renderer_thread_count(renderer->tile_renderer), seconds, 1000.0 * seconds / options->frame_count, options->frame_count / seconds, redrawn_fraction, p50, p99);
+	return 0;
+}
+
+// ## PRESENT PIPELINE ## //
+// Copies the rectangles just redrawn into the slot, reallocating it after a resize
+static bool fill_present_slot(PresentSlot *slot, const RenderTarget *target, const DirtyRegion *dirty) {
+	if (slot->width != target->width || slot->height != target->height) {
+		free(slot->pixels);
+		slot->pixels = malloc((size_t)target->height * target->pitch);
+		slot->width = slot->pixels ? target->width : 0;
+		slot->height = slot->pixels ? target->height : 0;
+		slot->pitch = target->pitch;
+		if (!slot->pixels) {
+			dirty_region_clear(&slot->dirty);
+			return false;
+		}
+	}
+	
+	slot->dirty = *dirty;
+	for (int i = 0; i < dirty->count; i++) {
+		ScreenRect rect = dirty->rects[i];
+		size_t row_bytes = (size_t)(rect.max_x - rect.min_x) * sizeof(Uint32);
+		for (int y = rect.min_y; y < rect.max_y; y++) {
+			memcpy(slot->pixels + y * (slot->pitch / 4) + rect.min_x, target->pixels + y * (target->pitch / 4) + rect.min_x, row_bytes);
+		}
+	}
+	return true;
+}
+
+// Renders frames into the free slots, at most PRESENT_SLOTS ahead of the window
+static int render_thread_main(void *data) {
+	PresentQueue *queue = data;
+	Renderer *renderer = queue->renderer;
+	Scene *scene = queue->scene;
+	for (int index = 0; ; index = (index + 1) % PRESENT_SLOTS) {
+		SDL_SemWait(queue->free_slots);
+		if (SDL_AtomicGet(&queue->quit)) {
+			return 0;
+		}
+		
+		SDL_LockMutex(queue->input_lock);
+		bool toggle_pause = queue->toggle_pause;
+		int width = queue->resize_width;
+		int height = queue->resize_height;
+		Uint64 present_ticks = queue->present_ticks;
+		queue->toggle_pause = false;
+		queue->resize_width = 0;
+		queue->resize_height = 0;
+		SDL_UnlockMutex(queue->input_lock);
+		if (toggle_pause) {
+			scene->paused = !scene->paused;
+		}
+		if (width > 0 && height > 0 && !resize_renderer(renderer, width, height)) {
+			printf("Resize error\n");
+		}
+		
+		render_frame(renderer, scene);
+		update_scene(scene);
+		// Frames are presented after they are recorded, so this is an earlier frame's
+		renderer->stats.stage_ticks[STAT_STAGE_PRESENT] = present_ticks;
+		record_frame_stats(renderer);
+		if (!fill_present_slot(&queue->slots[index], renderer->target, &renderer->dirty)) {
+			// The window missed this frame, so the next one redraws everything
+			printf("Present slot allocation error\n");
+			renderer->full_redraw = true;
+		}
+		SDL_SemPost(queue->ready_slots);
+	}
+}
+
+// SDL_Delay only has millisecond granularity, so the last millisecond is spun
+static void wait_until(Uint64 deadline) {
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 now;
+	while ((now = SDL_GetPerformanceCounter()) < deadline) {
+		Uint64 remaining_ms = (deadline - now) * 1000 / frequency;
+		if (remaining_ms > 1) {
+			SDL_Delay((Uint32)(remaining_ms - 1));
+		}
+	}
+}
+
+static int run_window(Renderer *renderer, Scene *scene) {
 	if (SDL_Init(SDL_INIT_VIDEO) != 0) {
 		printf("SDL_Init Error: %s\n", SDL_GetError());
         return 1;
 	}
 
+	RenderTarget *target = renderer->target;
 	SDL_Window *window = SDL_CreateWindow(
 		"Pixel Buffer",
         SDL_WINDOWPOS_CENTERED,
         SDL_WINDOWPOS_CENTERED,
-        640, 480,
-        0
+        target->width, target->height,
+        SDL_WINDOW_RESIZABLE
 	);
 
 	if (!window) {
@@ -34,23 +733,37 @@ int main() {
 		return 1;
 	}
 
-	SDL_Renderer *renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-	if (!renderer) {
+	SDL_Renderer *sdl_renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+	if (!sdl_renderer) {
 		printf("Renderer error: %s\n", SDL_GetError());
 		SDL_DestroyWindow(window);
 		SDL_Quit();
 		return 1;
 	}
 
-	SDL_Texture *texture = SDL_CreateTexture(
-		renderer,
-		SDL_PIXELFORMAT_ARGB8888,
-		SDL_TEXTUREACCESS_STREAMING,
-		SCREEN_WIDTH, SCREEN_HEIGHT
-	);
+	// Created for the size of the first frame that arrives
+	Uint32 format = target->format;
+	SDL_Texture *texture = NULL;
+	int texture_width = 0;
+	int texture_height = 0;
 
-	if (!texture) {
-		printf("Texture error %s\n", SDL_GetError());
+	// From here on the render thread owns the renderer and the scene
+	PresentQueue queue = { 0 };
+	queue.renderer = renderer;
+	queue.scene = scene;
+	queue.free_slots = SDL_CreateSemaphore(PRESENT_SLOTS);
+	queue.ready_slots = SDL_CreateSemaphore(0);
+	queue.input_lock = SDL_CreateMutex();
+	SDL_Thread *render_thread = NULL;
+	if (queue.free_slots && queue.ready_slots && queue.input_lock) {
+		render_thread = SDL_CreateThread(render_thread_main, "render", &queue);
+	}
+	if (!render_thread) {
+		printf("Render thread error %s\n", SDL_GetError());
+		SDL_DestroyMutex(queue.input_lock);
+		SDL_DestroySemaphore(queue.ready_slots);
+		SDL_DestroySemaphore(queue.free_slots);
+		SDL_DestroyRenderer(sdl_renderer);
 		SDL_DestroyWindow(window);
 		SDL_Quit();
 		return 1;
@@ -59,132 +772,150 @@ int main() {
 	// Main Loop
 	int running = 1;
 	SDL_Event event;
-	Uint32 frame_start, frame_time;
-	float fps;
-	const Uint32 frame_delay = 16;  // Approx 60 FPS
-	
-	// Graphics variables
-	Vec3 eye = { 0.0f, 0.0f, 12.0f };
-	Vec3 center = { 0.0f, 0.0f, 0.0f };
-	Vec3 up = { 0.0f, 1.0f, 0.0f };
-	Camera cam = { eye, center, up };
-	
-	// Cube
-	Vec3 origin = { 0.0f, 0.0f, 0.0f };
-	float side_length = 5.0f;
-	Cube cube = create_cube(origin, side_length);
-	ColorRgb red = { 200, 0, 0, 255 };
-	ColorRgb green = { 0, 200, 0, 255 };
-	ColorRgb blue = { 0, 0, 200, 255 };
-	
-	// Tetrehedron
-	Tetrahedron th = create_tetrahedron(origin, side_length);
-	
-	// Line
-	
-	// Triangle
-	Triangle t = {
-		.vertices = {
-			(Vec3){ 2.5f, 0.0f, 0.0f }, (Vec3){ 0.0f, 4.33f, 0.0f }, (Vec3){ -2.5f, 0.0f, 0.0f }
-		},
-	};
-	
-	// Rotation Matrices
-	Matrix4 x_rotation_matrix = rotation_xaxis(X_ROTATION_THETA);
-	Matrix4 y_rotation_matrix = rotation_yaxis(Y_ROTATION_THETA);
-	Matrix4 z_rotation_matrix = rotation_zaxis(Z_ROTATION_THETA);
+	int index = 0;
+	Uint64 frame_period = SDL_GetPerformanceFrequency() / TARGET_FRAME_RATE;
+	Uint64 next_present = SDL_GetPerformanceCounter();
 
 	while (running) {
-		frame_start = SDL_GetTicks();
-
 		while (SDL_PollEvent(&event)) {
+			SDL_LockMutex(queue.input_lock);
 			if (event.type == SDL_QUIT) {
 				running = 0;
+			} else if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_SPACE) {
+				queue.toggle_pause = !queue.toggle_pause;
+			} else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+				// Render at the new window size from the next frame on
+				queue.resize_width = event.window.data1;
+				queue.resize_height = event.window.data2;
 			}
+			SDL_UnlockMutex(queue.input_lock);
+		}
+		if (!running) {
+			break;
 		}
 
-		// Lock the texture to get a pixel buffer
-		void *pixels;
-		// Pitch is the number of bytes per row of pixels
-		int pitch;
-		if (SDL_LockTexture(texture, NULL, &pixels, &pitch) != 0) {
-			printf("Lock error %s\n", SDL_GetError());
+		// Waits briefly, so events are still handled when rendering falls behind
+		if (SDL_SemWaitTimeout(queue.ready_slots, EVENT_POLL_MS) != 0) {
 			continue;
 		}
+		PresentSlot *slot = &queue.slots[index];
+		index = (index + 1) % PRESENT_SLOTS;
+		Uint64 present_start = SDL_GetPerformanceCounter();
 
-		// Convert pixel array to an array of Uint32
-		Uint32 *buf = (Uint32*)pixels;
-		for (int y = 0; y < SCREEN_HEIGHT; y++) {
-			for (int x = 0; x < SCREEN_WIDTH; x++) {
-				Uint8 r = 0;
-				Uint8 g = 0;
-				Uint8 b = 0;
-				Uint8 a = 255;
-				// Pixel at coordinates (x, y)
-				// (0, 0) at top left and (639, 479) at bottom right
-				buf[y * (pitch / 4) + x] = (a << 24) | (r << 16) | (g << 8) | b;
-			}
-		}
-		// Draw Objects
-		// POTENTIAL FIX: Clipping...
-		// Cube
-		bool cube_draw_result = draw_cube(buf, &cam, cube, green, pitch);
-		if (!cube_draw_result) {
-			printf("Error drawing cube\n");
-		}
-		// Tetrahedron
-		bool th_draw_result = draw_tetrahedron(buf, &cam, th, red, pitch);
-		if (!th_draw_result) {
-			printf("Error drawing tetrahedron\n");
-		}
-		// Draw axis of rotation line
-		bool line_draw_result = draw_line(buf, &cam, cube.vertices[0], cube.vertices[6], blue, pitch);
-		if (!line_draw_result) {
-			printf("Error drawing line\n");
-		}
-		// Draw triangle
-		bool triangle_draw_result = draw_triangle(buf, &cam, t, green, pitch);
-		if (!triangle_draw_result) {
-			printf("Error drawing triangle\n");
+		// A resized frame is redrawn whole, so the new texture starts out complete
+		if (slot->width != texture_width || slot->height != texture_height) {
+			if (texture) {
+				SDL_DestroyTexture(texture);
+			}
+			texture = SDL_CreateTexture(sdl_renderer, format, SDL_TEXTUREACCESS_STREAMING, slot->width, slot->height);
+			texture_width = texture ? slot->width : 0;
+			texture_height = texture ? slot->height : 0;
+			if (!texture) {
+				printf("Texture error %s\n", SDL_GetError());
+			}
 		}
-		
-		// Update Objects
-		// Rotate Cube Vertices along x-axis
-		for (int i = 0; i < 8; i++) {
-			Vec4 current_vertix = vec3_homogenous(cube.vertices[i], 1.0f);
-			current_vertix = mat4_vec4_mul(x_rotation_matrix, current_vertix);
-			cube.vertices[i] = (Vec3){ current_vertix.x, current_vertix.y, current_vertix.z };
-		}
-		// Rotate Cube Vertices along y-axis
-		for (int i = 0; i < 8; i++) {
-			Vec4 current_vertix = vec3_homogenous(cube.vertices[i], 1.0f);
-			current_vertix = mat4_vec4_mul(y_rotation_matrix, current_vertix);
-			cube.vertices[i] = (Vec3){ current_vertix.x, current_vertix.y, current_vertix.z };
-		}
-		// Rotate Cube Vertices along z-axis
-		for (int i = 0; i < 8; i++) {
-			Vec4 current_vertix = vec3_homogenous(cube.vertices[i], 1.0f);
-			current_vertix = mat4_vec4_mul(z_rotation_matrix, current_vertix);
-			cube.vertices[i] = (Vec3){ current_vertix.x, current_vertix.y, current_vertix.z };
+
+		// Only the redrawn rectangles are uploaded, an idle frame uploads nothing
+		for (int i = 0; i < slot->dirty.count && texture; i++) {
+			ScreenRect rect = slot->dirty.rects[i];
+			SDL_Rect texture_rect = { rect.min_x, rect.min_y, rect.max_x - rect.min_x, rect.max_y - rect.min_y };
+			const Uint32 *pixels = slot->pixels + rect.min_y * (slot->pitch / 4) + rect.min_x;
+			if (SDL_UpdateTexture(texture, &texture_rect, pixels, slot->pitch) != 0) {
+				printf("Texture update error %s\n", SDL_GetError());
+			}
 		}
-		
-		SDL_UnlockTexture(texture);
-		
-		frame_time = SDL_GetTicks() - frame_start;
-		fps = frame_time > 0 ? 1000.0f / frame_time : 0.0f;
+		// The render thread can start on the frame after next while this one is presented
+		SDL_SemPost(queue.free_slots);
+
+		SDL_RenderClear(sdl_renderer);
+		if (texture) {
+			SDL_RenderCopy(sdl_renderer, texture, NULL, NULL);
+		}
+		SDL_RenderPresent(sdl_renderer);
+		SDL_LockMutex(queue.input_lock);
+		queue.present_ticks = SDL_GetPerformanceCounter() - present_start;
+		SDL_UnlockMutex(queue.input_lock);
 
-		if (frame_time < frame_delay) {
-			SDL_Delay(frame_delay - frame_time);
+		// Paced after presenting, against a fixed schedule so errors do not add up;
+		// after a stall the schedule restarts instead of rushing to catch up
+		next_present += frame_period;
+		Uint64 now = SDL_GetPerformanceCounter();
+		if (next_present + frame_period < now) {
+			next_present = now;
 		}
+		wait_until(next_present);
+	}
 
-		SDL_RenderClear(renderer);
-		SDL_RenderCopy(renderer, texture, NULL, NULL);
-		SDL_RenderPresent(renderer);
-	}    
+	// Wakes the render thread if it is waiting for a slot
+	SDL_AtomicSet(&queue.quit, 1);
+	SDL_SemPost(queue.free_slots);
+	SDL_WaitThread(render_thread, NULL);
+	for (int i = 0; i < PRESENT_SLOTS; i++) {
+		free(queue.slots[i].pixels);
+	}
+	SDL_DestroyMutex(queue.input_lock);
+	SDL_DestroySemaphore(queue.ready_slots);
+	SDL_DestroySemaphore(queue.free_slots);
 
-	SDL_DestroyTexture(texture);
-	SDL_DestroyRenderer(renderer);
+	if (texture) {
+		SDL_DestroyTexture(texture);
+	}
+	SDL_DestroyRenderer(sdl_renderer);
 	SDL_DestroyWindow(window);
 	SDL_Quit();
 	return 0;
+}
+
+// ### MAIN FUNCTION ###
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parse_options(argc, argv, &options)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	// The model is loaded first, the frame arena is sized to draw it
+	Scene scene;
+	init_scene(&scene, options.still, options.filled, options.full_detail);
+	if (options.model_path && !load_scene_model(&scene, options.model_path)) {
+		printf("Error loading %s\n", options.model_path);
+		return 1;
+	}
+	size_t arena_size = frame_arena_size(scene.model);
+	size_t bin_arena_size = BIN_ARENA_SIZE;
+	if (options.arena_megabytes) {
+		size_t requested_size = (size_t)options.arena_megabytes * 1024 * 1024;
+		arena_size = requested_size > arena_size ? requested_size : arena_size;
+		bin_arena_size = requested_size > bin_arena_size ? requested_size : bin_arena_size;
+	}
+	Renderer renderer;
+	if (!create_renderer(&renderer, options.width, options.height, !options.full_redraw, arena_size, bin_arena_size)) {
+		release_scene_model(&scene);
+		return 1;
+	}
+
+	// Stages are only timed when something shows them
+	renderer.overlay = options.overlay;
+	if (options.stats_path) {
+		renderer.stats_file = fopen(options.stats_path, "w");
+		if (!renderer.stats_file) {
+			printf("Error opening %s\n", options.stats_path);
+			release_scene_model(&scene);
+			destroy_renderer(&renderer);
+			return 1;
+		}
+		stats_write_csv_header(renderer.stats_file);
+	}
+	if (options.overlay || options.stats_path) {
+		renderer.ctx.stats = &renderer.stats;
+	}
+
+	int result = options.headless ? run_headless(&renderer, &scene, &options) : run_window(&renderer, &scene);
+	if (renderer.stats_file && fclose(renderer.stats_file) != 0) {
+		printf("Error writing %s\n", options.stats_path);
+		result = 1;
+	}
+	release_scene_model(&scene);
+	destroy_renderer(&renderer);
+	return result;
 }
\ No newline at end of file
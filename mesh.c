@@ -0,0 +1,713 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "mesh.h"
+
+// ### CONSTANT DEFINITIONS ### //
+// Weight of the planes that hold boundary edges in place, relative to the faces
+#define BOUNDARY_WEIGHT 100.0
+// Levels below this many triangles are not built
+#define LOD_MIN_TRIANGLES 8
+
+// ### STRUCTS ### //
+typedef struct {
+	int index;
+	float angle;
+} FaceVertex;
+
+// Symmetric 4 x 4 matrix of a sum of squared plane distances, upper triangle
+// row by row: aa ab ac ad bb bc bd cc cd dd
+typedef struct {
+	double q[10];
+} Quadric;
+
+typedef struct {
+	double cost;
+	Vec3 position;
+	int a;
+	int b;
+} EdgeCollapse;
+
+// Working state of one simplification, triangles[t][0] is -1 once t collapsed
+typedef struct {
+	Vec3 *positions;
+	Quadric *quadrics;
+	int (*triangles)[3];
+	// Triangles around each vertex, rebuilt every pass
+	int *adjacency_start;
+	int *adjacency;
+	// Vertex marks for the pinch test, and of the pass each vertex last moved in
+	int *marks;
+	int mark;
+	int *moved;
+} Simplifier;
+
+// ### FUNCTION DEFINITIONS ### //
+
+// # CREATE AND DESTROY FUNCTIONS # //
+Mesh *create_mesh(int vertex_count, int triangle_count, int edge_count) {
+	if (vertex_count < 0 || triangle_count < 0 || edge_count < 0) {
+		return NULL;
+	}
+	
+	// Index buffers first, they have the strictest alignment
+	size_t size = sizeof(Mesh) + triangle_count * sizeof(int[3]) + edge_count * sizeof(int[2]) + 3 * vertex_count * sizeof(float);
+	Mesh *mesh = calloc(1, size);
+	if (!mesh) {
+		return NULL;
+	}
+	
+	unsigned char *memory = (unsigned char*)(mesh + 1);
+	mesh->triangles = (int (*)[3])memory;
+	memory += triangle_count * sizeof(int[3]);
+	mesh->edges = (int (*)[2])memory;
+	memory += edge_count * sizeof(int[2]);
+	mesh->x = (float*)memory;
+	mesh->y = mesh->x + vertex_count;
+	mesh->z = mesh->y + vertex_count;
+	
+	mesh->vertex_count = vertex_count;
+	mesh->triangle_count = triangle_count;
+	mesh->edge_count = edge_count;
+	mesh->edge_capacity = edge_count;
+	mesh->bounds_radius = -1.0f;
+	return mesh;
+}
+
+void destroy_mesh(Mesh **mesh) {
+	if (!mesh) {
+		return;
+	}
+	
+	free(*mesh);
+	*mesh = NULL;
+}
+
+Mesh *copy_mesh(const Mesh *mesh) {
+	if (!mesh) {
+		return NULL;
+	}
+	
+	Mesh *copy = create_mesh(mesh->vertex_count, mesh->triangle_count, mesh->edge_count);
+	if (!copy) {
+		return NULL;
+	}
+	memcpy(copy->x, mesh->x, mesh->vertex_count * sizeof(float));
+	memcpy(copy->y, mesh->y, mesh->vertex_count * sizeof(float));
+	memcpy(copy->z, mesh->z, mesh->vertex_count * sizeof(float));
+	memcpy(copy->triangles, mesh->triangles, mesh->triangle_count * sizeof(int[3]));
+	memcpy(copy->edges, mesh->edges, mesh->edge_count * sizeof(int[2]));
+	copy->bounds_center = mesh->bounds_center;
+	copy->bounds_radius = mesh->bounds_radius;
+	return copy;
+}
+
+static int compare_face_vertices(const void *a, const void *b) {
+	float angle_a = ((const FaceVertex*)a)->angle;
+	float angle_b = ((const FaceVertex*)b)->angle;
+	return (angle_a > angle_b) - (angle_a < angle_b);
+}
+
+// Only meant for the small solids built at startup, every vertex triple is tried as a face plane
+Mesh *create_convex_mesh(const Vec3 *points, int count) {
+	if ((!points) || count < 4) {
+		return NULL;
+	}
+	
+	// Euler's formula bounds a convex polyhedron's triangles and edges
+	Mesh *mesh = create_mesh(count, 2 * count - 4, 3 * count - 6);
+	FaceVertex *face = malloc(count * sizeof(FaceVertex));
+	if ((!mesh) || (!face)) {
+		destroy_mesh(&mesh);
+		free(face);
+		return NULL;
+	}
+	
+	float scale = 0.0f;
+	for (int i = 0; i < count; i++) {
+		mesh->x[i] = points[i].x;
+		mesh->y[i] = points[i].y;
+		mesh->z[i] = points[i].z;
+		scale = fmaxf(scale, fmaxf(fabsf(points[i].x), fmaxf(fabsf(points[i].y), fabsf(points[i].z))));
+	}
+	float epsilon = 1e-4f * (scale > 0.0f ? scale : 1.0f);
+	
+	int triangle_count = 0;
+	int edge_count = 0;
+	for (int i = 0; i < count; i++) {
+		for (int j = i + 1; j < count; j++) {
+			for (int k = j + 1; k < count; k++) {
+				Vec3 normal = vec3_cross_product(vec3_sub(points[j], points[i]), vec3_sub(points[k], points[i]));
+				if (vec3_length(normal) < epsilon * epsilon) {
+					continue;
+				}
+				normal = vec3_normalize(normal);
+				float offset = vec3_dot_product(normal, points[i]);
+				
+				// A face plane has every point on the same side
+				float min_distance = 0.0f;
+				float max_distance = 0.0f;
+				for (int m = 0; m < count; m++) {
+					float distance = vec3_dot_product(normal, points[m]) - offset;
+					min_distance = fminf(min_distance, distance);
+					max_distance = fmaxf(max_distance, distance);
+				}
+				if (min_distance < -epsilon && max_distance > epsilon) {
+					continue;
+				}
+				// Outward normal
+				if (max_distance > epsilon) {
+					normal = vec3_scale(normal, -1.0f);
+					offset = -offset;
+				}
+				
+				// Each face is built once, from its three lowest vertex indices
+				int face_count = 0;
+				Vec3 centroid = { 0.0f, 0.0f, 0.0f };
+				bool lowest = true;
+				for (int m = 0; m < count; m++) {
+					if (fabsf(vec3_dot_product(normal, points[m]) - offset) <= epsilon) {
+						if (m < k && m != i && m != j) {
+							lowest = false;
+						}
+						face[face_count++].index = m;
+						centroid = vec3_add(centroid, points[m]);
+					}
+				}
+				if (!lowest) {
+					continue;
+				}
+				centroid = vec3_scale(centroid, 1.0f / face_count);
+				
+				// Counter-clockwise order around the outward normal
+				Vec3 u = vec3_normalize(vec3_sub(points[face[0].index], centroid));
+				Vec3 w = vec3_cross_product(normal, u);
+				for (int m = 0; m < face_count; m++) {
+					Vec3 p = vec3_sub(points[face[m].index], centroid);
+					face[m].angle = atan2f(vec3_dot_product(p, w), vec3_dot_product(p, u));
+				}
+				qsort(face, face_count, sizeof(FaceVertex), compare_face_vertices);
+				
+				for (int m = 1; m + 1 < face_count && triangle_count < mesh->triangle_count; m++) {
+					mesh->triangles[triangle_count][0] = face[0].index;
+					mesh->triangles[triangle_count][1] = face[m].index;
+					mesh->triangles[triangle_count][2] = face[m + 1].index;
+					triangle_count++;
+				}
+				// Every outline edge is shared by two faces, keep it from the face where it runs upwards in index
+				for (int m = 0; m < face_count && edge_count < mesh->edge_count; m++) {
+					int from = face[m].index;
+					int to = face[(m + 1) % face_count].index;
+					if (from < to) {
+						mesh->edges[edge_count][0] = from;
+						mesh->edges[edge_count][1] = to;
+						edge_count++;
+					}
+				}
+			}
+		}
+	}
+	
+	free(face);
+	mesh->triangle_count = triangle_count;
+	mesh->edge_count = edge_count;
+	mesh_update_bounds(mesh);
+	return mesh;
+}
+
+// # MESH UTILS FUNCTIONS # //
+Vec3 mesh_vertex(const Mesh *mesh, int index) {
+	return (Vec3){ mesh->x[index], mesh->y[index], mesh->z[index] };
+}
+
+void mesh_update_bounds(Mesh *mesh) {
+	if ((!mesh) || mesh->vertex_count == 0) {
+		return;
+	}
+	
+	// Centered on the centroid, so not minimal, but cheap to refit
+	Vec3 center = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < mesh->vertex_count; i++) {
+		center = vec3_add(center, mesh_vertex(mesh, i));
+	}
+	center = vec3_scale(center, 1.0f / mesh->vertex_count);
+	
+	float radius_squared = 0.0f;
+	for (int i = 0; i < mesh->vertex_count; i++) {
+		float distance_squared = vec3_distance_squared(center, mesh_vertex(mesh, i));
+		radius_squared = distance_squared > radius_squared ? distance_squared : radius_squared;
+	}
+	mesh->bounds_center = center;
+	mesh->bounds_radius = sqrtf(radius_squared);
+}
+
+bool mesh_build_edges(Mesh *mesh) {
+	if (!mesh) {
+		return false;
+	}
+	
+	// Bucket every triangle side by its lower vertex, a counting sort in
+	// O(vertices + triangles) with one temporary allocation
+	int vertex_count = mesh->vertex_count;
+	int *memory = malloc((2 * (size_t)vertex_count + 1 + 3 * (size_t)mesh->triangle_count) * sizeof(int));
+	if (!memory) {
+		return false;
+	}
+	int *bucket_start = memory;
+	int *cursor = bucket_start + vertex_count + 1;
+	int *upper = cursor + vertex_count;
+	
+	for (int i = 0; i <= vertex_count; i++) {
+		bucket_start[i] = 0;
+	}
+	for (int i = 0; i < mesh->triangle_count; i++) {
+		for (int j = 0; j < 3; j++) {
+			int a = mesh->triangles[i][j];
+			int b = mesh->triangles[i][(j + 1) % 3];
+			if (a != b) {
+				bucket_start[(a < b ? a : b) + 1]++;
+			}
+		}
+	}
+	for (int i = 0; i < vertex_count; i++) {
+		bucket_start[i + 1] += bucket_start[i];
+		cursor[i] = bucket_start[i];
+	}
+	for (int i = 0; i < mesh->triangle_count; i++) {
+		for (int j = 0; j < 3; j++) {
+			int a = mesh->triangles[i][j];
+			int b = mesh->triangles[i][(j + 1) % 3];
+			if (a != b) {
+				upper[cursor[a < b ? a : b]++] = a < b ? b : a;
+			}
+		}
+	}
+	
+	// Compact each bucket in place, the cursors now mark the upper vertices
+	// already taken by the current lower vertex
+	int *last_seen = cursor;
+	for (int i = 0; i < vertex_count; i++) {
+		last_seen[i] = -1;
+	}
+	int edge_count = 0;
+	int bucket_begin = 0;
+	for (int lower = 0; lower < vertex_count; lower++) {
+		int bucket_end = bucket_start[lower + 1];
+		bucket_start[lower] = edge_count;
+		for (int i = bucket_begin; i < bucket_end; i++) {
+			if (last_seen[upper[i]] != lower) {
+				last_seen[upper[i]] = lower;
+				upper[edge_count++] = upper[i];
+			}
+		}
+		bucket_begin = bucket_end;
+	}
+	bucket_start[vertex_count] = edge_count;
+	
+	if (edge_count > mesh->edge_capacity) {
+		free(memory);
+		return false;
+	}
+	for (int lower = 0; lower < vertex_count; lower++) {
+		for (int i = bucket_start[lower]; i < bucket_start[lower + 1]; i++) {
+			mesh->edges[i][0] = lower;
+			mesh->edges[i][1] = upper[i];
+		}
+	}
+	mesh->edge_count = edge_count;
+	
+	free(memory);
+	return true;
+}
+
+
+// # SIMPLIFICATION # //
+static void quadric_add_plane(Quadric *quadric, Vec3 normal, double d, double weight) {
+	double a = normal.x;
+	double b = normal.y;
+	double c = normal.z;
+	double plane[10] = { a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d };
+	for (int i = 0; i < 10; i++) {
+		quadric->q[i] += weight * plane[i];
+	}
+}
+
+static double quadric_error(const Quadric *quadric, Vec3 p) {
+	const double *q = quadric->q;
+	double x = p.x;
+	double y = p.y;
+	double z = p.z;
+	return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x
+		+ q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+		+ q[7] * z * z + 2.0 * q[8] * z + q[9];
+}
+
+static int compare_collapse_edges(const void *a, const void *b) {
+	const EdgeCollapse *edge_a = a;
+	const EdgeCollapse *edge_b = b;
+	if (edge_a->a != edge_b->a) {
+		return edge_a->a - edge_b->a;
+	}
+	return edge_a->b - edge_b->b;
+}
+
+static int compare_collapse_costs(const void *a, const void *b) {
+	double cost_a = ((const EdgeCollapse*)a)->cost;
+	double cost_b = ((const EdgeCollapse*)b)->cost;
+	return (cost_a > cost_b) - (cost_a < cost_b);
+}
+
+static inline bool triangle_has(const int *triangle, int vertex) {
+	return triangle[0] == vertex || triangle[1] == vertex || triangle[2] == vertex;
+}
+
+static Vec3 triangle_normal(const Vec3 *positions, const int *triangle) {
+	Vec3 a = positions[triangle[0]];
+	return vec3_cross_product(vec3_sub(positions[triangle[1]], a), vec3_sub(positions[triangle[2]], a));
+}
+
+// The two vertices may only share the neighbors opposite the edge, or the
+// surface pinches into a non-manifold, and no triangle may turn over
+static bool collapse_allowed(Simplifier *simplifier, int a, int b, Vec3 position) {
+	int ends[2] = { a, b };
+	int shared_triangles = 0;
+	int shared_neighbors = 0;
+	simplifier->mark += 2;
+	for (int e = 0; e < 2; e++) {
+		int vertex = ends[e];
+		int other = ends[1 - e];
+		for (int i = simplifier->adjacency_start[vertex]; i < simplifier->adjacency_start[vertex + 1]; i++) {
+			int *triangle = simplifier->triangles[simplifier->adjacency[i]];
+			if (triangle[0] < 0) {
+				continue;
+			}
+			for (int j = 0; j < 3; j++) {
+				int neighbor = triangle[j];
+				if (neighbor == a || neighbor == b) {
+					continue;
+				}
+				if (e == 0) {
+					simplifier->marks[neighbor] = simplifier->mark;
+				} else if (simplifier->marks[neighbor] == simplifier->mark) {
+					simplifier->marks[neighbor] = simplifier->mark + 1;
+					shared_neighbors++;
+				}
+			}
+			// The triangles on the edge disappear, the others must keep facing the same way
+			if (triangle_has(triangle, other)) {
+				shared_triangles += e == 0;
+				continue;
+			}
+			Vec3 before = triangle_normal(simplifier->positions, triangle);
+			Vec3 saved = simplifier->positions[vertex];
+			simplifier->positions[vertex] = position;
+			Vec3 after = triangle_normal(simplifier->positions, triangle);
+			simplifier->positions[vertex] = saved;
+			if (vec3_dot_product(before, after) <= 0.0f) {
+				return false;
+			}
+		}
+	}
+	return shared_triangles > 0 && shared_neighbors == shared_triangles;
+}
+
+// Triangles around each vertex as one array, bucketed by vertex
+static void build_adjacency(Simplifier *simplifier, int vertex_count, int triangle_count) {
+	int *start = simplifier->adjacency_start;
+	for (int i = 0; i <= vertex_count; i++) {
+		start[i] = 0;
+	}
+	for (int t = 0; t < triangle_count; t++) {
+		if (simplifier->triangles[t][0] >= 0) {
+			for (int j = 0; j < 3; j++) {
+				start[simplifier->triangles[t][j] + 1]++;
+			}
+		}
+	}
+	for (int i = 0; i < vertex_count; i++) {
+		start[i + 1] += start[i];
+	}
+	// Filling advances each start to the next bucket's, shifting back restores them
+	for (int t = 0; t < triangle_count; t++) {
+		if (simplifier->triangles[t][0] >= 0) {
+			for (int j = 0; j < 3; j++) {
+				simplifier->adjacency[start[simplifier->triangles[t][j]]++] = t;
+			}
+		}
+	}
+	for (int i = vertex_count; i > 0; i--) {
+		start[i] = start[i - 1];
+	}
+	start[0] = 0;
+}
+
+// Sides of the remaining triangles as lower and upper vertex, sorted, once per triangle using them
+static int gather_edges(const Simplifier *simplifier, int triangle_count, EdgeCollapse *edges) {
+	int edge_count = 0;
+	for (int t = 0; t < triangle_count; t++) {
+		const int *triangle = simplifier->triangles[t];
+		if (triangle[0] < 0) {
+			continue;
+		}
+		for (int j = 0; j < 3; j++) {
+			int from = triangle[j];
+			int to = triangle[(j + 1) % 3];
+			edges[edge_count].a = from < to ? from : to;
+			edges[edge_count].b = from < to ? to : from;
+			edge_count++;
+		}
+	}
+	qsort(edges, edge_count, sizeof(EdgeCollapse), compare_collapse_edges);
+	return edge_count;
+}
+
+// Best of the two ends and the midpoint, which avoids solving for the optimum
+static void collapse_cost(const Simplifier *simplifier, EdgeCollapse *edge) {
+	Quadric quadric = simplifier->quadrics[edge->a];
+	for (int i = 0; i < 10; i++) {
+		quadric.q[i] += simplifier->quadrics[edge->b].q[i];
+	}
+	Vec3 from = simplifier->positions[edge->a];
+	Vec3 to = simplifier->positions[edge->b];
+	Vec3 candidates[3] = { from, to, vec3_scale(vec3_add(from, to), 0.5f) };
+	edge->cost = INFINITY;
+	for (int i = 0; i < 3; i++) {
+		double cost = quadric_error(&quadric, candidates[i]);
+		if (cost < edge->cost) {
+			edge->cost = cost;
+			edge->position = candidates[i];
+		}
+	}
+}
+
+Mesh *mesh_simplify(const Mesh *mesh, int target_triangles) {
+	if (!mesh) {
+		return NULL;
+	}
+	
+	// One allocation for the working state, the widest alignment first
+	int vertex_count = mesh->vertex_count;
+	int triangle_count = mesh->triangle_count;
+	size_t size = vertex_count * sizeof(Quadric) + 3 * (size_t)triangle_count * sizeof(EdgeCollapse) + vertex_count * sizeof(Vec3)
+		+ (6 * (size_t)triangle_count + 3 * (size_t)vertex_count + 1) * sizeof(int);
+	unsigned char *memory = malloc(size);
+	if (!memory) {
+		return NULL;
+	}
+	Simplifier simplifier;
+	simplifier.quadrics = (Quadric*)memory;
+	EdgeCollapse *edges = (EdgeCollapse*)(simplifier.quadrics + vertex_count);
+	simplifier.positions = (Vec3*)(edges + 3 * (size_t)triangle_count);
+	simplifier.triangles = (int (*)[3])(simplifier.positions + vertex_count);
+	simplifier.adjacency = (int*)(simplifier.triangles + triangle_count);
+	simplifier.adjacency_start = simplifier.adjacency + 3 * (size_t)triangle_count;
+	simplifier.marks = simplifier.adjacency_start + vertex_count + 1;
+	simplifier.moved = simplifier.marks + vertex_count;
+	simplifier.mark = 0;
+	
+	for (int i = 0; i < vertex_count; i++) {
+		simplifier.positions[i] = mesh_vertex(mesh, i);
+		simplifier.quadrics[i] = (Quadric){ { 0.0 } };
+		simplifier.marks[i] = 0;
+		simplifier.moved[i] = -1;
+	}
+	// Every face adds its plane to its corners, weighted by its area
+	int live_triangles = 0;
+	for (int t = 0; t < triangle_count; t++) {
+		int *triangle = simplifier.triangles[t];
+		for (int j = 0; j < 3; j++) {
+			triangle[j] = mesh->triangles[t][j];
+		}
+		if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0]) {
+			triangle[0] = -1;
+			continue;
+		}
+		live_triangles++;
+		Vec3 normal = triangle_normal(simplifier.positions, triangle);
+		float length = vec3_length(normal);
+		if (length > 0.0f) {
+			normal = vec3_scale(normal, 1.0f / length);
+			for (int j = 0; j < 3; j++) {
+				quadric_add_plane(&simplifier.quadrics[triangle[j]], normal, -vec3_dot_product(normal, simplifier.positions[triangle[0]]), 0.5 * length);
+			}
+		}
+	}
+	
+	// Sides of a single triangle are boundaries, held by a plane through them at right angles to the face
+	build_adjacency(&simplifier, vertex_count, triangle_count);
+	int edge_count = gather_edges(&simplifier, triangle_count, edges);
+	for (int i = 0; i < edge_count; i++) {
+		int a = edges[i].a;
+		int b = edges[i].b;
+		if ((i > 0 && edges[i - 1].a == a && edges[i - 1].b == b) || (i + 1 < edge_count && edges[i + 1].a == a && edges[i + 1].b == b)) {
+			continue;
+		}
+		for (int k = simplifier.adjacency_start[a]; k < simplifier.adjacency_start[a + 1]; k++) {
+			const int *triangle = simplifier.triangles[simplifier.adjacency[k]];
+			if (!triangle_has(triangle, b)) {
+				continue;
+			}
+			Vec3 side = vec3_sub(simplifier.positions[b], simplifier.positions[a]);
+			Vec3 normal = vec3_cross_product(side, triangle_normal(simplifier.positions, triangle));
+			float length = vec3_length(normal);
+			if (length > 0.0f) {
+				normal = vec3_scale(normal, 1.0f / length);
+				double weight = BOUNDARY_WEIGHT * vec3_dot_product(side, side);
+				double d = -vec3_dot_product(normal, simplifier.positions[a]);
+				quadric_add_plane(&simplifier.quadrics[a], normal, d, weight);
+				quadric_add_plane(&simplifier.quadrics[b], normal, d, weight);
+			}
+			break;
+		}
+	}
+	
+	// Each pass collapses the cheapest edges first, and no vertex more than once
+	for (int pass = 0; live_triangles > target_triangles; pass++) {
+		if (pass > 0) {
+			build_adjacency(&simplifier, vertex_count, triangle_count);
+			edge_count = gather_edges(&simplifier, triangle_count, edges);
+		}
+		int unique_count = 0;
+		for (int i = 0; i < edge_count; i++) {
+			if (unique_count > 0 && edges[unique_count - 1].a == edges[i].a && edges[unique_count - 1].b == edges[i].b) {
+				continue;
+			}
+			edges[unique_count] = edges[i];
+			collapse_cost(&simplifier, &edges[unique_count]);
+			unique_count++;
+		}
+		qsort(edges, unique_count, sizeof(EdgeCollapse), compare_collapse_costs);
+		
+		int collapsed = 0;
+		for (int i = 0; i < unique_count && live_triangles > target_triangles; i++) {
+			int a = edges[i].a;
+			int b = edges[i].b;
+			if (simplifier.moved[a] == pass || simplifier.moved[b] == pass || !collapse_allowed(&simplifier, a, b, edges[i].position)) {
+				continue;
+			}
+			
+			// b merges into a, the triangles on the edge disappear
+			simplifier.positions[a] = edges[i].position;
+			for (int j = 0; j < 10; j++) {
+				simplifier.quadrics[a].q[j] += simplifier.quadrics[b].q[j];
+			}
+			for (int k = simplifier.adjacency_start[b]; k < simplifier.adjacency_start[b + 1]; k++) {
+				int *triangle = simplifier.triangles[simplifier.adjacency[k]];
+				if (triangle[0] < 0) {
+					continue;
+				}
+				if (triangle_has(triangle, a)) {
+					triangle[0] = -1;
+					live_triangles--;
+					continue;
+				}
+				for (int j = 0; j < 3; j++) {
+					triangle[j] = triangle[j] == b ? a : triangle[j];
+				}
+			}
+			simplifier.moved[a] = pass;
+			simplifier.moved[b] = pass;
+			collapsed++;
+		}
+		if (collapsed == 0) {
+			break;
+		}
+	}
+	
+	// Only the vertices still in use are kept, in the order the triangles first use them
+	int *remap = simplifier.marks;
+	for (int i = 0; i < vertex_count; i++) {
+		remap[i] = -1;
+	}
+	int used_vertices = 0;
+	for (int t = 0; t < triangle_count; t++) {
+		if (simplifier.triangles[t][0] >= 0) {
+			for (int j = 0; j < 3; j++) {
+				int vertex = simplifier.triangles[t][j];
+				remap[vertex] = remap[vertex] < 0 ? used_vertices++ : remap[vertex];
+			}
+		}
+	}
+	
+	Mesh *result = create_mesh(used_vertices, live_triangles, 3 * live_triangles);
+	if (!result) {
+		free(memory);
+		return NULL;
+	}
+	for (int i = 0; i < vertex_count; i++) {
+		if (remap[i] >= 0) {
+			result->x[remap[i]] = simplifier.positions[i].x;
+			result->y[remap[i]] = simplifier.positions[i].y;
+			result->z[remap[i]] = simplifier.positions[i].z;
+		}
+	}
+	int next = 0;
+	for (int t = 0; t < triangle_count; t++) {
+		if (simplifier.triangles[t][0] >= 0) {
+			for (int j = 0; j < 3; j++) {
+				result->triangles[next][j] = remap[simplifier.triangles[t][j]];
+			}
+			next++;
+		}
+	}
+	free(memory);
+	
+	// Three edges per triangle always fit
+	mesh_build_edges(result);
+	mesh_update_bounds(result);
+	return result;
+}
+
+MeshLod *create_mesh_lod(const Mesh *mesh, int level_count) {
+	if ((!mesh) || level_count < 1) {
+		return NULL;
+	}
+	level_count = level_count < MESH_LOD_MAX_LEVELS ? level_count : MESH_LOD_MAX_LEVELS;
+	
+	MeshLod *lod = calloc(1, sizeof(MeshLod));
+	if (!lod) {
+		return NULL;
+	}
+	lod->levels[0] = copy_mesh(mesh);
+	if (!lod->levels[0]) {
+		destroy_mesh_lod(&lod);
+		return NULL;
+	}
+	lod->level_count = 1;
+	if (lod->levels[0]->bounds_radius < 0.0f) {
+		mesh_update_bounds(lod->levels[0]);
+	}
+	
+	while (lod->level_count < level_count) {
+		const Mesh *previous = lod->levels[lod->level_count - 1];
+		int target = previous->triangle_count / 2;
+		if (target < LOD_MIN_TRIANGLES) {
+			break;
+		}
+		Mesh *level = mesh_simplify(previous, target);
+		if (!level) {
+			destroy_mesh_lod(&lod);
+			return NULL;
+		}
+		// Less than a quarter fewer triangles, the collapses ran out
+		if (4 * level->triangle_count > 3 * previous->triangle_count) {
+			destroy_mesh(&level);
+			break;
+		}
+		lod->levels[lod->level_count++] = level;
+	}
+	return lod;
+}
+
+void destroy_mesh_lod(MeshLod **lod) {
+	if ((!lod) || (!(*lod))) {
+		return;
+	}
+	
+	for (int i = 0; i < (*lod)->level_count; i++) {
+		destroy_mesh(&(*lod)->levels[i]);
+	}
+	free(*lod);
+	*lod = NULL;
+}
@@ -0,0 +1,70 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdbool.h>
+#include "linalg.h"
+
+// ### CONSTANTS ### //
+#define MESH_LOD_MAX_LEVELS 8
+
+// ### STRUCTS ### //
+// Indexed mesh: vertex positions are stored once, as a structure of arrays,
+// and triangles and edges refer to them by index
+typedef struct {
+	float *x;
+	float *y;
+	float *z;
+	int vertex_count;
+	// Counter-clockwise when seen from outside the mesh
+	int (*triangles)[3];
+	int triangle_count;
+	int (*edges)[2];
+	int edge_count;
+	int edge_capacity;
+	// Bounding sphere for culling, a negative radius means not computed yet
+	Vec3 bounds_center;
+	float bounds_radius;
+} Mesh;
+
+// Detail levels of one mesh, finest first, each with about half the triangles
+// of the one before. Every level is owned by the MeshLod
+typedef struct {
+	Mesh *levels[MESH_LOD_MAX_LEVELS];
+	int level_count;
+} MeshLod;
+
+// ### FUNCTION DECLARATIONS ### //
+// # CREATE AND DESTROY FUNCTIONS # //
+// Positions and index buffers share a single allocation
+Mesh *create_mesh(int vertex_count, int triangle_count, int edge_count);
+void destroy_mesh(Mesh **mesh);
+
+Mesh *copy_mesh(const Mesh *mesh);
+
+// Builds the faces of the convex hull of points, which must all be hull vertices
+// Faces are triangulated, edges are the outlines of the faces
+Mesh *create_convex_mesh(const Vec3 *points, int count);
+
+// # MESH UTILS FUNCTIONS # //
+Vec3 mesh_vertex(const Mesh *mesh, int index);
+// Recomputes the bounding sphere, call after writing the positions
+void mesh_update_bounds(Mesh *mesh);
+// Replaces the edges with the unique edges of the triangles, sorted by their
+// lower vertex, so a wireframe draws each shared edge once. Call after writing
+// the triangles, draws reuse the list. A closed mesh has 3 / 2 edges per
+// triangle, an open one up to 3. Returns false if they do not fit the edge capacity
+bool mesh_build_edges(Mesh *mesh);
+
+// # SIMPLIFICATION # //
+// Collapses the edges of least quadric error until at most target_triangles are
+// left, or no edge can be collapsed without folding a triangle over or pinching
+// the surface. Boundaries of open meshes are kept in place. The result has the
+// unique edges of its triangles and its bounds computed. Meant for load time,
+// not for every frame
+Mesh *mesh_simplify(const Mesh *mesh, int target_triangles);
+// A copy of the mesh, then up to level_count - 1 simplifications, each from the
+// level before. Stops early once simplifying stops removing triangles
+MeshLod *create_mesh_lod(const Mesh *mesh, int level_count);
+void destroy_mesh_lod(MeshLod **lod);
+
+#endif
@@ -0,0 +1,291 @@
+#include "graphics.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define RASTER_SIMD_X86 1
+#endif
+
+// ### CONSTANT DEFINITIONS ### //
+// Pixels are tested in square blocks of this size; blocks wholly inside or outside
+// the triangle are decided from the edge values at their corners alone
+#define SIMD_BLOCK 8
+// Largest edge step for which the values of an edge crossing a block, and the
+// steps across it, fit 32-bit lanes
+#define SIMD_MAX_EDGE_STEP (1 << 23)
+// Narrower rectangles have all their blocks decided from corners, which is cheaper
+// than the divisions that bound the covered columns of each band
+#define SIMD_BOUNDED_WIDTH (4 * SIMD_BLOCK)
+
+// ### STRUCTS AND ENUMS ### //
+typedef enum {
+	BLOCK_EMPTY,
+	BLOCK_FULL,
+	BLOCK_PARTIAL,
+} BlockCoverage;
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## INLINE FUNCTIONS ## //
+// w holds the edge values at the block's first pixel. Each edge is linear, so its
+// lowest and highest values over the block are at corners. crossing gets the edges
+// that change sign inside the block, the only ones its pixels have to be tested against
+static inline BlockCoverage classify_block(const TriangleSetup *setup, const Sint64 *w, int width, int height, int *crossing) {
+	*crossing = 0;
+	for (int i = 0; i < 3; i++) {
+		Sint64 dx = setup->edge_a[i] * (width - 1);
+		Sint64 dy = setup->edge_b[i] * (height - 1);
+		Sint64 lowest = w[i] + (dx < 0 ? dx : 0) + (dy < 0 ? dy : 0);
+		Sint64 highest = w[i] + (dx > 0 ? dx : 0) + (dy > 0 ? dy : 0);
+		if (highest < 0) {
+			return BLOCK_EMPTY;
+		}
+		if (lowest < 0) {
+			*crossing |= 1 << i;
+		}
+	}
+	return *crossing ? BLOCK_PARTIAL : BLOCK_FULL;
+}
+
+// Floor and ceiling of n / d, for d > 0
+static inline Sint64 floor_div(Sint64 n, Sint64 d) {
+	Sint64 q = n / d;
+	return (n % d != 0 && n < 0) ? q - 1 : q;
+}
+
+static inline Sint64 ceil_div(Sint64 n, Sint64 d) {
+	return -floor_div(-n, d);
+}
+
+// Columns, relative to the band's first, where every edge is at least -offset[i];
+// first > last when there are none
+static inline void band_columns(const TriangleSetup *setup, const Sint64 *w, const Sint64 *offset, Sint64 width, Sint64 *first, Sint64 *last) {
+	*first = 0;
+	*last = width - 1;
+	for (int i = 0; i < 3; i++) {
+		Sint64 a = setup->edge_a[i];
+		Sint64 value = w[i] + offset[i];
+		if (a > 0) {
+			Sint64 x = ceil_div(-value, a);
+			*first = x > *first ? x : *first;
+		} else if (a < 0) {
+			Sint64 x = floor_div(value, -a);
+			*last = x < *last ? x : *last;
+		} else if (value < 0) {
+			*last = *first - 1;
+		}
+	}
+}
+
+// ## COVERAGE KERNELS ## //
+bool simd_kernel_fits(const TriangleSetup *setup) {
+	for (int i = 0; i < 3; i++) {
+		if (setup->edge_a[i] > SIMD_MAX_EDGE_STEP || setup->edge_a[i] < -SIMD_MAX_EDGE_STEP
+			|| setup->edge_b[i] > SIMD_MAX_EDGE_STEP || setup->edge_b[i] < -SIMD_MAX_EDGE_STEP) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#ifdef RASTER_SIMD_X86
+// Covers the partial pixels of a block, given the edges crossing it
+typedef int (*PartialBlock)(Uint32 *block, int row_length, const TriangleSetup *setup, const Sint64 *w, int crossing, int width, int height, Uint32 color);
+
+// Per band of SIMD_BLOCK rows, one division per edge finds the columns where some
+// pixel may be covered and those where all are. The inner ones are filled as spans,
+// the blocks between the two are decided from their corners, then tested by lane.
+// Inlined into each kernel, so partial_block is a direct call
+static inline __attribute__((always_inline)) int rasterize_blocks(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y, PartialBlock partial_block) {
+	const Sint64 *a = setup->edge_a;
+	const Sint64 *b = setup->edge_b;
+	int row_length = pitch / 4;
+	int written = 0;
+	
+	Sint64 band_w[3];
+	for (int i = 0; i < 3; i++) {
+		band_w[i] = a[i] * min_x + b[i] * min_y + setup->edge_c[i];
+	}
+	for (int band_y = min_y; band_y < max_y; band_y += SIMD_BLOCK) {
+		int height = max_y - band_y < SIMD_BLOCK ? max_y - band_y : SIMD_BLOCK;
+		Uint32 *band = buffer + band_y * row_length;
+		// Highest and lowest value each edge adds over the band's rows
+		Sint64 highest[3];
+		Sint64 lowest[3];
+		for (int i = 0; i < 3; i++) {
+			Sint64 dy = b[i] * (height - 1);
+			highest[i] = dy > 0 ? dy : 0;
+			lowest[i] = dy < 0 ? dy : 0;
+		}
+		Sint64 outer_first = 0;
+		Sint64 outer_last = max_x - min_x - 1;
+		Sint64 inner_first = 1;
+		Sint64 inner_last = 0;
+		if (max_x - min_x > SIMD_BOUNDED_WIDTH) {
+			band_columns(setup, band_w, highest, max_x - min_x, &outer_first, &outer_last);
+			band_columns(setup, band_w, lowest, max_x - min_x, &inner_first, &inner_last);
+		}
+		if (inner_first > inner_last) {
+			inner_first = outer_last + 1;
+			inner_last = outer_last;
+		}
+		
+		// Left of the inner columns, then right of them
+		Sint64 ranges[2][2] = { { outer_first, inner_first }, { inner_last + 1, outer_last + 1 } };
+		for (int r = 0; r < 2 && outer_first <= outer_last; r++) {
+			for (Sint64 x = ranges[r][0]; x < ranges[r][1]; x += SIMD_BLOCK) {
+				int width = ranges[r][1] - x < SIMD_BLOCK ? (int)(ranges[r][1] - x) : SIMD_BLOCK;
+				Sint64 w[3];
+				for (int i = 0; i < 3; i++) {
+					w[i] = band_w[i] + a[i] * x;
+				}
+				// Without crossing edges every lane is inside, so full blocks are plain stores
+				int crossing;
+				if (classify_block(setup, w, width, height, &crossing) != BLOCK_EMPTY) {
+					written += partial_block(band + min_x + x, row_length, setup, w, crossing, width, height, color);
+				}
+			}
+		}
+		if (inner_first <= inner_last) {
+			for (int y = 0; y < height; y++) {
+				fill_span(band + y * row_length, min_x + (int)inner_first, min_x + (int)inner_last + 1, color);
+			}
+			written += (int)(inner_last - inner_first + 1) * height;
+		}
+		
+		for (int i = 0; i < 3; i++) {
+			band_w[i] += b[i] * SIMD_BLOCK;
+		}
+	}
+	return written;
+}
+
+// Writes the lanes whose edge values are all non-negative, returns how many
+__attribute__((target("sse2")))
+static inline int store_lanes_sse2(Uint32 *pixels, __m128i edge_bits, __m128i fill) {
+	// All ones in the lanes with a negative edge value
+	__m128i outside = _mm_srai_epi32(edge_bits, 31);
+	int outside_bits = _mm_movemask_ps(_mm_castsi128_ps(outside));
+	if (outside_bits == 0) {
+		_mm_storeu_si128((__m128i*)pixels, fill);
+	} else if (outside_bits != 0xF) {
+		__m128i dst = _mm_loadu_si128((__m128i*)pixels);
+		_mm_storeu_si128((__m128i*)pixels, _mm_or_si128(_mm_andnot_si128(outside, fill), _mm_and_si128(outside, dst)));
+	}
+	return 4 - __builtin_popcount(outside_bits);
+}
+
+// Tests the pixels of a block one row of 4 + 4 lanes at a time. Pixels past the
+// block's width are never written, they may belong to another thread's tile
+__attribute__((target("sse2")))
+static int partial_block_sse2(Uint32 *block, int row_length, const TriangleSetup *setup, const Sint64 *w, int crossing, int width, int height, Uint32 color) {
+	// Edges not crossing the block stay at 0, which counts as inside
+	__m128i low_w[3];
+	__m128i high_w[3];
+	__m128i row_step[3];
+	for (int i = 0; i < 3; i++) {
+		bool tested = crossing & (1 << i);
+		Sint32 edge_w = tested ? (Sint32)w[i] : 0;
+		Sint32 step = tested ? (Sint32)setup->edge_a[i] : 0;
+		low_w[i] = _mm_setr_epi32(edge_w, edge_w + step, edge_w + 2 * step, edge_w + 3 * step);
+		high_w[i] = _mm_add_epi32(low_w[i], _mm_set1_epi32(4 * step));
+		row_step[i] = _mm_set1_epi32(tested ? (Sint32)setup->edge_b[i] : 0);
+	}
+	const __m128i fill = _mm_set1_epi32((int)color);
+	int written = 0;
+	
+	for (int y = 0; y < height; y++) {
+		Uint32 *row = block + y * row_length;
+		__m128i low = _mm_or_si128(low_w[0], _mm_or_si128(low_w[1], low_w[2]));
+		__m128i high = _mm_or_si128(high_w[0], _mm_or_si128(high_w[1], high_w[2]));
+		if (width == SIMD_BLOCK) {
+			written += store_lanes_sse2(row, low, fill);
+			written += store_lanes_sse2(row + 4, high, fill);
+		} else {
+			// Narrow blocks at the right of the rectangle, lane by lane
+			int sign_bits = _mm_movemask_ps(_mm_castsi128_ps(low)) | _mm_movemask_ps(_mm_castsi128_ps(high)) << 4;
+			for (int x = 0; x < width; x++) {
+				if (!(sign_bits & (1 << x))) {
+					row[x] = color;
+					written++;
+				}
+			}
+		}
+		for (int i = 0; i < 3; i++) {
+			low_w[i] = _mm_add_epi32(low_w[i], row_step[i]);
+			high_w[i] = _mm_add_epi32(high_w[i], row_step[i]);
+		}
+	}
+	return written;
+}
+
+// One row of 8 lanes at a time, lanes past the block's width are masked off
+__attribute__((target("avx2")))
+static int partial_block_avx2(Uint32 *block, int row_length, const TriangleSetup *setup, const Sint64 *w, int crossing, int width, int height, Uint32 color) {
+	const __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	// Edges not crossing the block stay at 0, which counts as inside
+	__m256i lane_w[3];
+	__m256i row_step[3];
+	for (int i = 0; i < 3; i++) {
+		bool tested = crossing & (1 << i);
+		lane_w[i] = _mm256_add_epi32(_mm256_set1_epi32(tested ? (Sint32)w[i] : 0), _mm256_mullo_epi32(lane_index, _mm256_set1_epi32(tested ? (Sint32)setup->edge_a[i] : 0)));
+		row_step[i] = _mm256_set1_epi32(tested ? (Sint32)setup->edge_b[i] : 0);
+	}
+	const __m256i columns = _mm256_cmpgt_epi32(_mm256_set1_epi32(width), lane_index);
+	const __m256i fill = _mm256_set1_epi32((int)color);
+	int written = 0;
+	
+	for (int y = 0; y < height; y++) {
+		Uint32 *row = block + y * row_length;
+		// Sign bit clear in every edge value means covered
+		__m256i outside = _mm256_srai_epi32(_mm256_or_si256(lane_w[0], _mm256_or_si256(lane_w[1], lane_w[2])), 31);
+		__m256i inside = _mm256_andnot_si256(outside, columns);
+		int inside_bits = _mm256_movemask_ps(_mm256_castsi256_ps(inside));
+		if (inside_bits == 0xFF) {
+			_mm256_storeu_si256((__m256i*)row, fill);
+		} else if (inside_bits) {
+			_mm256_maskstore_epi32((int*)row, inside, fill);
+		}
+		written += __builtin_popcount(inside_bits);
+		for (int i = 0; i < 3; i++) {
+			lane_w[i] = _mm256_add_epi32(lane_w[i], row_step[i]);
+		}
+	}
+	return written;
+}
+
+// SSE2 is part of the x86-64 baseline
+__attribute__((target("sse2")))
+int rasterize_triangle_sse2(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	return rasterize_blocks(buffer, pitch, setup, color, min_x, min_y, max_x, max_y, partial_block_sse2);
+}
+
+__attribute__((target("avx2")))
+int rasterize_triangle_avx2(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	return rasterize_blocks(buffer, pitch, setup, color, min_x, min_y, max_x, max_y, partial_block_avx2);
+}
+
+bool raster_kernel_supported(RasterKernel kernel) {
+	switch (kernel) {
+		case RASTER_KERNEL_SCALAR:
+			return true;
+		case RASTER_KERNEL_SSE2:
+			return SDL_HasSSE2();
+		case RASTER_KERNEL_AVX2:
+			return SDL_HasAVX2();
+	}
+	return false;
+}
+#else
+// No vector kernels on this architecture, keep the symbols for callers
+int rasterize_triangle_sse2(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	return rasterize_triangle_scalar(buffer, pitch, setup, color, min_x, min_y, max_x, max_y);
+}
+
+int rasterize_triangle_avx2(Uint32 *buffer, int pitch, const TriangleSetup *setup, Uint32 color, int min_x, int min_y, int max_x, int max_y) {
+	return rasterize_triangle_scalar(buffer, pitch, setup, color, min_x, min_y, max_x, max_y);
+}
+
+bool raster_kernel_supported(RasterKernel kernel) {
+	return kernel == RASTER_KERNEL_SCALAR;
+}
+#endif
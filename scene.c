@@ -0,0 +1,402 @@
+#include <stdlib.h>
+#include <math.h>
+#include "scene.h"
+
+// ### CONSTANT DEFINITIONS ### //
+// Median splits keep the depth below 32 for any int count, and the traversal
+// holds at most one pending sibling per level
+#define SCENE_STACK_SIZE 64
+
+// ### STRUCTS ### //
+// Instances are partitioned with their centers next to them, so each split
+// streams through memory instead of gathering from the instance array
+typedef struct {
+	Vec3 center;
+	int instance;
+} BuildItem;
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## INLINE FUNCTIONS ## //
+static inline float vec3_axis(Vec3 v, int axis) {
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// Plain comparisons, fminf and fmaxf are library calls unless NaNs are ruled out
+static inline Vec3 vec3_min(Vec3 a, Vec3 b) {
+	return (Vec3){ a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z };
+}
+
+static inline Vec3 vec3_max(Vec3 a, Vec3 b) {
+	return (Vec3){ a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z };
+}
+
+// # CREATE AND DESTROY FUNCTIONS # //
+SceneGraph *create_scene_graph(int capacity) {
+	if (capacity < 1) {
+		capacity = 1;
+	}
+	
+	SceneGraph *graph = calloc(1, sizeof(SceneGraph));
+	if (!graph) {
+		return NULL;
+	}
+	
+	// Nodes are allocated by the first build
+	graph->instances = malloc(capacity * sizeof(SceneInstance));
+	graph->order = malloc(capacity * sizeof(int));
+	if ((!graph->instances) || (!graph->order)) {
+		destroy_scene_graph(&graph);
+		return NULL;
+	}
+	graph->capacity = capacity;
+	return graph;
+}
+
+void destroy_scene_graph(SceneGraph **graph) {
+	if ((!graph) || (!(*graph))) {
+		return;
+	}
+	
+	free((*graph)->instances);
+	free((*graph)->order);
+	free((*graph)->nodes);
+	free((*graph)->dirty_nodes);
+	free(*graph);
+	*graph = NULL;
+}
+
+// ## INSTANCES ## //
+// Centered on the centroid, like the mesh bounds
+static void points_bounds(const Vec3 *points, int count, Vec3 *center, float *radius) {
+	Vec3 sum = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < count; i++) {
+		sum = vec3_add(sum, points[i]);
+	}
+	*center = vec3_scale(sum, 1.0f / count);
+	
+	float radius_squared = 0.0f;
+	for (int i = 0; i < count; i++) {
+		float distance_squared = vec3_distance_squared(*center, points[i]);
+		radius_squared = distance_squared > radius_squared ? distance_squared : radius_squared;
+	}
+	*radius = sqrtf(radius_squared);
+}
+
+// Sets the transform and the world space box of its bounding sphere
+static void place_instance(SceneInstance *instance, Transform transform) {
+	instance->transform = transform;
+	instance->model_matrix = transform_matrix(transform);
+	Vec4 center = mat4_vec4_mul(instance->model_matrix, vec3_homogenous(instance->local_center, 1.0f));
+	float radius = instance->local_radius * fabsf(transform.scale);
+	instance->bounds_min = (Vec3){ center.x - radius, center.y - radius, center.z - radius };
+	instance->bounds_max = (Vec3){ center.x + radius, center.y + radius, center.z + radius };
+}
+
+static int add_instance(SceneGraph *graph, Shape shape, Vec3 local_center, float local_radius, Transform transform, ColorRgb color) {
+	if (graph->count == graph->capacity) {
+		int capacity = 2 * graph->capacity;
+		SceneInstance *instances = realloc(graph->instances, capacity * sizeof(SceneInstance));
+		if (!instances) {
+			return -1;
+		}
+		graph->instances = instances;
+		int *order = realloc(graph->order, capacity * sizeof(int));
+		if (!order) {
+			return -1;
+		}
+		graph->order = order;
+		graph->capacity = capacity;
+	}
+	
+	SceneInstance *instance = &graph->instances[graph->count];
+	instance->shape = shape;
+	instance->color = color;
+	instance->local_center = local_center;
+	instance->local_radius = local_radius;
+	instance->leaf = -1;
+	instance->drawn_in = 0;
+	place_instance(instance, transform);
+	graph->needs_build = true;
+	return graph->count++;
+}
+
+int scene_graph_add_cube(SceneGraph *graph, const Cube *cube, Transform transform, ColorRgb color) {
+	if ((!graph) || (!cube)) {
+		return -1;
+	}
+	
+	Vec3 center;
+	float radius;
+	points_bounds(cube->vertices, 8, &center, &radius);
+	return add_instance(graph, (Shape){ SHAPE_CUBE, .cube = cube }, center, radius, transform, color);
+}
+
+int scene_graph_add_tetrahedron(SceneGraph *graph, const Tetrahedron *tetrahedron, Transform transform, ColorRgb color) {
+	if ((!graph) || (!tetrahedron)) {
+		return -1;
+	}
+	
+	Vec3 center;
+	float radius;
+	points_bounds(tetrahedron->vertices, 4, &center, &radius);
+	return add_instance(graph, (Shape){ SHAPE_TETRAHEDRON, .tetrahedron = tetrahedron }, center, radius, transform, color);
+}
+
+int scene_graph_add_mesh(SceneGraph *graph, const Mesh *mesh, Transform transform, ColorRgb color) {
+	// The mesh bounds have to be computed, it is not written to here
+	if ((!graph) || (!mesh) || mesh->bounds_radius < 0.0f) {
+		return -1;
+	}
+	
+	return add_instance(graph, (Shape){ SHAPE_MESH, .mesh = mesh }, mesh->bounds_center, mesh->bounds_radius, transform, color);
+}
+
+int scene_graph_add_mesh_lod(SceneGraph *graph, const MeshLod *lod, Transform transform, ColorRgb color) {
+	// Culled by the bounds of the full detail level
+	if ((!graph) || (!lod) || lod->level_count < 1 || lod->levels[0]->bounds_radius < 0.0f) {
+		return -1;
+	}
+	
+	const Mesh *full = lod->levels[0];
+	return add_instance(graph, (Shape){ SHAPE_MESH_LOD, .mesh_lod = lod }, full->bounds_center, full->bounds_radius, transform, color);
+}
+
+// Queues the node and its ancestors, up to the first one already queued
+static void queue_refit(SceneGraph *graph, int node) {
+	while (node >= 0 && !graph->nodes[node].dirty) {
+		graph->nodes[node].dirty = true;
+		graph->dirty_nodes[graph->dirty_count++] = node;
+		node = graph->nodes[node].parent;
+	}
+}
+
+bool scene_graph_set_transform(SceneGraph *graph, int instance, Transform transform) {
+	if ((!graph) || instance < 0 || instance >= graph->count) {
+		return false;
+	}
+	
+	place_instance(&graph->instances[instance], transform);
+	// A pending build places it anyway
+	if (!graph->needs_build && graph->instances[instance].leaf >= 0) {
+		queue_refit(graph, graph->instances[instance].leaf);
+	}
+	return true;
+}
+
+// ## HIERARCHY ## //
+// Box of the node's instances, or of its children
+static void fit_node(SceneGraph *graph, int index) {
+	BvhNode *node = &graph->nodes[index];
+	if (node->count > 0) {
+		const SceneInstance *instance = &graph->instances[graph->order[node->first]];
+		node->bounds_min = instance->bounds_min;
+		node->bounds_max = instance->bounds_max;
+		for (int i = 1; i < node->count; i++) {
+			instance = &graph->instances[graph->order[node->first + i]];
+			node->bounds_min = vec3_min(node->bounds_min, instance->bounds_min);
+			node->bounds_max = vec3_max(node->bounds_max, instance->bounds_max);
+		}
+	} else {
+		const BvhNode *left = &graph->nodes[index + 1];
+		const BvhNode *right = &graph->nodes[node->first];
+		node->bounds_min = vec3_min(left->bounds_min, right->bounds_min);
+		node->bounds_max = vec3_max(left->bounds_max, right->bounds_max);
+	}
+}
+
+// Quickselect: reorders the instances so the one at k has the k-th smallest
+// center along the axis, the smaller ones before it and the larger ones after
+static void select_median(BuildItem *items, int count, int k, int axis) {
+	int low = 0;
+	int high = count - 1;
+	while (low < high) {
+		float pivot = vec3_axis(items[(low + high) / 2].center, axis);
+		int i = low;
+		int j = high;
+		while (i <= j) {
+			while (vec3_axis(items[i].center, axis) < pivot) i++;
+			while (vec3_axis(items[j].center, axis) > pivot) j--;
+			if (i <= j) {
+				BuildItem swap = items[i];
+				items[i++] = items[j];
+				items[j--] = swap;
+			}
+		}
+		if (k <= j) {
+			high = j;
+		} else if (k >= i) {
+			low = i;
+		} else {
+			break;
+		}
+	}
+}
+
+// Returns the index of the node holding items[first, first + count), which
+// also become order[first, first + count)
+static int build_node(SceneGraph *graph, BuildItem *items, int parent, int first, int count) {
+	int index = graph->node_count++;
+	BvhNode *node = &graph->nodes[index];
+	node->parent = parent;
+	node->dirty = false;
+	if (count <= SCENE_LEAF_SIZE) {
+		node->first = first;
+		node->count = count;
+		for (int i = 0; i < count; i++) {
+			graph->order[first + i] = items[first + i].instance;
+			graph->instances[items[first + i].instance].leaf = index;
+		}
+		fit_node(graph, index);
+		return index;
+	}
+	
+	// Split at the median along the axis the centers spread the most over
+	Vec3 min = { INFINITY, INFINITY, INFINITY };
+	Vec3 max = { -INFINITY, -INFINITY, -INFINITY };
+	for (int i = first; i < first + count; i++) {
+		min = vec3_min(min, items[i].center);
+		max = vec3_max(max, items[i].center);
+	}
+	Vec3 extent = vec3_sub(max, min);
+	int axis = extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+	int half = count / 2;
+	select_median(items + first, count, half, axis);
+	
+	node->count = 0;
+	build_node(graph, items, index, first, half);
+	node->first = build_node(graph, items, index, first + half, count - half);
+	fit_node(graph, index);
+	return index;
+}
+
+bool scene_graph_build(SceneGraph *graph) {
+	if (!graph) {
+		return false;
+	}
+	
+	// A binary tree whose leaves hold at least one instance each has fewer than 2 * count nodes
+	int node_capacity = 2 * graph->count;
+	if (node_capacity > graph->node_capacity) {
+		BvhNode *nodes = realloc(graph->nodes, node_capacity * sizeof(BvhNode));
+		if (!nodes) {
+			return false;
+		}
+		graph->nodes = nodes;
+		int *dirty_nodes = realloc(graph->dirty_nodes, node_capacity * sizeof(int));
+		if (!dirty_nodes) {
+			return false;
+		}
+		graph->dirty_nodes = dirty_nodes;
+		graph->node_capacity = node_capacity;
+	}
+	
+	graph->node_count = 0;
+	graph->dirty_count = 0;
+	if (graph->count > 0) {
+		BuildItem *items = malloc(graph->count * sizeof(BuildItem));
+		if (!items) {
+			return false;
+		}
+		for (int i = 0; i < graph->count; i++) {
+			const SceneInstance *instance = &graph->instances[i];
+			items[i].center = vec3_scale(vec3_add(instance->bounds_min, instance->bounds_max), 0.5f);
+			items[i].instance = i;
+		}
+		build_node(graph, items, -1, 0, graph->count);
+		free(items);
+	}
+	graph->needs_build = false;
+	return true;
+}
+
+static int compare_descending(const void *a, const void *b) {
+	return *(const int*)b - *(const int*)a;
+}
+
+void scene_graph_refit(SceneGraph *graph) {
+	if ((!graph) || graph->dirty_count == 0) {
+		return;
+	}
+	
+	// Children come after their parents, so in decreasing order every child is
+	// refit before its parent
+	qsort(graph->dirty_nodes, graph->dirty_count, sizeof(int), compare_descending);
+	for (int i = 0; i < graph->dirty_count; i++) {
+		fit_node(graph, graph->dirty_nodes[i]);
+		graph->nodes[graph->dirty_nodes[i]].dirty = false;
+	}
+	graph->dirty_count = 0;
+}
+
+// ## DRAWING ## //
+static bool draw_instance(RenderContext *ctx, const SceneInstance *instance) {
+	set_model_matrix(ctx, instance->model_matrix);
+	switch (instance->shape.type) {
+		case SHAPE_CUBE:
+			return draw_cube(ctx, *instance->shape.cube, instance->color);
+		case SHAPE_TETRAHEDRON:
+			return draw_tetrahedron(ctx, *instance->shape.tetrahedron, instance->color);
+		case SHAPE_MESH:
+			return draw_mesh(ctx, instance->shape.mesh, instance->color);
+		case SHAPE_MESH_LOD:
+			return draw_mesh_lod(ctx, instance->shape.mesh_lod, instance->color);
+	}
+	return false;
+}
+
+bool scene_graph_draw(SceneGraph *graph, RenderContext *ctx) {
+	if (!(graph && ctx && ctx->target)) {
+		return false;
+	}
+	
+	if (graph->needs_build && !scene_graph_build(graph)) {
+		return false;
+	}
+	scene_graph_refit(graph);
+	graph->visited_nodes = 0;
+	graph->drawn_instances = 0;
+	graph->draw_count++;
+	if (graph->node_count == 0) {
+		return true;
+	}
+	
+	// Depth first, each pending node with the planes it still has to be tested against
+	int stack[SCENE_STACK_SIZE];
+	int plane_masks[SCENE_STACK_SIZE];
+	stack[0] = 0;
+	plane_masks[0] = (1 << CLIP_PLANE_COUNT) - 1;
+	int top = 1;
+	bool result = true;
+	while (top > 0) {
+		top--;
+		int index = stack[top];
+		const BvhNode *node = &graph->nodes[index];
+		int plane_mask = plane_masks[top];
+		graph->visited_nodes++;
+		if (plane_mask && !box_in_frustum(&ctx->frustum, node->bounds_min, node->bounds_max, &plane_mask)) {
+			continue;
+		}
+	
+		if (node->count == 0) {
+			// Right first, so the left subtree is drawn first
+			stack[top] = node->first;
+			plane_masks[top++] = plane_mask;
+			stack[top] = index + 1;
+			plane_masks[top++] = plane_mask;
+			continue;
+		}
+	
+		for (int i = 0; i < node->count; i++) {
+			SceneInstance *instance = &graph->instances[graph->order[node->first + i]];
+			int instance_mask = plane_mask;
+			if (instance_mask && !box_in_frustum(&ctx->frustum, instance->bounds_min, instance->bounds_max, &instance_mask)) {
+				continue;
+			}
+			result = draw_instance(ctx, instance) && result;
+			instance->drawn_in = graph->draw_count;
+			graph->drawn_instances++;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,117 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdbool.h>
+#include "graphics.h"
+
+// ### CONSTANTS ### //
+// Most instances in one leaf of the hierarchy
+#define SCENE_LEAF_SIZE 4
+
+// ### STRUCTS AND ENUMS ### //
+typedef enum {
+	SHAPE_CUBE,
+	SHAPE_TETRAHEDRON,
+	SHAPE_MESH,
+	SHAPE_MESH_LOD,
+} ShapeType;
+
+// What an instance draws; shapes are not copied, so any number of instances
+// can share one, and it has to outlive them
+typedef struct {
+	ShapeType type;
+	union {
+		const Cube *cube;
+		const Tetrahedron *tetrahedron;
+		const Mesh *mesh;
+		const MeshLod *mesh_lod;
+	};
+} Shape;
+
+typedef struct {
+	Shape shape;
+	Transform transform;
+	ColorRgb color;
+	// Of the transform, built when it is set
+	Matrix4 model_matrix;
+	// Model space bounding sphere of the shape
+	Vec3 local_center;
+	float local_radius;
+	// World space box around the transformed sphere
+	Vec3 bounds_min;
+	Vec3 bounds_max;
+	// Leaf of the hierarchy holding it, -1 until it is built
+	int leaf;
+	// The graph's draw_count when it was last drawn, 0 if never
+	int drawn_in;
+} SceneInstance;
+
+// Nodes are stored depth first, so a left child directly follows its parent
+// and every child comes after it
+typedef struct {
+	Vec3 bounds_min;
+	Vec3 bounds_max;
+	// Leaves: first index of their range of the instance order
+	// Internal nodes: the right child
+	int first;
+	// Instances in a leaf, 0 for internal nodes
+	int count;
+	int parent;
+	// Queued for the next refit
+	bool dirty;
+} BvhNode;
+
+// Instances of shapes with model transforms, and a bounding volume hierarchy
+// over their world space bounds for culling them to the view volume
+typedef struct {
+	SceneInstance *instances;
+	int count;
+	int capacity;
+	BvhNode *nodes;
+	int node_count;
+	int node_capacity;
+	// Instance indices, each leaf owns a contiguous range
+	int *order;
+	// Nodes whose boxes are stale since instances moved
+	int *dirty_nodes;
+	int dirty_count;
+	// Set when instances were added since the last build
+	bool needs_build;
+	// Of the last draw
+	int visited_nodes;
+	int drawn_instances;
+	// Draws so far; the instances drawn by the last one have it as drawn_in
+	int draw_count;
+} SceneGraph;
+
+// ### FUNCTION DECLARATIONS ### //
+// # CREATE AND DESTROY FUNCTIONS # //
+// Room for capacity instances, more are added by growing the arrays
+SceneGraph *create_scene_graph(int capacity);
+void destroy_scene_graph(SceneGraph **graph);
+
+// # INSTANCES # //
+// Return the index of the new instance, or -1 when it could not be stored
+int scene_graph_add_cube(SceneGraph *graph, const Cube *cube, Transform transform, ColorRgb color);
+int scene_graph_add_tetrahedron(SceneGraph *graph, const Tetrahedron *tetrahedron, Transform transform, ColorRgb color);
+int scene_graph_add_mesh(SceneGraph *graph, const Mesh *mesh, Transform transform, ColorRgb color);
+// Drawn at the level of detail its projected size picks every frame
+int scene_graph_add_mesh_lod(SceneGraph *graph, const MeshLod *lod, Transform transform, ColorRgb color);
+// Moves an instance; the hierarchy is refit, not rebuilt, by the next draw
+bool scene_graph_set_transform(SceneGraph *graph, int instance, Transform transform);
+
+// # HIERARCHY # //
+// Top-down build splitting at the median along the widest axis of the centers,
+// done by the next draw after instances are added
+bool scene_graph_build(SceneGraph *graph);
+// Recomputes the boxes of the leaves holding moved instances and of their
+// ancestors only. The tree keeps its shape, so after large moves a rebuild culls better
+void scene_graph_refit(SceneGraph *graph);
+
+// # DRAWING # //
+// Draws every instance whose subtree is not culled by ctx->frustum; subtrees
+// entirely inside it are drawn without testing their nodes against it again
+// The model matrix of the last instance drawn is left set
+bool scene_graph_draw(SceneGraph *graph, RenderContext *ctx);
+
+#endif
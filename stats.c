@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "stats.h"
+
+// ### CONSTANT DEFINITIONS ### //
+// Glyphs are 3 x 5 bits, each drawn as OVERLAY_SCALE x OVERLAY_SCALE pixels
+#define GLYPH_WIDTH 3
+#define GLYPH_HEIGHT 5
+#define OVERLAY_SCALE 2
+#define OVERLAY_ADVANCE ((GLYPH_WIDTH + 1) * OVERLAY_SCALE)
+#define OVERLAY_LINE_HEIGHT ((GLYPH_HEIGHT + 1) * OVERLAY_SCALE)
+#define OVERLAY_MARGIN 4
+// Header, whole frame, the stages, then the counters
+#define OVERLAY_LINES (2 + STAT_STAGE_COUNT + STAT_COUNTER_COUNT)
+#define OVERLAY_COLUMNS 23
+#define OVERLAY_BACKGROUND 0xFF202020
+#define OVERLAY_TEXT 0xFFE0E0E0
+
+// Rows top to bottom, bit 14 is the top left pixel; missing characters are blank
+static const Uint16 font_glyphs[128] = {
+	['0'] = 0x7B6F, ['1'] = 0x2C97, ['2'] = 0x73E7, ['3'] = 0x72CF, ['4'] = 0x5BC9, ['5'] = 0x79CF, ['6'] = 0x79EF, ['7'] = 0x7292, ['8'] = 0x7BEF, ['9'] = 0x7BCF,
+	['a'] = 0x2BED, ['b'] = 0x6BAE, ['c'] = 0x3923, ['d'] = 0x6B6E, ['e'] = 0x79A7, ['f'] = 0x79A4, ['g'] = 0x396B, ['h'] = 0x5BED, ['i'] = 0x7497, ['j'] = 0x126A, ['k'] = 0x5BAD, ['l'] = 0x4927, ['m'] = 0x5FED,
+	['n'] = 0x6B6D, ['o'] = 0x2B6A, ['p'] = 0x6BA4, ['q'] = 0x2B73, ['r'] = 0x6BAD, ['s'] = 0x388E, ['t'] = 0x7492, ['u'] = 0x5B6F, ['v'] = 0x5B6A, ['w'] = 0x5BFD, ['x'] = 0x5AAD, ['y'] = 0x5A92, ['z'] = 0x72A7,
+	['.'] = 0x0002, [':'] = 0x0410, ['/'] = 0x12A4, ['-'] = 0x01C0, ['%'] = 0x52A5,
+};
+
+static const char *stage_names[STAT_STAGE_COUNT] = { "clear", "transform", "clip", "raster", "present" };
+// Bytes are those taken from the frame arena
+static const char *counter_names[STAT_COUNTER_COUNT] = { "vertices", "triangles", "culled", "lines", "pixels", "bytes" };
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## TIMING ## //
+void frame_stats_reset(FrameStats *stats) {
+	if (stats) {
+		memset(stats, 0, sizeof(FrameStats));
+	}
+}
+
+Uint64 stats_start(const FrameStats *stats) {
+	return stats ? SDL_GetPerformanceCounter() : 0;
+}
+
+Uint64 stats_lap(FrameStats *stats, StatStage stage, Uint64 start) {
+	if (!stats) {
+		return 0;
+	}
+	
+	Uint64 now = SDL_GetPerformanceCounter();
+	stats->stage_ticks[stage] += now - start;
+	return now;
+}
+
+void stats_count(FrameStats *stats, StatCounter counter, long amount) {
+	if (stats) {
+		stats->counters[counter] += amount;
+	}
+}
+
+double stats_ticks_to_ms(Uint64 ticks) {
+	return 1000.0 * (double)ticks / (double)SDL_GetPerformanceFrequency();
+}
+
+// ## HISTORY ## //
+void stats_history_clear(StatsHistory *history) {
+	history->count = 0;
+	history->next = 0;
+}
+
+void stats_history_add(StatsHistory *history, const FrameStats *stats) {
+	history->frames[history->next] = *stats;
+	history->next = (history->next + 1) % STATS_HISTORY;
+	if (history->count < STATS_HISTORY) {
+		history->count++;
+	}
+}
+
+static int compare_ticks(const void *a, const void *b) {
+	Uint64 x = *(const Uint64*)a;
+	Uint64 y = *(const Uint64*)b;
+	return (x > y) - (x < y);
+}
+
+double stats_history_percentile_ms(const StatsHistory *history, StatStage stage, double percentile) {
+	if ((!history) || history->count == 0) {
+		return 0.0;
+	}
+	
+	Uint64 ticks[STATS_HISTORY];
+	for (int i = 0; i < history->count; i++) {
+		const FrameStats *frame = &history->frames[i];
+		ticks[i] = stage == STAT_STAGE_COUNT ? frame->frame_ticks : frame->stage_ticks[stage];
+	}
+	qsort(ticks, history->count, sizeof(Uint64), compare_ticks);
+	
+	// Nearest rank
+	int rank = (int)(percentile / 100.0 * history->count + 0.999999);
+	if (rank < 1) rank = 1;
+	if (rank > history->count) rank = history->count;
+	return stats_ticks_to_ms(ticks[rank - 1]);
+}
+
+// ## OUTPUT ## //
+const char *stat_stage_name(StatStage stage) {
+	return stage < STAT_STAGE_COUNT ? stage_names[stage] : "frame";
+}
+
+const char *stat_counter_name(StatCounter counter) {
+	return counter < STAT_COUNTER_COUNT ? counter_names[counter] : "";
+}
+
+void stats_write_csv_header(FILE *file) {
+	fprintf(file, "frame,frame_ms");
+	for (int i = 0; i < STAT_STAGE_COUNT; i++) {
+		fprintf(file, ",%s_ms", stage_names[i]);
+	}
+	for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+		fprintf(file, ",%s", counter_names[i]);
+	}
+	fprintf(file, "\n");
+}
+
+void stats_write_csv_row(FILE *file, int frame, const FrameStats *stats) {
+	fprintf(file, "%d,%.4f", frame, stats_ticks_to_ms(stats->frame_ticks));
+	for (int i = 0; i < STAT_STAGE_COUNT; i++) {
+		fprintf(file, ",%.4f", stats_ticks_to_ms(stats->stage_ticks[i]));
+	}
+	for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+		fprintf(file, ",%ld", stats->counters[i]);
+	}
+	fprintf(file, "\n");
+}
+
+ScreenRect stats_overlay_bounds(const RenderTarget *target) {
+	ScreenRect bounds = { 0, 0, 2 * OVERLAY_MARGIN + OVERLAY_COLUMNS * OVERLAY_ADVANCE, 2 * OVERLAY_MARGIN + OVERLAY_LINES * OVERLAY_LINE_HEIGHT };
+	return screen_rect_intersection(bounds, (ScreenRect){ 0, 0, target->width, target->height });
+}
+
+// Text is clipped to bounds
+static void draw_text(RenderTarget *target, ScreenRect bounds, int x, int y, const char *text) {
+	for (; *text; text++, x += OVERLAY_ADVANCE) {
+		Uint16 glyph = font_glyphs[tolower((unsigned char)*text) & 0x7F];
+		for (int row = 0; row < GLYPH_HEIGHT && glyph; row++) {
+			for (int column = 0; column < GLYPH_WIDTH; column++) {
+				if (!(glyph & (1 << (14 - row * GLYPH_WIDTH - column)))) {
+					continue;
+				}
+				ScreenRect dot = { x + column * OVERLAY_SCALE, y + row * OVERLAY_SCALE, x + (column + 1) * OVERLAY_SCALE, y + (row + 1) * OVERLAY_SCALE };
+				dot = screen_rect_intersection(dot, bounds);
+				if (!screen_rect_empty(dot)) {
+					fill_rect(target->pixels, target->pitch, dot.min_x, dot.min_y, dot.max_x, dot.max_y, OVERLAY_TEXT);
+				}
+			}
+		}
+	}
+}
+
+void stats_draw_overlay(RenderTarget *target, const StatsHistory *history) {
+	if ((!target) || (!history)) {
+		return;
+	}
+	ScreenRect bounds = stats_overlay_bounds(target);
+	if (screen_rect_empty(bounds)) {
+		return;
+	}
+	
+	fill_rect(target->pixels, target->pitch, bounds.min_x, bounds.min_y, bounds.max_x, bounds.max_y, OVERLAY_BACKGROUND);
+	char line[OVERLAY_COLUMNS + 1];
+	int x = OVERLAY_MARGIN;
+	int y = OVERLAY_MARGIN;
+	snprintf(line, sizeof(line), "%-9s %6s %6s", "ms", "p50", "p99");
+	draw_text(target, bounds, x, y, line);
+	// The whole frame first, then each stage
+	for (int i = -1; i < STAT_STAGE_COUNT; i++) {
+		StatStage stage = i < 0 ? STAT_STAGE_COUNT : (StatStage)i;
+		y += OVERLAY_LINE_HEIGHT;
+		snprintf(line, sizeof(line), "%-9s %6.2f %6.2f", stat_stage_name(stage), stats_history_percentile_ms(history, stage, 50.0), stats_history_percentile_ms(history, stage, 99.0));
+		draw_text(target, bounds, x, y, line);
+	}
+	
+	// Counters of the latest frame
+	const FrameStats *latest = &history->frames[(history->next + STATS_HISTORY - 1) % STATS_HISTORY];
+	for (int i = 0; i < STAT_COUNTER_COUNT; i++) {
+		y += OVERLAY_LINE_HEIGHT;
+		snprintf(line, sizeof(line), "%-9s %13ld", counter_names[i], history->count > 0 ? latest->counters[i] : 0L);
+		draw_text(target, bounds, x, y, line);
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <SDL2/SDL.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "framebuffer.h"
+#include "dirty.h"
+
+// ### CONSTANTS ### //
+// Frames the rolling percentiles are taken over
+#define STATS_HISTORY 240
+
+// ### STRUCTS AND ENUMS ### //
+typedef enum {
+	STAT_STAGE_CLEAR,
+	STAT_STAGE_TRANSFORM,
+	STAT_STAGE_CLIP,
+	STAT_STAGE_RASTER,
+	STAT_STAGE_PRESENT,
+	STAT_STAGE_COUNT,
+} StatStage;
+
+typedef enum {
+	STAT_VERTICES_TRANSFORMED,
+	STAT_TRIANGLES_RASTERIZED,
+	// Back faces dropped before rasterization
+	STAT_TRIANGLES_CULLED,
+	STAT_LINES_RASTERIZED,
+	STAT_PIXELS_WRITTEN,
+	STAT_BYTES_ALLOCATED,
+	STAT_COUNTER_COUNT,
+} StatCounter;
+
+// Performance counter ticks spent in each stage of one frame, and the work done
+typedef struct {
+	Uint64 stage_ticks[STAT_STAGE_COUNT];
+	long counters[STAT_COUNTER_COUNT];
+	// Whole frame, including what no stage covers (dirty tracking, scene updates)
+	Uint64 frame_ticks;
+} FrameStats;
+
+// Ring of the last STATS_HISTORY frames
+typedef struct {
+	FrameStats frames[STATS_HISTORY];
+	int count;
+	int next;
+} StatsHistory;
+
+// ### FUNCTION DECLARATIONS ### //
+// # TIMING # //
+// stats may be NULL, timing is then skipped and costs only the check
+void frame_stats_reset(FrameStats *stats);
+Uint64 stats_start(const FrameStats *stats);
+// Adds the ticks since start to the stage, returns the start of the next lap
+Uint64 stats_lap(FrameStats *stats, StatStage stage, Uint64 start);
+void stats_count(FrameStats *stats, StatCounter counter, long amount);
+double stats_ticks_to_ms(Uint64 ticks);
+
+// # HISTORY # //
+void stats_history_clear(StatsHistory *history);
+void stats_history_add(StatsHistory *history, const FrameStats *stats);
+// Milliseconds below which percentile percent of the frames in the history spent
+// in the stage, STAT_STAGE_COUNT selects the whole frame
+double stats_history_percentile_ms(const StatsHistory *history, StatStage stage, double percentile);
+
+// # OUTPUT # //
+const char *stat_stage_name(StatStage stage);
+const char *stat_counter_name(StatCounter counter);
+void stats_write_csv_header(FILE *file);
+void stats_write_csv_row(FILE *file, int frame, const FrameStats *stats);
+// Pixels the overlay covers, the same for every frame drawn at this target size
+ScreenRect stats_overlay_bounds(const RenderTarget *target);
+// p50 and p99 of every stage and the latest frame's counters, over the target's top left corner
+void stats_draw_overlay(RenderTarget *target, const StatsHistory *history);
+
+#endif
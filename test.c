@@ -0,0 +1,1065 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <utime.h>
+#include "graphics.h"
+#include "loader.h"
+#include "scene.h"
+
+// ### CONSTANTS ### //
+const int TEST_WIDTH = 320;
+const int TEST_HEIGHT = 240;
+const int RANDOM_TRIANGLES = 2000;
+const size_t TEST_ARENA_SIZE = 64 * 1024 * 1024;
+// Vertices are put on the 1/16 pixel grid both paths snap to, so coverage may
+// only differ for samples this close to an edge, where the float barycentric
+// test and the top-left rule can break the tie differently
+const float EDGE_TOLERANCE = 1e-3f;
+// Pixel states while comparing: rasterized, then 1 is added when the reference has it
+const Uint32 COVERED = 2;
+// Sphere drawn through cube --model, 499848 triangles, binned in several flushes
+const int MODEL_RINGS = 354;
+const int MODEL_SEGMENTS = 708;
+// Arenas of the reference run, large enough that it never flushes
+const int REFERENCE_ARENA_MEGABYTES = 512;
+// Elements per linalg kernel call, 4 past a multiple of 8 and 1 past one of 4,
+// so the scalar tail runs after both vector widths
+#define LINALG_COUNT 37
+// Random triangles and spheres clipped or culled against the camera's view volume
+const int CLIP_CASES = 2000;
+// Clipped vertices are interpolated, so they can land this far outside a plane, relative to w
+const float CLIP_TOLERANCE = 1e-5f;
+// Cubes scattered in and around the view, and how many move between draws
+const int SCENE_INSTANCES = 300;
+const int SCENE_MOVES = 40;
+const int SCENE_ROUNDS = 20;
+// More than one batch of draw_mesh_instanced, and the instances a small arena has room for per batch
+const int INSTANCES = 300;
+const int SMALL_ARENA_INSTANCES[] = { 3, 1 };
+
+// ### STRUCTS ### //
+// Pixels of one triangle by both paths, and what differs
+typedef struct {
+	long rasterized;
+	long reference;
+	long mismatched;
+	// Farthest mismatched sample from the triangle's edges, in pixels
+	float worst_distance;
+} Coverage;
+
+// ### FUNCTION DEFINITIONS ### //
+static Uint32 next_random(Uint32 *state) {
+	*state = *state * 1664525u + 1013904223u;
+	return *state;
+}
+
+static float random_range(Uint32 *state, float min, float max) {
+	return min + (max - min) * (float)(next_random(state) >> 8) / 16777216.0f;
+}
+
+// On the grid of setup_triangle, so snapping moves nothing
+static float snap(float v) {
+	return roundf(v * 16.0f) / 16.0f;
+}
+
+static Vec3 random_vertex(Uint32 *state, float min_x, float max_x, float min_y, float max_y) {
+	return (Vec3){ snap(random_range(state, min_x, max_x)), snap(random_range(state, min_y, max_y)), 0.0f };
+}
+
+// Distance from the sample to the nearest edge line of the triangle, or of the
+// target, which the reference path clips the triangle to first
+static float edge_distance(const Triangle *t, int width, int height, float x, float y) {
+	float nearest = fminf(fminf(x, y), fminf(width - x, height - y));
+	for (int i = 0; i < 3; i++) {
+		Vec3 a = t->vertices[i];
+		Vec3 b = t->vertices[(i + 1) % 3];
+		float length = hypotf(b.x - a.x, b.y - a.y);
+		if (length > 0.0f) {
+			float distance = fabsf((b.x - a.x) * (y - a.y) - (b.y - a.y) * (x - a.x)) / length;
+			nearest = distance < nearest ? distance : nearest;
+		}
+	}
+	return nearest;
+}
+
+// Covers the triangle with rasterize_triangle and with get_triangle_points, the
+// reference path, and compares the two pixel sets inside the target
+static Coverage compare_coverage(RenderContext *ctx, Uint32 *buffer, Triangle t) {
+	Coverage coverage = { 0, 0, 0, 0.0f };
+	int width = ctx->target->width;
+	int height = ctx->target->height;
+	memset(buffer, 0, (size_t)width * height * sizeof(Uint32));
+	
+	TriangleSetup setup;
+	if (setup_triangle(&setup, t.vertices[0], t.vertices[1], t.vertices[2])) {
+		coverage.rasterized = rasterize_triangle(buffer, width * 4, &setup, COVERED, 0, 0, width, height);
+	}
+	
+	arena_reset(ctx->frame_arena);
+	int point_count = 0;
+	IVec2 *points = get_triangle_points(t, ctx, &point_count);
+	for (int i = 0; i < point_count && points; i++) {
+		IVec2 p = points[i];
+		if (p.x < 0 || p.x >= width || p.y < 0 || p.y >= height) {
+			continue;
+		}
+		// The clipped polygon is split into a fan, a sample on its diagonals comes twice
+		Uint32 *pixel = &buffer[p.y * width + p.x];
+		if (*pixel & 1) {
+			continue;
+		}
+		coverage.reference++;
+		*pixel += 1;
+		if (*pixel == COVERED + 1) {
+			continue;
+		}
+		coverage.mismatched++;
+		float distance = edge_distance(&t, width, height, (float)p.x, (float)p.y);
+		coverage.worst_distance = distance > coverage.worst_distance ? distance : coverage.worst_distance;
+	}
+	
+	// What is left fully set was only rasterized
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			if (buffer[y * width + x] == COVERED) {
+				coverage.mismatched++;
+				float distance = edge_distance(&t, width, height, (float)x, (float)y);
+				coverage.worst_distance = distance > coverage.worst_distance ? distance : coverage.worst_distance;
+			}
+		}
+	}
+	return coverage;
+}
+
+// Triangles of one kind against the reference; only samples on an edge, of the
+// triangle or of the target, may differ
+static bool test_coverage(RenderContext *ctx, Uint32 *buffer, const char *name, Triangle *triangles, int count) {
+	long rasterized = 0;
+	long mismatched = 0;
+	float worst_distance = 0.0f;
+	for (int i = 0; i < count; i++) {
+		Coverage coverage = compare_coverage(ctx, buffer, triangles[i]);
+		rasterized += coverage.rasterized;
+		mismatched += coverage.mismatched;
+		worst_distance = coverage.worst_distance > worst_distance ? coverage.worst_distance : worst_distance;
+	}
+	bool passed = worst_distance <= EDGE_TOLERANCE;
+	printf("%-6s coverage %-12s %5d triangles %9ld pixels %5ld on-edge differences\n", passed ? "PASS" : "FAIL", name, count, rasterized, mismatched);
+	if (!passed) {
+		printf("       a sample %.4f px from every edge differs\n", worst_distance);
+	}
+	return passed;
+}
+
+// A jittered grid over a rectangle, split into triangles of both windings; the
+// rectangle's pixels have to be covered exactly once, with no gaps at shared edges
+static bool test_shared_edges(Uint32 *buffer, int width, int height, Uint32 seed) {
+	enum { CELLS = 12 };
+	int min_x = 7, min_y = 5, max_x = width - 9, max_y = height - 3;
+	Vec3 grid[CELLS + 1][CELLS + 1];
+	for (int j = 0; j <= CELLS; j++) {
+		for (int i = 0; i <= CELLS; i++) {
+			float cell_x = (float)(max_x - min_x) / CELLS;
+			float cell_y = (float)(max_y - min_y) / CELLS;
+			float x = min_x + i * cell_x;
+			float y = min_y + j * cell_y;
+			// Points on the border only move along it
+			if (i > 0 && i < CELLS) {
+				x += random_range(&seed, -0.4f, 0.4f) * cell_x;
+			}
+			if (j > 0 && j < CELLS) {
+				y += random_range(&seed, -0.4f, 0.4f) * cell_y;
+			}
+			grid[j][i] = (Vec3){ snap(x), snap(y), 0.0f };
+		}
+	}
+	
+	memset(buffer, 0, (size_t)width * height * sizeof(Uint32));
+	for (int j = 0; j < CELLS; j++) {
+		for (int i = 0; i < CELLS; i++) {
+			Vec3 a = grid[j][i], b = grid[j][i + 1], c = grid[j + 1][i + 1], d = grid[j + 1][i];
+			Vec3 triangles[2][3] = { { a, b, c }, { a, d, c } };
+			for (int k = 0; k < 2; k++) {
+				TriangleSetup setup;
+				if (!setup_triangle(&setup, triangles[k][0], triangles[k][1], triangles[k][2])) {
+					continue;
+				}
+				// Counts the writes per pixel, each triangle one at a time
+				Uint32 *mark = calloc((size_t)width * height, sizeof(Uint32));
+				if (!mark) {
+					return false;
+				}
+				rasterize_triangle(mark, width * 4, &setup, 1, 0, 0, width, height);
+				for (int p = 0; p < width * height; p++) {
+					buffer[p] += mark[p];
+				}
+				free(mark);
+			}
+		}
+	}
+	
+	long gaps = 0, overlaps = 0, outside = 0;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			Uint32 count = buffer[y * width + x];
+			bool inside = x >= min_x && x < max_x && y >= min_y && y < max_y;
+			gaps += inside && count == 0;
+			overlaps += count > 1;
+			outside += (!inside) && count > 0;
+		}
+	}
+	bool passed = gaps == 0 && overlaps == 0 && outside == 0;
+	printf("%-6s shared edges %d triangles, %ld gaps %ld overlaps %ld outside\n", passed ? "PASS" : "FAIL", 2 * CELLS * CELLS, gaps, overlaps, outside);
+	return passed;
+}
+
+// Every supported vector kernel against the scalar one, pixel for pixel
+static bool test_kernels(Uint32 *buffer, int width, int height, Triangle *triangles, int count) {
+	static const struct {
+		RasterKernel kernel;
+		TriangleKernel fill;
+		const char *name;
+	} kernels[] = {
+		{ RASTER_KERNEL_SSE2, rasterize_triangle_sse2, "sse2" },
+		{ RASTER_KERNEL_AVX2, rasterize_triangle_avx2, "avx2" },
+	};
+	Uint32 *expected = malloc((size_t)width * height * sizeof(Uint32));
+	if (!expected) {
+		return false;
+	}
+	
+	bool passed = true;
+	for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+		if (!raster_kernel_supported(kernels[k].kernel)) {
+			printf("SKIP   kernel %s not supported on this CPU\n", kernels[k].name);
+			continue;
+		}
+		long differences = 0;
+		int tested = 0;
+		for (int i = 0; i < count; i++) {
+			TriangleSetup setup;
+			Vec3 *v = triangles[i].vertices;
+			if (!(setup_triangle(&setup, v[0], v[1], v[2]) && simd_kernel_fits(&setup))) {
+				continue;
+			}
+			ScreenRect rect = screen_rect_intersection((ScreenRect){ 0, 0, width, height }, (ScreenRect){ setup.min_x, setup.min_y, setup.max_x + 1, setup.max_y + 1 });
+			if (screen_rect_empty(rect)) {
+				continue;
+			}
+			memset(expected, 0, (size_t)width * height * sizeof(Uint32));
+			memset(buffer, 0, (size_t)width * height * sizeof(Uint32));
+			rasterize_triangle_scalar(expected, width * 4, &setup, COVERED, rect.min_x, rect.min_y, rect.max_x, rect.max_y);
+			kernels[k].fill(buffer, width * 4, &setup, COVERED, rect.min_x, rect.min_y, rect.max_x, rect.max_y);
+			for (int p = 0; p < width * height; p++) {
+				differences += buffer[p] != expected[p];
+			}
+			tested++;
+		}
+		printf("%-6s kernel %-6s %5d triangles, %ld pixels differ from scalar\n", differences == 0 ? "PASS" : "FAIL", kernels[k].name, tested, differences);
+		passed &= differences == 0;
+	}
+	free(expected);
+	return passed;
+}
+
+// Outputs of every batch operation for one kernel, in one array per stream
+typedef struct {
+	float transformed[4][LINALG_COUNT];
+	float normalized[3][LINALG_COUNT];
+	float in_place[3][LINALG_COUNT];
+	float dot[LINALG_COUNT];
+} LinalgOutputs;
+
+static void run_linalg(const Matrix4 *m, float (*a)[LINALG_COUNT], float (*b)[LINALG_COUNT], LinalgOutputs *out) {
+	mat4_transform_points_soa(m, a[0], a[1], a[2], out->transformed[0], out->transformed[1], out->transformed[2], out->transformed[3], LINALG_COUNT);
+	vec3_normalize_soa(a[0], a[1], a[2], out->normalized[0], out->normalized[1], out->normalized[2], LINALG_COUNT);
+	memcpy(out->in_place, a, sizeof(out->in_place));
+	vec3_normalize_soa(out->in_place[0], out->in_place[1], out->in_place[2], out->in_place[0], out->in_place[1], out->in_place[2], LINALG_COUNT);
+	vec3_dot_soa(a[0], a[1], a[2], b[0], b[1], b[2], out->dot, LINALG_COUNT);
+}
+
+// Every supported vector kernel against the scalar one, bit for bit
+static bool test_linalg_kernels(void) {
+	static const struct {
+		LinalgKernel kernel;
+		const char *name;
+	} kernels[] = {
+		{ LINALG_KERNEL_SSE2, "sse2" },
+		{ LINALG_KERNEL_AVX2, "avx2" },
+	};
+	Uint32 seed = 7u;
+	Matrix4 m;
+	for (int row = 0; row < 4; row++) {
+		for (int column = 0; column < 4; column++) {
+			m.m[row][column] = random_range(&seed, -3.0f, 3.0f);
+		}
+	}
+	float a[3][LINALG_COUNT];
+	float b[3][LINALG_COUNT];
+	for (int axis = 0; axis < 3; axis++) {
+		for (int i = 0; i < LINALG_COUNT; i++) {
+			a[axis][i] = random_range(&seed, -100.0f, 100.0f);
+			b[axis][i] = random_range(&seed, -100.0f, 100.0f);
+		}
+		// Zero vectors in a vector lane and in the tail, which normalize leaves as they are
+		a[axis][5] = 0.0f;
+		a[axis][LINALG_COUNT - 2] = 0.0f;
+	}
+	
+	LinalgKernel selected = get_linalg_kernel();
+	static LinalgOutputs expected;
+	static LinalgOutputs actual;
+	set_linalg_kernel(LINALG_KERNEL_SCALAR);
+	run_linalg(&m, a, b, &expected);
+	bool passed = true;
+	for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+		if (!set_linalg_kernel(kernels[k].kernel)) {
+			printf("SKIP   linalg %s not supported on this CPU\n", kernels[k].name);
+			continue;
+		}
+		run_linalg(&m, a, b, &actual);
+		const Uint32 *want = (const Uint32*)&expected;
+		const Uint32 *got = (const Uint32*)&actual;
+		int differences = 0;
+		for (size_t i = 0; i < sizeof(LinalgOutputs) / sizeof(Uint32); i++) {
+			differences += want[i] != got[i];
+		}
+		printf("%-6s linalg %-6s %d elements, %d values differ from scalar\n", differences == 0 ? "PASS" : "FAIL", kernels[k].name, LINALG_COUNT, differences);
+		passed &= differences == 0;
+	}
+	set_linalg_kernel(selected);
+	return passed;
+}
+
+// Collinear vertices cover nothing
+static bool test_degenerate(Uint32 *buffer, int width, int height) {
+	Vec3 lines[][3] = {
+		{ { 10.0f, 10.0f, 0.0f }, { 50.0f, 30.0f, 0.0f }, { 90.0f, 50.0f, 0.0f } },
+		{ { 20.0f, 20.0f, 0.0f }, { 20.0f, 20.0f, 0.0f }, { 60.0f, 20.0f, 0.0f } },
+		{ { 30.5f, 10.0f, 0.0f }, { 30.5f, 40.0f, 0.0f }, { 30.5f, 90.0f, 0.0f } },
+		{ { 5.0f, 5.0f, 0.0f }, { 5.0f, 5.0f, 0.0f }, { 5.0f, 5.0f, 0.0f } },
+	};
+	long written = 0;
+	memset(buffer, 0, (size_t)width * height * sizeof(Uint32));
+	for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+		TriangleSetup setup;
+		if (setup_triangle(&setup, lines[i][0], lines[i][1], lines[i][2])) {
+			written += rasterize_triangle(buffer, width * 4, &setup, COVERED, 0, 0, width, height);
+		}
+	}
+	bool passed = written == 0;
+	printf("%-6s degenerate %d triangles, %ld pixels\n", passed ? "PASS" : "FAIL", (int)(sizeof(lines) / sizeof(lines[0])), written);
+	return passed;
+}
+
+// Inside every plane of the view volume and in front of the near plane
+static bool in_view_volume(Vec4 v, float near_plane) {
+	float slack = CLIP_TOLERANCE * fabsf(v.w);
+	return fabsf(v.x) <= v.w + slack && fabsf(v.y) <= v.w + slack && fabsf(v.z) <= v.w + slack && v.w >= near_plane - slack;
+}
+
+static Vec4 to_clip(Matrix4 view_projection, Vec3 p) {
+	return mat4_vec4_mul(view_projection, vec3_homogenous(p, 1.0f));
+}
+
+// Clips the triangle and counts the output vertices outside the view volume, -1 on too many vertices
+static int clip_triangle_outside(Matrix4 view_projection, const Vec3 *points, float near_plane, int *count) {
+	Vec4 vertices[CLIP_MAX_POLYGON_VERTICES];
+	int outcode_mask = 0;
+	for (int i = 0; i < 3; i++) {
+		vertices[i] = to_clip(view_projection, points[i]);
+		outcode_mask |= clip_outcode(vertices[i]);
+	}
+	*count = clip_polygon(vertices, 3, outcode_mask);
+	if (*count > CLIP_MAX_POLYGON_VERTICES) {
+		return -1;
+	}
+	int outside = 0;
+	for (int i = 0; i < *count; i++) {
+		outside += !in_view_volume(vertices[i], near_plane);
+	}
+	return outside;
+}
+
+// A line from the center of the view volume through plane i, in clip space; the
+// clipped end has to be on the plane and the inside end left where it was
+static bool clips_line_at_plane(int plane, bool inside_first) {
+	int axis = plane / 2;
+	float sign = (plane & 1) ? 1.0f : -1.0f;
+	float outside[3] = { 0.2f, -0.3f, 0.1f };
+	outside[axis] = 3.0f * sign;
+	Vec4 center = { 0.1f, 0.2f, -0.1f, 1.0f };
+	Vec4 far_end = { outside[0], outside[1], outside[2], 1.0f };
+	Vec4 v0 = inside_first ? center : far_end;
+	Vec4 v1 = inside_first ? far_end : center;
+	if (!clip_line(&v0, &v1)) {
+		return false;
+	}
+	Vec4 kept = inside_first ? v0 : v1;
+	Vec4 clipped = inside_first ? v1 : v0;
+	float coordinates[3] = { clipped.x, clipped.y, clipped.z };
+	return memcmp(&kept, &center, sizeof(Vec4)) == 0 && fabsf(coordinates[axis] - sign * clipped.w) <= CLIP_TOLERANCE
+		&& in_view_volume(clipped, 0.0f);
+}
+
+// The center and 26 points around the surface; a culled sphere may not have any in view
+static bool sphere_has_visible_point(Matrix4 view_projection, Vec3 center, float radius, float near_plane) {
+	for (int i = 0; i < 27; i++) {
+		Vec3 offset = { (float)(i % 3 - 1), (float)(i / 3 % 3 - 1), (float)(i / 9 - 1) };
+		float length = vec3_length(offset);
+		Vec3 point = length > 0.0f ? vec3_add(center, vec3_scale(offset, radius / length)) : center;
+		if (in_view_volume(to_clip(view_projection, point), near_plane)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Clip space distances are linear in world space, so when every corner of the box
+// around the sphere is outside one plane, all of the sphere is
+static bool sphere_outside_plane(Matrix4 view_projection, Vec3 center, float radius) {
+	int common = (1 << CLIP_PLANE_COUNT) - 1;
+	for (int i = 0; i < 8; i++) {
+		Vec3 corner = { center.x + (i & 1 ? radius : -radius), center.y + (i & 2 ? radius : -radius), center.z + (i & 4 ? radius : -radius) };
+		common &= clip_outcode(to_clip(view_projection, corner));
+	}
+	return common != 0;
+}
+
+static bool test_clipping(RenderTarget *target) {
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	Matrix4 view_projection = mat4_mul(gen_perspective_projection_matrix(&cam, (float)target->width / (float)target->height), gen_view_matrix(&cam));
+	float near_plane = cam.near_plane;
+	
+	// Two corners in front of the camera and one just behind it: the near plane cuts
+	// off one corner, leaving a quadrilateral
+	Vec3 crossing_near[3] = { { -1.0f, 0.0f, 5.0f }, { 1.0f, 0.0f, 5.0f }, { 0.0f, 0.2f, 12.5f } };
+	int near_count;
+	int near_outside = clip_triangle_outside(view_projection, crossing_near, near_plane, &near_count);
+	bool passed = near_count == 4 && near_outside == 0;
+	Vec3 behind[3] = { { -1.0f, 0.0f, 13.0f }, { 1.0f, 0.0f, 14.0f }, { 0.0f, 1.0f, 20.0f } };
+	int behind_count;
+	clip_triangle_outside(view_projection, behind, near_plane, &behind_count);
+	passed &= behind_count == 0;
+	
+	// Anywhere around the camera, behind it too
+	Uint32 seed = 31u;
+	int outside = 0;
+	int clipped = 0;
+	for (int i = 0; i < CLIP_CASES; i++) {
+		Vec3 points[3];
+		for (int k = 0; k < 3; k++) {
+			points[k] = (Vec3){ random_range(&seed, -20.0f, 20.0f), random_range(&seed, -20.0f, 20.0f), random_range(&seed, -30.0f, 30.0f) };
+		}
+		int count;
+		int triangle_outside = clip_triangle_outside(view_projection, points, near_plane, &count);
+		outside += triangle_outside != 0;
+		clipped += count > 3;
+	}
+	passed &= outside == 0 && clipped > 0;
+	
+	// Every plane, with the outside end first and last
+	int lines = 0;
+	for (int plane = 0; plane < CLIP_PLANE_COUNT; plane++) {
+		lines += clips_line_at_plane(plane, true);
+		lines += clips_line_at_plane(plane, false);
+	}
+	passed &= lines == 2 * CLIP_PLANE_COUNT;
+	// Both ends past the same plane, and a line through the camera to behind it
+	Vec4 right0 = { 2.0f, 0.0f, 0.0f, 1.0f };
+	Vec4 right1 = { 3.0f, 0.5f, 0.0f, 1.0f };
+	passed &= !clip_line(&right0, &right1);
+	Vec4 through0 = to_clip(view_projection, (Vec3){ 0.5f, 0.5f, 0.0f });
+	Vec4 through1 = to_clip(view_projection, (Vec3){ -0.5f, -0.5f, 20.0f });
+	passed &= clip_line(&through0, &through1) && in_view_volume(through0, near_plane) && in_view_volume(through1, near_plane);
+	
+	// Culling is conservative, it may keep spheres near a corner but never drops one
+	// in view, and always drops one entirely outside a plane
+	Frustum frustum = frustum_from_matrix(view_projection);
+	int kept = 0;
+	int culled = 0;
+	int wrong = 0;
+	for (int i = 0; i < CLIP_CASES; i++) {
+		Vec3 center = { random_range(&seed, -30.0f, 30.0f), random_range(&seed, -30.0f, 30.0f), random_range(&seed, -40.0f, 30.0f) };
+		float radius = random_range(&seed, 0.1f, 5.0f);
+		bool visible = sphere_in_frustum(&frustum, center, radius);
+		wrong += !visible && sphere_has_visible_point(view_projection, center, radius, near_plane);
+		wrong += visible && sphere_outside_plane(view_projection, center, radius);
+		kept += visible;
+		culled += !visible;
+	}
+	passed &= wrong == 0 && kept > 0 && culled > 0;
+	printf("%-6s clipping near plane %d vertices, behind camera %d, %d of %d random triangles left the volume, %d of %d lines, spheres %d kept %d culled %d wrong\n", passed ? "PASS" : "FAIL",
+		near_count, behind_count, outside, CLIP_CASES, lines, 2 * CLIP_PLANE_COUNT, kept, culled, wrong);
+	return passed;
+}
+
+static Transform random_placement(Uint32 *seed) {
+	Vec3 position = { random_range(seed, -40.0f, 40.0f), random_range(seed, -30.0f, 30.0f), random_range(seed, -60.0f, 10.0f) };
+	Vec3 rotation = { random_range(seed, 0.0f, 6.28f), random_range(seed, 0.0f, 6.28f), 0.0f };
+	return (Transform){ position, rotation, random_range(seed, 0.5f, 2.0f) };
+}
+
+// After instances move and the hierarchy is refit, not rebuilt, the graph has to
+// draw exactly the instances whose own box is in the view volume
+static bool test_scene_graph(RenderTarget *target, Arena *arena) {
+	Cube cube = create_cube((Vec3){ 0.0f, 0.0f, 0.0f }, 1.0f);
+	SceneGraph *graph = create_scene_graph(SCENE_INSTANCES);
+	if (!graph) {
+		printf("%-6s scene graph allocation error\n", "FAIL");
+		return false;
+	}
+	
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, target, arena);
+	Uint32 seed = 99u;
+	bool passed = true;
+	for (int i = 0; i < SCENE_INSTANCES; i++) {
+		passed &= scene_graph_add_cube(graph, &cube, random_placement(&seed), (ColorRgb){ 0, 200, 0, 255 }) == i;
+	}
+	
+	int mismatched = 0;
+	long drawn = 0;
+	long culled = 0;
+	for (int round = 0; round <= SCENE_ROUNDS && passed; round++) {
+		// The first round builds the hierarchy, the others refit it
+		if (round > 0) {
+			for (int i = 0; i < SCENE_MOVES; i++) {
+				passed &= scene_graph_set_transform(graph, (int)(next_random(&seed) % SCENE_INSTANCES), random_placement(&seed));
+			}
+			scene_graph_refit(graph);
+		}
+		arena_reset(arena);
+		passed &= scene_graph_draw(graph, &ctx);
+		for (int i = 0; i < SCENE_INSTANCES; i++) {
+			const SceneInstance *instance = &graph->instances[i];
+			int plane_mask = (1 << CLIP_PLANE_COUNT) - 1;
+			bool visible = box_in_frustum(&ctx.frustum, instance->bounds_min, instance->bounds_max, &plane_mask);
+			bool was_drawn = instance->drawn_in == graph->draw_count;
+			mismatched += visible != was_drawn;
+			drawn += was_drawn;
+			culled += !was_drawn;
+		}
+	}
+	// Both sets have to be non-empty for the comparison to mean anything
+	passed = passed && mismatched == 0 && drawn > 0 && culled > 0;
+	printf("%-6s scene graph %d refits, %ld drawn, %ld culled, %d differ from testing every instance\n", passed ? "PASS" : "FAIL", SCENE_ROUNDS, drawn, culled, mismatched);
+	destroy_scene_graph(&graph);
+	return passed;
+}
+
+// Pixels where two targets differ
+static long differing_pixels(const RenderTarget *a, const RenderTarget *b) {
+	long differences = 0;
+	for (int y = 0; y < a->height; y++) {
+		const Uint32 *row_a = a->pixels + y * (a->pitch / 4);
+		const Uint32 *row_b = b->pixels + y * (b->pitch / 4);
+		for (int x = 0; x < a->width; x++) {
+			differences += row_a[x] != row_b[x];
+		}
+	}
+	return differences;
+}
+
+// draw_mesh_instanced has to draw what a set_model_matrix and draw_mesh loop
+// does, also when the frame arena only holds a few instances per batch
+static bool test_instanced(RenderTarget *target, Arena *arena) {
+	Mesh *mesh = create_platonic_mesh(ICOSAHEDRON, (Vec3){ 0.0f, 0.0f, 0.0f }, 2.0f);
+	RenderTarget *expected = create_render_target(target->width, target->height);
+	Matrix4 *matrices = malloc(INSTANCES * sizeof(Matrix4));
+	ColorRgb *colors = malloc(INSTANCES * sizeof(ColorRgb));
+	if (!(mesh && expected && matrices && colors)) {
+		printf("%-6s instanced allocation error\n", "FAIL");
+		destroy_mesh(&mesh);
+		destroy_render_target(&expected);
+		free(matrices);
+		free(colors);
+		return false;
+	}
+	
+	Uint32 seed = 1234u;
+	for (int i = 0; i < INSTANCES; i++) {
+		matrices[i] = transform_matrix(random_placement(&seed));
+		colors[i] = (ColorRgb){ (Uint8)(next_random(&seed) >> 24), (Uint8)(next_random(&seed) >> 24), 200, 255 };
+	}
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, expected, arena);
+	clear_framebuffer(expected->pixels, expected->pitch, expected->width, expected->height, 0);
+	bool drawn = true;
+	for (int i = 0; i < INSTANCES; i++) {
+		arena_reset(arena);
+		set_model_matrix(&ctx, matrices[i]);
+		drawn &= draw_mesh(&ctx, mesh, colors[i]);
+	}
+	clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0);
+	long lit = differing_pixels(target, expected);
+	
+	// The shipping arena, then ones of a few instances, where batches shrink
+	size_t instance_bytes = (size_t)mesh->vertex_count * sizeof(ClipVertex);
+	long differences = 0;
+	for (int run = 0; run <= (int)(sizeof(SMALL_ARENA_INSTANCES) / sizeof(SMALL_ARENA_INSTANCES[0])); run++) {
+		// Without a bin arena half the frame arena is left for the bins
+		Arena *small_arena = run > 0 ? create_arena(2 * SMALL_ARENA_INSTANCES[run - 1] * instance_bytes + 64) : NULL;
+		ctx.frame_arena = run > 0 ? small_arena : arena;
+		ctx.target = target;
+		arena_reset(ctx.frame_arena);
+		clear_framebuffer(target->pixels, target->pitch, target->width, target->height, 0);
+		drawn &= ctx.frame_arena && draw_mesh_instanced(&ctx, mesh, matrices, colors, INSTANCES);
+		differences += differing_pixels(target, expected);
+		destroy_arena(&small_arena);
+	}
+	
+	bool passed = drawn && lit > 0 && differences == 0;
+	printf("%-6s instanced %d instances, %ld pixels, %ld differ from drawing each instance\n", passed ? "PASS" : "FAIL", INSTANCES, lit, differences);
+	destroy_mesh(&mesh);
+	destroy_render_target(&expected);
+	free(matrices);
+	free(colors);
+	return passed;
+}
+
+static bool write_text(const char *path, const char *text) {
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		return false;
+	}
+	bool written = fputs(text, file) >= 0;
+	return fclose(file) == 0 && written;
+}
+
+static bool write_binary(const char *path, const unsigned char *bytes, size_t size) {
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return false;
+	}
+	bool written = fwrite(bytes, 1, size, file) == size;
+	return fclose(file) == 0 && written;
+}
+
+// Appends the value's bytes in the given order, whatever the machine's is
+static size_t put_bytes(unsigned char *at, const void *value, int size, bool big_endian) {
+	uint32_t bits = 0;
+	memcpy(&bits, value, size);
+	for (int i = 0; i < size; i++) {
+		at[big_endian ? size - 1 - i : i] = (unsigned char)(bits >> (8 * i));
+	}
+	return size;
+}
+
+// Unit square in the z = 0 plane as one quad, so 4 vertices, 2 triangles and 5 edges
+static const float SQUARE[4][3] = { { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+
+// Binary PLY of the square, with an extra vertex property and face property to skip,
+// or with the first index replaced
+static size_t square_ply(unsigned char *bytes, bool big_endian, float first_index) {
+	char header[512];
+	snprintf(header, sizeof(header), "ply\nformat %s 1.0\ncomment test\nelement vertex 4\nproperty float x\nproperty float y\nproperty float z\nproperty uchar red\n"
+		"element face 1\nproperty uchar flags\nproperty list uchar float vertex_indices\nend_header\n", big_endian ? "binary_big_endian" : "binary_little_endian");
+	size_t size = strlen(header);
+	memcpy(bytes, header, size);
+	for (int v = 0; v < 4; v++) {
+		for (int axis = 0; axis < 3; axis++) {
+			size += put_bytes(bytes + size, &SQUARE[v][axis], 4, big_endian);
+		}
+		bytes[size++] = 255;
+	}
+	bytes[size++] = 7;
+	bytes[size++] = 4;
+	for (int c = 0; c < 4; c++) {
+		float index = c == 0 ? first_index : (float)c;
+		size += put_bytes(bytes + size, &index, 4, big_endian);
+	}
+	return size;
+}
+
+// Two triangles of the square, the shared corners written once as -0 and once as 0
+static size_t square_stl(unsigned char *bytes) {
+	memset(bytes, 0, 84);
+	uint32_t count = 2;
+	put_bytes(bytes + 80, &count, 4, false);
+	const float corners[2][3][3] = {
+		{ { 0.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 0.0f } },
+		{ { -0.0f, 0.0f, -0.0f }, { 1.0f, 1.0f, -0.0f }, { 0.0f, 1.0f, 0.0f } },
+	};
+	size_t size = 84;
+	for (int t = 0; t < 2; t++) {
+		float normal = 0.0f;
+		for (int i = 0; i < 3; i++) {
+			size += put_bytes(bytes + size, &normal, 4, false);
+		}
+		for (int c = 0; c < 3; c++) {
+			for (int axis = 0; axis < 3; axis++) {
+				size += put_bytes(bytes + size, &corners[t][c][axis], 4, false);
+			}
+		}
+		bytes[size++] = 0;
+		bytes[size++] = 0;
+	}
+	return size;
+}
+
+// Whether the file loads as the square, or fails to load when it should not
+static bool loads_square(const char *path, bool valid) {
+	Mesh *mesh = load_mesh(path);
+	remove(path);
+	bool loaded = mesh != NULL;
+	bool square = loaded && mesh->vertex_count == 4 && mesh->triangle_count == 2 && mesh->edge_count == 5;
+	for (int v = 0; square && v < 4; v++) {
+		// Welding may reorder the vertices, every one has to be a corner
+		bool corner = false;
+		for (int c = 0; c < 4; c++) {
+			corner |= mesh->x[v] == SQUARE[c][0] && mesh->y[v] == SQUARE[c][1] && mesh->z[v] == SQUARE[c][2];
+		}
+		square = corner;
+	}
+	destroy_mesh(&mesh);
+	bool passed = valid ? square : !loaded;
+	printf("%-6s loader %-28s %s\n", passed ? "PASS" : "FAIL", path, loaded ? (square ? "square" : "wrong mesh") : "rejected");
+	return passed;
+}
+
+static bool test_loaders(void) {
+	unsigned char bytes[1024];
+	bool passed = true;
+	
+	// Negative indices, texture and normal references, comments
+	passed &= write_text("test_square.obj", "# square\nv 0 0 0\nv 1 0 0\nvt 0 0\nv 1 1 0\nv 0 1 0\nf 1/1 2/1 3/1 # fan\nf -4//1 -2//1 -1//1\n") && loads_square("test_square.obj", true);
+	passed &= write_text("test_range.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 4\n") && loads_square("test_range.obj", false);
+	passed &= write_text("test_huge.obj", "v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 1e300\n") && loads_square("test_huge.obj", false);
+	
+	passed &= write_text("test_ascii.ply", "ply\nformat ascii 1.0\nelement vertex 4\nproperty float x\nproperty float y\nproperty float z\n"
+		"element face 1\nproperty list uchar int vertex_indices\nend_header\n0 0 0\n1 0 0\n1 1 0\n0 1 0\n4 0 1 2 3\n") && loads_square("test_ascii.ply", true);
+	// A second vertex element larger than the one the mesh would be sized from
+	passed &= write_text("test_duplicate.ply", "ply\nformat ascii 1.0\nelement vertex 40\nproperty float x\nproperty float y\nproperty float z\n"
+		"element vertex 3\nproperty float x\nproperty float y\nproperty float z\nelement face 1\nproperty list uchar int vertex_indices\nend_header\n") && loads_square("test_duplicate.ply", false);
+	passed &= write_binary("test_little.ply", bytes, square_ply(bytes, false, 0.0f)) && loads_square("test_little.ply", true);
+	passed &= write_binary("test_big.ply", bytes, square_ply(bytes, true, 0.0f)) && loads_square("test_big.ply", true);
+	passed &= write_binary("test_nan.ply", bytes, square_ply(bytes, false, NAN)) && loads_square("test_nan.ply", false);
+	
+	passed &= write_binary("test_square.stl", bytes, square_stl(bytes)) && loads_square("test_square.stl", true);
+	passed &= write_binary("test_truncated.stl", bytes, square_stl(bytes) - 1) && loads_square("test_truncated.stl", false);
+	return passed;
+}
+
+// Saves the mesh with one index changed and maps it back, which has to fail
+// unless the index is still a vertex
+static bool cache_maps(const Mesh *mesh, int triangle, int edge, int index) {
+	const char *cache_path = "test_mesh.cache";
+	Mesh *changed = copy_mesh(mesh);
+	if (!changed) {
+		return false;
+	}
+	if (triangle >= 0) {
+		changed->triangles[triangle][1] = index;
+	}
+	if (edge >= 0) {
+		changed->edges[edge][0] = index;
+	}
+	MappedMesh *mapped = save_mesh_cache(changed, NULL, cache_path) ? map_mesh_cache(cache_path) : NULL;
+	bool maps = mapped != NULL;
+	unmap_mesh_cache(&mapped);
+	remove(cache_path);
+	destroy_mesh(&changed);
+	return maps;
+}
+
+static bool test_mesh_cache(void) {
+	Mesh *mesh = create_platonic_mesh(ICOSAHEDRON, (Vec3){ 0.0f, 0.0f, 0.0f }, 1.0f);
+	if (!mesh) {
+		printf("%-6s mesh cache allocation error\n", "FAIL");
+		return false;
+	}
+	
+	int last = mesh->vertex_count - 1;
+	bool passed = cache_maps(mesh, -1, -1, 0) && cache_maps(mesh, 3, 4, last);
+	int rejected = 0;
+	rejected += !cache_maps(mesh, 3, -1, mesh->vertex_count);
+	rejected += !cache_maps(mesh, 3, -1, -1);
+	rejected += !cache_maps(mesh, -1, 4, mesh->vertex_count);
+	rejected += !cache_maps(mesh, -1, 4, -1);
+	passed = passed && rejected == 4;
+	printf("%-6s mesh cache %d of 4 out of range indices rejected\n", passed ? "PASS" : "FAIL", rejected);
+	destroy_mesh(&mesh);
+	return passed;
+}
+
+static bool set_modified_time(const char *path, time_t time) {
+	struct utimbuf times = { time, time };
+	return utime(path, &times) == 0;
+}
+
+// Times are set explicitly, so the result does not depend on the clock's resolution
+static bool test_cache_fresh(void) {
+	const char *source_path = "test_fresh.obj";
+	const char *cache_path = "test_fresh.obj.cache";
+	time_t now = time(NULL);
+	bool ready = write_text(source_path, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n") && set_modified_time(source_path, now - 10);
+	Mesh *mesh = ready ? load_mesh(source_path) : NULL;
+	ready = mesh && save_mesh_cache(mesh, source_path, cache_path) && set_modified_time(cache_path, now);
+	destroy_mesh(&mesh);
+	
+	// Written after the source
+	bool fresh = ready && mesh_cache_fresh(source_path, cache_path);
+	// Changed in the same tick the cache was written
+	bool same_time = set_modified_time(source_path, now) && mesh_cache_fresh(source_path, cache_path);
+	// Replaced by a different file that is older than the cache
+	bool replaced = write_text(source_path, "v 0 0 0\nv 10 0 0\nv 0 10 0\nf 1 2 3\n") && set_modified_time(source_path, now - 5) && mesh_cache_fresh(source_path, cache_path);
+	bool passed = fresh && !same_time && !replaced;
+	printf("%-6s cache freshness: written after %s, same time %s, replaced %s\n", passed ? "PASS" : "FAIL", fresh ? "fresh" : "stale", same_time ? "fresh" : "stale", replaced ? "fresh" : "stale");
+	
+	remove(source_path);
+	remove(cache_path);
+	return passed;
+}
+
+// Unit sphere of rings bands of segments quads, with one vertex at each pole
+static bool write_sphere_obj(const char *path, int rings, int segments) {
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		return false;
+	}
+	
+	bool result = fprintf(file, "v 0 1 0\nv 0 -1 0\n") > 0;
+	for (int r = 1; r < rings && result; r++) {
+		float theta = 3.14159265f * r / rings;
+		for (int s = 0; s < segments && result; s++) {
+			float phi = 6.2831853f * s / segments;
+			result = fprintf(file, "v %f %f %f\n", sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi)) > 0;
+		}
+	}
+	// OBJ indices start at 1, band r starts at 3 + (r - 1) * segments
+	for (int s = 0; s < segments && result; s++) {
+		int next = (s + 1) % segments;
+		int top = 3;
+		int bottom = 3 + (rings - 2) * segments;
+		result = fprintf(file, "f 1 %d %d\nf 2 %d %d\n", top + next, top + s, bottom + s, bottom + next) > 0;
+	}
+	for (int r = 1; r < rings - 1 && result; r++) {
+		int band = 3 + (r - 1) * segments;
+		for (int s = 0; s < segments && result; s++) {
+			int next = (s + 1) % segments;
+			result = fprintf(file, "f %d %d %d\nf %d %d %d\n", band + s, band + next, band + segments + next, band + s, band + segments + next, band + segments + s) > 0;
+		}
+	}
+	return fclose(file) == 0 && result;
+}
+
+// Same levels back from the cache, every array equal to the one saved
+static bool levels_equal(const Mesh *a, const Mesh *b) {
+	return a->vertex_count == b->vertex_count && a->triangle_count == b->triangle_count && a->edge_count == b->edge_count
+		&& memcmp(a->x, b->x, a->vertex_count * sizeof(float)) == 0
+		&& memcmp(a->y, b->y, a->vertex_count * sizeof(float)) == 0
+		&& memcmp(a->z, b->z, a->vertex_count * sizeof(float)) == 0
+		&& memcmp(a->triangles, b->triangles, a->triangle_count * sizeof(int[3])) == 0
+		&& memcmp(a->edges, b->edges, a->edge_count * sizeof(int[2])) == 0
+		&& a->bounds_radius == b->bounds_radius;
+}
+
+static bool test_lod_cache(void) {
+	const char *model_path = "test_lod.obj";
+	const char *cache_path = "test_lod.obj.cache";
+	Mesh *mesh = write_sphere_obj(model_path, 16, 32) ? load_obj(model_path) : NULL;
+	MeshLod *lod = mesh ? create_mesh_lod(mesh, 4) : NULL;
+	MappedMesh *mapped = lod && save_mesh_lod_cache(lod, model_path, cache_path) ? map_mesh_cache(cache_path) : NULL;
+	bool passed = mapped && lod->level_count > 1 && mapped->lod.level_count == lod->level_count;
+	for (int i = 0; passed && i < lod->level_count; i++) {
+		passed = levels_equal(lod->levels[i], mapped->lod.levels[i]);
+	}
+	printf("%-6s mesh cache %d detail levels mapped back\n", passed ? "PASS" : "FAIL", mapped ? mapped->lod.level_count : 0);
+	
+	unmap_mesh_cache(&mapped);
+	destroy_mesh_lod(&lod);
+	destroy_mesh(&mesh);
+	remove(model_path);
+	remove(cache_path);
+	return passed;
+}
+
+// One headless frame of the model, false when cube failed or reported an error
+static bool render_model(const char *cube_path, const char *model_path, const char *dump_prefix, int arena_megabytes, bool full_detail) {
+	char command[1024];
+	char arena_option[32] = "";
+	if (arena_megabytes) {
+		snprintf(arena_option, sizeof(arena_option), " --arena %d", arena_megabytes);
+	}
+	snprintf(command, sizeof(command), "%s --headless --frames 1 --model %s --dump %s%s%s", cube_path, model_path, dump_prefix, arena_option, full_detail ? " --full-detail" : "");
+	FILE *output = popen(command, "r");
+	if (!output) {
+		return false;
+	}
+	
+	bool result = true;
+	char line[256];
+	while (fgets(line, sizeof(line), output)) {
+		if (strncmp(line, "Error", 5) == 0) {
+			printf("       %s", line);
+			result = false;
+		}
+	}
+	return pclose(output) == 0 && result;
+}
+
+// Pixels of a binary PPM that are not black, or -1 when it can't be read
+static long lit_pixels(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (!file) {
+		return -1;
+	}
+	
+	int width, height, max_value;
+	long lit = -1;
+	if (fscanf(file, "P6 %d %d %d", &width, &height, &max_value) == 3 && fgetc(file) != EOF) {
+		lit = 0;
+		unsigned char rgb[3];
+		for (long i = 0; i < (long)width * height; i++) {
+			if (fread(rgb, 1, 3, file) != 3) {
+				lit = -1;
+				break;
+			}
+			lit += rgb[0] || rgb[1] || rgb[2];
+		}
+	}
+	fclose(file);
+	return lit;
+}
+
+// At full detail the shipping arenas flush their bins partway through the model,
+// the result has to light the same pixels as a run that bins it all at once.
+// The first run builds the detail levels and caches them, the others map them
+static bool test_model(const char *cube_path) {
+	const char *model_path = "test_model.obj";
+	const char *cache_path = "test_model.obj.cache";
+	const char *lod_frame = "test_model_lod_0000.ppm";
+	const char *shipping_frame = "test_model_shipping_0000.ppm";
+	const char *reference_frame = "test_model_reference_0000.ppm";
+	if (!write_sphere_obj(model_path, MODEL_RINGS, MODEL_SEGMENTS)) {
+		printf("%-6s model could not write %s\n", "FAIL", model_path);
+		return false;
+	}
+	
+	bool rendered = render_model(cube_path, model_path, "test_model_lod", 0, false);
+	MappedMesh *mapped = map_mesh_cache(cache_path);
+	int level_count = mapped ? mapped->lod.level_count : 0;
+	unmap_mesh_cache(&mapped);
+	rendered &= render_model(cube_path, model_path, "test_model_shipping", 0, true);
+	rendered &= render_model(cube_path, model_path, "test_model_reference", REFERENCE_ARENA_MEGABYTES, true);
+	long lod = lit_pixels(lod_frame);
+	long shipping = lit_pixels(shipping_frame);
+	long reference = lit_pixels(reference_frame);
+	bool passed = rendered && level_count > 1 && lod > 0 && shipping > 0 && shipping == reference;
+	printf("%-6s model %d triangles, %ld pixels, %ld with %d MB arenas, %ld from %d cached levels\n", passed ? "PASS" : "FAIL", 2 * MODEL_SEGMENTS * (MODEL_RINGS - 1), shipping, reference, REFERENCE_ARENA_MEGABYTES, lod, level_count);
+	
+	remove(model_path);
+	remove(cache_path);
+	remove(lod_frame);
+	remove(shipping_frame);
+	remove(reference_frame);
+	return passed;
+}
+
+// ### MAIN FUNCTION ### //
+// Given the path of the cube binary, also checks a large model drawn through it
+int main(int argc, char *argv[]) {
+	RenderTarget *target = create_render_target(TEST_WIDTH, TEST_HEIGHT);
+	Arena *arena = create_arena(TEST_ARENA_SIZE);
+	Uint32 *buffer = malloc((size_t)TEST_WIDTH * TEST_HEIGHT * sizeof(Uint32));
+	Triangle *triangles = malloc(RANDOM_TRIANGLES * sizeof(Triangle));
+	if (!(target && arena && buffer && triangles)) {
+		printf("Test allocation error\n");
+		return 1;
+	}
+	
+	// Maps world (x, y) straight to viewport pixels, so get_triangle_points sees
+	// the same triangles as rasterize_triangle
+	Camera cam = { { 0.0f, 0.0f, 12.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, DEFAULT_FIELD_OF_VIEW, DEFAULT_NEAR_PLANE, DEFAULT_FAR_PLANE };
+	RenderContext ctx;
+	init_render_context(&ctx, &cam, target, arena);
+	ctx.view_projection_matrix = (Matrix4){ .m = {
+			{2.0f / TEST_WIDTH, 0.0f, 0.0f, -1.0f},
+			{0.0f, -2.0f / TEST_HEIGHT, 0.0f, 1.0f},
+			{0.0f, 0.0f, 1.0f, 0.0f},
+			{0.0f, 0.0f, 0.0f, 1.0f}
+		},
+	};
+	set_model_matrix(&ctx, scale_transformation(1.0f));
+	
+	bool passed = true;
+	Uint32 seed = 2024u;
+	
+	// Anywhere on the target, of any size up to the target
+	for (int i = 0; i < RANDOM_TRIANGLES; i++) {
+		for (int k = 0; k < 3; k++) {
+			triangles[i].vertices[k] = random_vertex(&seed, 0.0f, TEST_WIDTH, 0.0f, TEST_HEIGHT);
+		}
+	}
+	passed &= test_coverage(&ctx, buffer, "random", triangles, RANDOM_TRIANGLES);
+	
+	// Small ones, a few pixels across, where rounding matters most
+	for (int i = 0; i < RANDOM_TRIANGLES; i++) {
+		Vec3 center = random_vertex(&seed, 4.0f, TEST_WIDTH - 4.0f, 4.0f, TEST_HEIGHT - 4.0f);
+		for (int k = 0; k < 3; k++) {
+			triangles[i].vertices[k] = random_vertex(&seed, center.x - 3.0f, center.x + 3.0f, center.y - 3.0f, center.y + 3.0f);
+		}
+	}
+	passed &= test_coverage(&ctx, buffer, "small", triangles, RANDOM_TRIANGLES);
+	
+	// Slivers, long and under a pixel wide, at every angle
+	for (int i = 0; i < RANDOM_TRIANGLES; i++) {
+		Vec3 a = random_vertex(&seed, 0.0f, TEST_WIDTH, 0.0f, TEST_HEIGHT);
+		Vec3 b = random_vertex(&seed, 0.0f, TEST_WIDTH, 0.0f, TEST_HEIGHT);
+		float offset = random_range(&seed, 0.0625f, 0.75f);
+		triangles[i].vertices[0] = a;
+		triangles[i].vertices[1] = b;
+		triangles[i].vertices[2] = (Vec3){ snap(b.x + offset), snap(b.y - offset), 0.0f };
+	}
+	passed &= test_coverage(&ctx, buffer, "sliver", triangles, RANDOM_TRIANGLES);
+	
+	// Reaching off every side of the target; only what is on it is compared
+	for (int i = 0; i < RANDOM_TRIANGLES; i++) {
+		for (int k = 0; k < 3; k++) {
+			triangles[i].vertices[k] = random_vertex(&seed, -TEST_WIDTH, 2.0f * TEST_WIDTH, -TEST_HEIGHT, 2.0f * TEST_HEIGHT);
+		}
+	}
+	passed &= test_coverage(&ctx, buffer, "off-screen", triangles, RANDOM_TRIANGLES);
+	
+	// Axis aligned edges on pixel samples, all decided by the top-left rule
+	for (int i = 0; i < RANDOM_TRIANGLES; i++) {
+		float x = floorf(random_range(&seed, 0.0f, TEST_WIDTH - 40.0f));
+		float y = floorf(random_range(&seed, 0.0f, TEST_HEIGHT - 40.0f));
+		float size = floorf(random_range(&seed, 1.0f, 40.0f));
+		bool flip = next_random(&seed) & 0x100;
+		triangles[i].vertices[0] = (Vec3){ x, y, 0.0f };
+		triangles[i].vertices[1] = (Vec3){ x + size, flip ? y + size : y, 0.0f };
+		triangles[i].vertices[2] = (Vec3){ flip ? x : x + size, y + size, 0.0f };
+	}
+	passed &= test_coverage(&ctx, buffer, "axis-aligned", triangles, RANDOM_TRIANGLES);
+	
+	passed &= test_kernels(buffer, TEST_WIDTH, TEST_HEIGHT, triangles, RANDOM_TRIANGLES);
+	passed &= test_linalg_kernels();
+	passed &= test_shared_edges(buffer, TEST_WIDTH, TEST_HEIGHT, seed);
+	passed &= test_degenerate(buffer, TEST_WIDTH, TEST_HEIGHT);
+	passed &= test_clipping(target);
+	passed &= test_scene_graph(target, arena);
+	passed &= test_instanced(target, arena);
+	passed &= test_loaders();
+	passed &= test_mesh_cache();
+	passed &= test_cache_fresh();
+	passed &= test_lod_cache();
+	if (argc > 1) {
+		passed &= test_model(argv[1]);
+	}
+	
+	free(triangles);
+	free(buffer);
+	destroy_arena(&arena);
+	destroy_render_target(&target);
+	printf("%s\n", passed ? "All tests passed" : "Some tests failed");
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,472 @@
+#include <SDL2/SDL.h>
+#include <math.h>
+#include "tiler.h"
+
+// ### CONSTANT DEFINITIONS ### //
+// Primitive references per bin block
+#define TILE_BLOCK_SIZE 62
+
+// ### STRUCTS ### //
+typedef enum {
+	TILE_PRIMITIVE_TRIANGLE,
+	TILE_PRIMITIVE_LINE,
+} TilePrimitiveType;
+
+typedef struct {
+	TilePrimitiveType type;
+	Uint32 color;
+	RenderTarget *target;
+	DepthBuffer *depth_buffer;
+	ScreenRect scissor;
+	union {
+		TriangleSetup triangle;
+		struct {
+			IVec2 p0;
+			IVec2 p1;
+			float z0;
+			float z1;
+		} line;
+	};
+} TilePrimitive;
+
+// Bins are singly linked lists of fixed-size blocks from the frame arena
+typedef struct TileBlock {
+	struct TileBlock *next;
+	int count;
+	TilePrimitive *primitives[TILE_BLOCK_SIZE];
+} TileBlock;
+
+typedef struct {
+	TileBlock *head;
+	TileBlock *tail;
+} TileBin;
+
+// Range of the active tile list a worker starts with; other workers steal from
+// it by claiming indices with the same atomic counter
+typedef struct {
+	SDL_atomic_t next;
+	int end;
+	// Pixels written by the queue's own thread, whichever queues it took tiles from
+	long pixels_written;
+	// Posted once per flush for the queue's worker thread; one per worker, so a
+	// fast worker can never take another's start and run twice in one flush
+	SDL_sem *start;
+	// Keeps each queue's counter on its own cache line
+	char padding[64 - sizeof(SDL_atomic_t) - sizeof(int) - sizeof(long) - sizeof(SDL_sem*)];
+} TileQueue;
+
+// The tile grid covers the largest target binned so far; primitives of smaller
+// targets only use its top left, and a tile holds those of every target
+struct TileRenderer {
+	int tiles_x;
+	int tiles_y;
+	TileBin *bins;
+	// Indices of the tiles with a non-empty bin, in the order they were first used
+	int *active_tiles;
+	int active_count;
+	
+	// Worker pool, queue 0 belongs to the thread calling tile_renderer_flush
+	int thread_count;
+	SDL_Thread **threads;
+	TileQueue *queues;
+	SDL_sem *done;
+	SDL_atomic_t quit;
+	// Total of the queues over the last flush
+	long pixels_written;
+};
+
+typedef struct {
+	TileRenderer *tile_renderer;
+	int queue_index;
+} TileWorker;
+
+// ### FUNCTION DEFINITIONS ### //
+
+// ## RASTERIZATION ## //
+// Returns the number of pixels written
+static long rasterize_tile(TileRenderer *tile_renderer, int tile) {
+	ScreenRect tile_rect;
+	tile_rect.min_x = (tile % tile_renderer->tiles_x) * TILE_SIZE;
+	tile_rect.min_y = (tile / tile_renderer->tiles_x) * TILE_SIZE;
+	// Scissors are already clipped to their target, which clips the tile to it
+	tile_rect.max_x = tile_rect.min_x + TILE_SIZE;
+	tile_rect.max_y = tile_rect.min_y + TILE_SIZE;
+	
+	long written = 0;
+	for (TileBlock *block = tile_renderer->bins[tile].head; block; block = block->next) {
+		for (int i = 0; i < block->count; i++) {
+			TilePrimitive *primitive = block->primitives[i];
+			ScreenRect rect = screen_rect_intersection(tile_rect, primitive->scissor);
+			int min_x = rect.min_x;
+			int min_y = rect.min_y;
+			int max_x = rect.max_x;
+			int max_y = rect.max_y;
+			switch (primitive->type) {
+				case TILE_PRIMITIVE_TRIANGLE:
+					if (primitive->depth_buffer) {
+						written += rasterize_triangle_depth(primitive->target->pixels, primitive->target->pitch, primitive->depth_buffer, &primitive->triangle, primitive->color, min_x, min_y, max_x, max_y);
+					} else {
+						written += rasterize_triangle(primitive->target->pixels, primitive->target->pitch, &primitive->triangle, primitive->color, min_x, min_y, max_x, max_y);
+					}
+					break;
+				case TILE_PRIMITIVE_LINE:
+					if (primitive->depth_buffer) {
+						written += rasterize_line_depth(primitive->target->pixels, primitive->target->pitch, primitive->depth_buffer, primitive->line.p0, primitive->line.p1, primitive->line.z0, primitive->line.z1, primitive->color, min_x, min_y, max_x, max_y);
+					} else {
+						written += rasterize_line(primitive->target->pixels, primitive->target->pitch, primitive->line.p0, primitive->line.p1, primitive->color, min_x, min_y, max_x, max_y);
+					}
+					break;
+			}
+		}
+	}
+	return written;
+}
+
+// Drains the thread's own queue, then steals from the others
+static void process_tiles(TileRenderer *tile_renderer, int queue_index) {
+	long written = 0;
+	for (int k = 0; k < tile_renderer->thread_count; k++) {
+		TileQueue *queue = &tile_renderer->queues[(queue_index + k) % tile_renderer->thread_count];
+		int i;
+		while ((i = SDL_AtomicAdd(&queue->next, 1)) < queue->end) {
+			written += rasterize_tile(tile_renderer, tile_renderer->active_tiles[i]);
+		}
+	}
+	tile_renderer->queues[queue_index].pixels_written = written;
+}
+
+static int tile_worker_main(void *data) {
+	TileWorker *worker = data;
+	TileRenderer *tile_renderer = worker->tile_renderer;
+	int queue_index = worker->queue_index;
+	SDL_sem *start = tile_renderer->queues[queue_index].start;
+	free(worker);
+	
+	while (true) {
+		SDL_SemWait(start);
+		if (SDL_AtomicGet(&tile_renderer->quit)) {
+			return 0;
+		}
+		process_tiles(tile_renderer, queue_index);
+		SDL_SemPost(tile_renderer->done);
+	}
+}
+
+// # CREATE AND DESTROY FUNCTIONS # //
+TileRenderer *create_tile_renderer(int thread_count) {
+	if (thread_count <= 0) {
+		thread_count = SDL_GetCPUCount();
+	}
+	if (thread_count <= 0) {
+		thread_count = 1;
+	}
+	
+	TileRenderer *tile_renderer = calloc(1, sizeof(TileRenderer));
+	if (!tile_renderer) {
+		return NULL;
+	}
+	
+	// Before any worker exists, so workers only ever read the kernel
+	init_raster_kernel();
+	
+	// The tile grid is allocated by the first binned primitive
+	tile_renderer->queues = calloc(thread_count, sizeof(TileQueue));
+	tile_renderer->threads = calloc(thread_count, sizeof(SDL_Thread*));
+	tile_renderer->done = SDL_CreateSemaphore(0);
+	if (!(tile_renderer->queues && tile_renderer->threads && tile_renderer->done)) {
+		destroy_tile_renderer(&tile_renderer);
+		return NULL;
+	}
+	
+	// The calling thread is worker 0
+	tile_renderer->thread_count = 1;
+	for (int i = 1; i < thread_count; i++) {
+		TileWorker *worker = malloc(sizeof(TileWorker));
+		if (!worker) {
+			break;
+		}
+		worker->tile_renderer = tile_renderer;
+		worker->queue_index = i;
+		tile_renderer->queues[i].start = SDL_CreateSemaphore(0);
+		if (!tile_renderer->queues[i].start) {
+			free(worker);
+			break;
+		}
+		tile_renderer->threads[i] = SDL_CreateThread(tile_worker_main, "tile_worker", worker);
+		if (!tile_renderer->threads[i]) {
+			SDL_DestroySemaphore(tile_renderer->queues[i].start);
+			tile_renderer->queues[i].start = NULL;
+			free(worker);
+			break;
+		}
+		tile_renderer->thread_count++;
+	}
+	
+	return tile_renderer;
+}
+
+void destroy_tile_renderer(TileRenderer **tile_renderer) {
+	if ((!tile_renderer) || (!(*tile_renderer))) {
+		return;
+	}
+	
+	TileRenderer *tr = *tile_renderer;
+	if (tr->threads) {
+		SDL_AtomicSet(&tr->quit, 1);
+		for (int i = 1; i < tr->thread_count; i++) {
+			SDL_SemPost(tr->queues[i].start);
+		}
+		for (int i = 1; i < tr->thread_count; i++) {
+			SDL_WaitThread(tr->threads[i], NULL);
+		}
+	}
+	
+	// SDL_DestroySemaphore accepts NULL
+	for (int i = 1; tr->queues && i < tr->thread_count; i++) {
+		SDL_DestroySemaphore(tr->queues[i].start);
+	}
+	SDL_DestroySemaphore(tr->done);
+	free(tr->threads);
+	free(tr->queues);
+	free(tr->active_tiles);
+	free(tr->bins);
+	free(tr);
+	*tile_renderer = NULL;
+}
+
+int tile_renderer_thread_count(TileRenderer *tile_renderer) {
+	return tile_renderer ? tile_renderer->thread_count : 0;
+}
+
+long tile_renderer_pixels_written(TileRenderer *tile_renderer) {
+	return tile_renderer ? tile_renderer->pixels_written : 0;
+}
+
+// ## BINNING ## //
+// Grows the grid to cover a width x height target, moving the filled bins to
+// the new row length
+static bool reserve_tiles(TileRenderer *tile_renderer, int width, int height) {
+	int tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+	if (tiles_x <= tile_renderer->tiles_x && tiles_y <= tile_renderer->tiles_y) {
+		return true;
+	}
+	if (tiles_x < tile_renderer->tiles_x) tiles_x = tile_renderer->tiles_x;
+	if (tiles_y < tile_renderer->tiles_y) tiles_y = tile_renderer->tiles_y;
+	
+	TileBin *bins = calloc(tiles_x * tiles_y, sizeof(TileBin));
+	int *active_tiles = malloc(tiles_x * tiles_y * sizeof(int));
+	if (!(bins && active_tiles)) {
+		free(bins);
+		free(active_tiles);
+		return false;
+	}
+	
+	for (int i = 0; i < tile_renderer->active_count; i++) {
+		int tile = tile_renderer->active_tiles[i];
+		int moved = (tile / tile_renderer->tiles_x) * tiles_x + tile % tile_renderer->tiles_x;
+		bins[moved] = tile_renderer->bins[tile];
+		active_tiles[i] = moved;
+	}
+	free(tile_renderer->bins);
+	free(tile_renderer->active_tiles);
+	tile_renderer->bins = bins;
+	tile_renderer->active_tiles = active_tiles;
+	tile_renderer->tiles_x = tiles_x;
+	tile_renderer->tiles_y = tiles_y;
+	return true;
+}
+
+static bool bin_primitive(TileRenderer *tile_renderer, Arena *arena, int tile, TilePrimitive *primitive) {
+	TileBin *bin = &tile_renderer->bins[tile];
+	if ((!bin->tail) || bin->tail->count == TILE_BLOCK_SIZE) {
+		TileBlock *block = arena_alloc(arena, sizeof(TileBlock));
+		if (!block) {
+			return false;
+		}
+		block->next = NULL;
+		block->count = 0;
+		
+		if (bin->tail) {
+			bin->tail->next = block;
+		} else {
+			bin->head = block;
+			tile_renderer->active_tiles[tile_renderer->active_count++] = tile;
+		}
+		bin->tail = block;
+	}
+	
+	bin->tail->primitives[bin->tail->count++] = primitive;
+	return true;
+}
+
+// Takes the primitive back out of every bin it was added to, after the arena
+// ran out partway through its tiles. It is the last entry of each of those bins;
+// blocks allocated for it stay linked and are reused by the next primitive
+static void unbin_primitive(TileRenderer *tile_renderer, TilePrimitive *primitive) {
+	for (int i = 0; i < tile_renderer->active_count; i++) {
+		TileBlock *tail = tile_renderer->bins[tile_renderer->active_tiles[i]].tail;
+		if (tail->count > 0 && tail->primitives[tail->count - 1] == primitive) {
+			tail->count--;
+		}
+	}
+}
+
+// Largest value of the edge function over the tile's pixels, at the corner
+// the edge's gradient points to
+static inline Sint64 tile_edge_max(const TriangleSetup *setup, int i, int min_x, int min_y, int max_x, int max_y) {
+	int x = setup->edge_a[i] > 0 ? max_x : min_x;
+	int y = setup->edge_b[i] > 0 ? max_y : min_y;
+	return setup->edge_a[i] * x + setup->edge_b[i] * y + setup->edge_c[i];
+}
+
+bool tile_renderer_add_triangle(TileRenderer *tile_renderer, Arena *arena, RenderTarget *target, DepthBuffer *depth_buffer, ScreenRect scissor, const TriangleSetup *setup, Uint32 color) {
+	if ((!tile_renderer) || (!target) || (!setup)) {
+		return false;
+	}
+	if (!reserve_tiles(tile_renderer, target->width, target->height)) {
+		return false;
+	}
+	
+	scissor = screen_rect_intersection(scissor, (ScreenRect){ 0, 0, target->width, target->height });
+	int min_x = setup->min_x > scissor.min_x ? setup->min_x : scissor.min_x;
+	int min_y = setup->min_y > scissor.min_y ? setup->min_y : scissor.min_y;
+	int max_x = setup->max_x < scissor.max_x - 1 ? setup->max_x : scissor.max_x - 1;
+	int max_y = setup->max_y < scissor.max_y - 1 ? setup->max_y : scissor.max_y - 1;
+	if (min_x > max_x || min_y > max_y) {
+		return true;
+	}
+	
+	TilePrimitive *primitive = arena_alloc(arena, sizeof(TilePrimitive));
+	if (!primitive) {
+		return false;
+	}
+	primitive->type = TILE_PRIMITIVE_TRIANGLE;
+	primitive->color = color;
+	primitive->target = target;
+	primitive->depth_buffer = depth_buffer;
+	primitive->scissor = scissor;
+	primitive->triangle = *setup;
+	
+	for (int ty = min_y / TILE_SIZE; ty <= max_y / TILE_SIZE; ty++) {
+		for (int tx = min_x / TILE_SIZE; tx <= max_x / TILE_SIZE; tx++) {
+			int tile_min_x = tx * TILE_SIZE;
+			int tile_min_y = ty * TILE_SIZE;
+			int tile_max_x = tile_min_x + TILE_SIZE - 1;
+			int tile_max_y = tile_min_y + TILE_SIZE - 1;
+			// Skip tiles entirely outside one of the edges
+			if (tile_edge_max(setup, 0, tile_min_x, tile_min_y, tile_max_x, tile_max_y) < 0 ||
+			    tile_edge_max(setup, 1, tile_min_x, tile_min_y, tile_max_x, tile_max_y) < 0 ||
+			    tile_edge_max(setup, 2, tile_min_x, tile_min_y, tile_max_x, tile_max_y) < 0) {
+				continue;
+			}
+			if (!bin_primitive(tile_renderer, arena, ty * tile_renderer->tiles_x + tx, primitive)) {
+				unbin_primitive(tile_renderer, primitive);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool tile_renderer_add_line(TileRenderer *tile_renderer, Arena *arena, RenderTarget *target, DepthBuffer *depth_buffer, ScreenRect scissor, IVec2 p0, IVec2 p1, float z0, float z1, Uint32 color) {
+	if ((!tile_renderer) || (!target)) {
+		return false;
+	}
+	if (!reserve_tiles(tile_renderer, target->width, target->height)) {
+		return false;
+	}
+	
+	scissor = screen_rect_intersection(scissor, (ScreenRect){ 0, 0, target->width, target->height });
+	if (screen_rect_empty(scissor)) {
+		return true;
+	}
+	
+	TilePrimitive *primitive = arena_alloc(arena, sizeof(TilePrimitive));
+	if (!primitive) {
+		return false;
+	}
+	primitive->type = TILE_PRIMITIVE_LINE;
+	primitive->color = color;
+	primitive->target = target;
+	primitive->depth_buffer = depth_buffer;
+	primitive->scissor = scissor;
+	primitive->line.p0 = p0;
+	primitive->line.p1 = p1;
+	primitive->line.z0 = z0;
+	primitive->line.z1 = z1;
+	
+	// Walk the line one tile-wide slab at a time along its major axis, binning the
+	// tiles covered by the minor-axis extent of the slab (one pixel of slack for rounding)
+	bool x_major = abs(p1.x - p0.x) >= abs(p1.y - p0.y);
+	int major0 = x_major ? p0.x : p0.y;
+	int major1 = x_major ? p1.x : p1.y;
+	int minor0 = x_major ? p0.y : p0.x;
+	int minor1 = x_major ? p1.y : p1.x;
+	int major_min = x_major ? scissor.min_x : scissor.min_y;
+	int major_max = x_major ? scissor.max_x : scissor.max_y;
+	int minor_lower = x_major ? scissor.min_y : scissor.min_x;
+	int minor_upper = x_major ? scissor.max_y : scissor.max_x;
+	
+	int major_start = major0 < major1 ? major0 : major1;
+	int major_end = major0 < major1 ? major1 : major0;
+	if (major_start < major_min) major_start = major_min;
+	if (major_end > major_max - 1) major_end = major_max - 1;
+	float slope = major1 != major0 ? (float)(minor1 - minor0) / (float)(major1 - major0) : 0.0f;
+	
+	for (int slab = major_start / TILE_SIZE; slab <= major_end / TILE_SIZE && major_start <= major_end; slab++) {
+		int slab_start = slab * TILE_SIZE > major_start ? slab * TILE_SIZE : major_start;
+		int slab_end = slab * TILE_SIZE + TILE_SIZE - 1 < major_end ? slab * TILE_SIZE + TILE_SIZE - 1 : major_end;
+		float minor_a = minor0 + slope * (slab_start - major0);
+		float minor_b = minor0 + slope * (slab_end - major0);
+		int minor_min = (int)floorf(fminf(minor_a, minor_b)) - 1;
+		int minor_max = (int)ceilf(fmaxf(minor_a, minor_b)) + 1;
+		if (minor_min < minor_lower) minor_min = minor_lower;
+		if (minor_max > minor_upper - 1) minor_max = minor_upper - 1;
+		
+		for (int k = minor_min / TILE_SIZE; k <= minor_max / TILE_SIZE && minor_min <= minor_max; k++) {
+			int tile = x_major ? k * tile_renderer->tiles_x + slab : slab * tile_renderer->tiles_x + k;
+			if (!bin_primitive(tile_renderer, arena, tile, primitive)) {
+				unbin_primitive(tile_renderer, primitive);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// ## FLUSH ## //
+void tile_renderer_flush(TileRenderer *tile_renderer) {
+	if (!tile_renderer) {
+		return;
+	}
+	tile_renderer->pixels_written = 0;
+	if (tile_renderer->active_count == 0) {
+		return;
+	}
+	
+	// Contiguous share of the active tiles per thread
+	int thread_count = tile_renderer->thread_count;
+	for (int i = 0; i < thread_count; i++) {
+		SDL_AtomicSet(&tile_renderer->queues[i].next, tile_renderer->active_count * i / thread_count);
+		tile_renderer->queues[i].end = tile_renderer->active_count * (i + 1) / thread_count;
+	}
+	
+	for (int i = 1; i < thread_count; i++) {
+		SDL_SemPost(tile_renderer->queues[i].start);
+	}
+	process_tiles(tile_renderer, 0);
+	for (int i = 1; i < thread_count; i++) {
+		SDL_SemWait(tile_renderer->done);
+	}
+	for (int i = 0; i < thread_count; i++) {
+		tile_renderer->pixels_written += tile_renderer->queues[i].pixels_written;
+	}
+	
+	for (int i = 0; i < tile_renderer->active_count; i++) {
+		TileBin *bin = &tile_renderer->bins[tile_renderer->active_tiles[i]];
+		bin->head = NULL;
+		bin->tail = NULL;
+	}
+	tile_renderer->active_count = 0;
+}
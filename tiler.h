@@ -0,0 +1,39 @@
+#ifndef TILER_H
+#define TILER_H
+
+#include "graphics.h"
+
+// ### CONSTANTS ### //
+#define TILE_SIZE 64
+
+// ### FUNCTION DECLARATIONS ### //
+// Targets are split into TILE_SIZE x TILE_SIZE tiles; draw calls only record
+// primitives into the bins of the tiles they touch, and tile_renderer_flush
+// rasterizes every tile on a worker pool. Each tile is owned by exactly one
+// worker while it is rasterized, so the targets need no locks, and each
+// tile replays its primitives in submission order, matching serial rendering.
+
+// # CREATE AND DESTROY FUNCTIONS # //
+// thread_count includes the calling thread, 0 uses every CPU
+TileRenderer *create_tile_renderer(int thread_count);
+void destroy_tile_renderer(TileRenderer **tile_renderer);
+
+// # BINNING # //
+// Primitives and bins are allocated from the arena, flush before resetting it
+// or resizing the target; several targets can be binned before one flush
+// depth_buffer may be NULL to draw without depth testing
+// Only pixels inside scissor are written, and only the tiles it touches are binned
+// A primitive is binned to all of its tiles or to none: when the arena runs out
+// partway, it is taken out of the bins again and false is returned, so it can be
+// added again after a flush
+bool tile_renderer_add_triangle(TileRenderer *tile_renderer, Arena *arena, RenderTarget *target, DepthBuffer *depth_buffer, ScreenRect scissor, const TriangleSetup *setup, Uint32 color);
+bool tile_renderer_add_line(TileRenderer *tile_renderer, Arena *arena, RenderTarget *target, DepthBuffer *depth_buffer, ScreenRect scissor, IVec2 p0, IVec2 p1, float z0, float z1, Uint32 color);
+
+// # RASTERIZATION # //
+// Rasterizes everything binned since the last flush and empties the bins
+void tile_renderer_flush(TileRenderer *tile_renderer);
+int tile_renderer_thread_count(TileRenderer *tile_renderer);
+// Pixels the last flush wrote
+long tile_renderer_pixels_written(TileRenderer *tile_renderer);
+
+#endif